@@ -0,0 +1,464 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          benchmark.h
+    Type:               header file
+    Short Description:  This file contains the benchmark of the reference operating points, with the
+                        check of their results.
+
+Description
+===========
+The benchmark file (benchmark.txt, run with "make benchmark" or "./solve -benchmark <file>") gives
+a list of reference operating points, each one as the input.txt file with some of its variables
+changed, and the reference values of its results, e.g.
+
+    point bolsig boltzmannSolver BOLSIG BOLSIG_cache none;
+    reference bolsig ne 4.1104e+18 1.0e-3;
+
+The points are solved one after the other, each one in its own thread with a clean state, like the
+points of a sweep (see sweep.h), so that the times are not disturbed by each other. For every point
+the time to solution, the outer iterations, the inner iterations of the balance and the energy
+equations and the BOLSIG+ runs are taken from the timers of profiler.h, and the results are checked
+against the reference values within their relative tolerances.
+
+A line for every point is appended to the history file, with the date, the counters, the status and
+the results, so that the performance of the code can be followed over time. A point whose time is
+larger than its best time in the history by more than timeTolerance is a performance regression.
+The benchmark fails (exit status 1) if a point does not converge, a solver gives a warning (e.g. a
+Newton solution that did not converge, even if the outer iterations did), a result is out of
+tolerance or a point is slower.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- readBenchmark                 void        Read the points, the reference values and the options of the benchmark file.
+- writeBenchmarkInput           void        Write the input file of a benchmark point.
+- benchmarkQuantity             double      Value of a result of the converged solution, by its name.
+- benchmarkWorker               void*       Solve a benchmark point in its own thread.
+- bestBenchmarkTime             double      Find the best time of a point in the history file.
+- runBenchmark                  int         Solve all the points, check their results and update the history file.
+
+---------------------------------------------------------------------------------------------  */
+
+#define MAXBENCHMARKVARIABLES 10
+#define MAXBENCHMARKREFERENCES 20
+
+// Reference operating point and its results
+typedef struct
+{
+    char name[MAXCHAR];
+    int NoVariables;
+    char variable[MAXBENCHMARKVARIABLES][MAXCHAR], value[MAXBENCHMARKVARIABLES][MAXCHAR];
+    int NoReferences;
+    char quantity[MAXBENCHMARKREFERENCES][MAXCHAR];
+    double reference[MAXBENCHMARKREFERENCES], tolerance[MAXBENCHMARKREFERENCES], actual[MAXBENCHMARKREFERENCES];
+
+    // Counters and status of the solution
+    double time;
+    int iterations, bolsigRuns, boltzmannCalls, status, warnings;
+    long balanceIterations, energyIterations;
+} benchmarkPoint;
+
+// Points of the benchmark, shared by the threads (each one writes only its own point), and options
+benchmarkPoint *benchmarkPoints;
+int NoBenchmarkPoints=0;
+char benchmarkHistory[MAXCHAR]="benchmarkHistory.dat";
+double benchmarkTimeTolerance=0.5;
+
+
+// --------------------------------------------------------------------------------------------------------
+// Read the points, the reference values and the options of the benchmark file. The syntax is the one of the
+// mechanism file: one statement per line, ending with a semicolon, with // and /* */ comments.
+// --------------------------------------------------------------------------------------------------------
+void readBenchmark (const char *filename)
+{
+    // Local variables
+    int l, capacity=8, line_number=0;
+    char line[4*MAXCHAR], *token, *end;
+    bool comment=false;
+    benchmarkPoint *point;
+    FILE *fp;
+
+    fp = fopen(filename,"r");
+    if (fp == NULL)
+    {
+        printf("Error: The file %s was not found!\n",filename);
+        exit(EXIT_FAILURE);
+    }
+
+    benchmarkPoints = (benchmarkPoint*) malloc(capacity*sizeof(benchmarkPoint));
+    NoBenchmarkPoints = 0;
+
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        line_number++;
+
+        // Block comments
+        if (comment)
+        {
+            if (strstr(line, "*/") != NULL)
+                comment = false;
+            continue;
+        }
+        if (strncmp(line, "/*", 2) == 0)
+        {
+            comment = (strstr(line+2, "*/") == NULL);
+            continue;
+        }
+
+        // Line comments and the end of the statement
+        if ((end = strstr(line, "//")) != NULL)
+            *end = '\0';
+        end = strchr(line, ';');
+        token = strtok(line, " \t\r\n;");
+        if (token == NULL)
+            continue;
+        if (end == NULL)
+        {
+            printf("Error: Missing semicolon in the line %d of the file: %s\n",line_number,filename);
+            exit(EXIT_FAILURE);
+        }
+        *end = '\0';
+
+        if (strcmp(token,"history") == 0 && (token = strtok(NULL, " \t\r\n")) != NULL)
+            snprintf(benchmarkHistory, MAXCHAR, "%s", token);
+        else if (strcmp(token,"timeTolerance") == 0 && (token = strtok(NULL, " \t\r\n")) != NULL)
+            benchmarkTimeTolerance = atof(token);
+        else if (strcmp(token,"point") == 0)
+        {
+            if (NoBenchmarkPoints == capacity)
+            {
+                capacity *= 2;
+                benchmarkPoints = (benchmarkPoint*) realloc(benchmarkPoints, capacity*sizeof(benchmarkPoint));
+            }
+            point = &benchmarkPoints[NoBenchmarkPoints];
+            point->NoVariables = point->NoReferences = 0;
+
+            token = strtok(NULL, " \t\r\n");
+            for (l=0 ; token!=NULL && l<NoBenchmarkPoints ; l++)
+                if (strcmp(token,benchmarkPoints[l].name) == 0)
+                    token = NULL;
+            if (token == NULL)
+            {
+                printf("Error: Missing or repeated point name in the line %d of the file: %s\n",line_number,filename);
+                exit(EXIT_FAILURE);
+            }
+            snprintf(point->name, MAXCHAR, "%s", token);
+
+            // Input variables of the point, in pairs of name and value
+            while ((token = strtok(NULL, " \t\r\n")) != NULL)
+            {
+                if (point->NoVariables == MAXBENCHMARKVARIABLES)
+                {
+                    printf("Error: More than %d variables of the point %s in the file: %s\n",MAXBENCHMARKVARIABLES,point->name,filename);
+                    exit(EXIT_FAILURE);
+                }
+                snprintf(point->variable[point->NoVariables], MAXCHAR, "%s", token);
+                if ((token = strtok(NULL, " \t\r\n")) == NULL)
+                {
+                    printf("Error: The variable %s of the point %s has no value in the file: %s\n",point->variable[point->NoVariables],point->name,filename);
+                    exit(EXIT_FAILURE);
+                }
+                snprintf(point->value[point->NoVariables], MAXCHAR, "%s", token);
+                point->NoVariables++;
+            }
+            NoBenchmarkPoints++;
+        }
+        else if (strcmp(token,"reference") == 0)
+        {
+            token = strtok(NULL, " \t\r\n");
+            for (l=0 ; token!=NULL && l<NoBenchmarkPoints ; l++)
+                if (strcmp(token,benchmarkPoints[l].name) == 0)
+                    break;
+            if (token == NULL || l == NoBenchmarkPoints)
+            {
+                printf("Error: The reference of the line %d must follow its point in the file: %s\n",line_number,filename);
+                exit(EXIT_FAILURE);
+            }
+            point = &benchmarkPoints[l];
+            if (point->NoReferences == MAXBENCHMARKREFERENCES)
+            {
+                printf("Error: More than %d reference values of the point %s in the file: %s\n",MAXBENCHMARKREFERENCES,point->name,filename);
+                exit(EXIT_FAILURE);
+            }
+
+            // Quantity, reference value and relative tolerance
+            token = strtok(NULL, " \t\r\n");
+            if (token != NULL)
+            {
+                snprintf(point->quantity[point->NoReferences], MAXCHAR, "%s", token);
+                token = strtok(NULL, " \t\r\n");
+            }
+            if (token != NULL)
+            {
+                point->reference[point->NoReferences] = atof(token);
+                token = strtok(NULL, " \t\r\n");
+            }
+            if (token == NULL)
+            {
+                printf("Error: The reference of the line %d needs a quantity, a value and a tolerance in the file: %s\n",line_number,filename);
+                exit(EXIT_FAILURE);
+            }
+            point->tolerance[point->NoReferences] = atof(token);
+            point->NoReferences++;
+        }
+        else
+        {
+            printf("Error: Unknown statement %s in the line %d of the file: %s\n",token,line_number,filename);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    fclose(fp);
+
+    if (NoBenchmarkPoints == 0)
+    {
+        printf("Error: There are no points in the file: %s\n",filename);
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write the input file of a benchmark point: a copy of input.txt where the lines of the variables of the point
+// are replaced by their values. The sweeps and the continuation are removed and the profile files are not
+// written, so the point is a single simulation.
+// --------------------------------------------------------------------------------------------------------
+void writeBenchmarkInput (const benchmarkPoint *point, const char *filename)
+{
+    // Local variables
+    char line[4*MAXCHAR], name[4*MAXCHAR];
+    int l;
+    bool found[MAXBENCHMARKVARIABLES]={false};
+    FILE *fp_in, *fp_out;
+
+    fp_in = fopen("input.txt","r");
+    fp_out = fopen(filename,"w");
+    if (fp_in == NULL || fp_out == NULL)
+    {
+        printf("Error: The input file of the benchmark point %s cannot be written!\n",point->name);
+        exit(EXIT_FAILURE);
+    }
+
+    while (fgets(line, sizeof(line), fp_in) != NULL)
+    {
+        if (sscanf(line, "%s", name) != 1 || strncmp(name,"//",2) == 0)
+        {
+            fputs(line, fp_out);
+            continue;
+        }
+
+        // The variable name may be followed directly by the semicolon
+        name[strcspn(name, ";")] = 0;
+        if (strcmp(name,"sweep") == 0 || strcmp(name,"continuation") == 0 || strncmp(name,"profile",7) == 0)
+            continue;
+
+        for (l=0 ; l<point->NoVariables ; l++)
+            if (strcmp(name,point->variable[l]) == 0)
+                break;
+        if (l < point->NoVariables)
+        {
+            fprintf(fp_out, "%s %s;\n", point->variable[l], point->value[l]);
+            found[l] = true;
+        }
+        else
+            fputs(line, fp_out);
+    }
+
+    // Variables of the point that are not in the input file
+    for (l=0 ; l<point->NoVariables ; l++)
+        if (!found[l])
+            fprintf(fp_out, "%s %s;\n", point->variable[l], point->value[l]);
+
+    fclose(fp_in);
+    fclose(fp_out);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Value of a result of the converged solution: Tg, Te, the outer iterations, or the density of a species of
+// the mechanism as "n" and its name (ne, nH, nH2+, nAr+, ...)
+// --------------------------------------------------------------------------------------------------------
+double benchmarkQuantity (const char *quantity)
+{
+    // Local variables
+    int s;
+
+    if (strcmp(quantity,"Tg") == 0)
+        return Tg;
+    if (strcmp(quantity,"Te") == 0)
+        return Te;
+    if (strcmp(quantity,"iterations") == 0)
+        return count;
+    if (quantity[0] == 'n' && (s = findSpecies(quantity+1)) >= 0)
+        return speciesDensity[s];
+
+    printf("Error: Unknown result %s of the benchmark (Tg, Te, iterations, or n and a species of the mechanism)\n",quantity);
+    exit(EXIT_FAILURE);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve a benchmark point in its own thread, which starts from a clean state, and store its counters, the
+// number of its warnings and the results that have reference values
+// --------------------------------------------------------------------------------------------------------
+void *benchmarkWorker (void *arg)
+{
+    // Local variables
+    int l, index = *(int*) arg;
+    double start;
+    char filename[MAXCHAR];
+    benchmarkPoint *point = &benchmarkPoints[index];
+
+    workerId = index+1;
+    printScreenOutput = false;
+
+    // Read the input file of the point
+    sprintf(filename, "benchmark%d_input.txt", index);
+    writeBenchmarkInput(point, filename);
+    readfile(filename);
+    remove(filename);
+
+    // The timers of the profiler count the iterations and the BOLSIG+ runs, without writing their files
+    profileCounters = true;
+    start = profileClock();
+    initializeSimulation();
+    runSimulation();
+    point->time = profileClock() - start;
+
+    point->iterations = count;
+    point->status = solverFailed ? SOLUTION_FAILED : convergenceStatus;
+    point->warnings = warningCount;
+    point->balanceIterations = profilePhases[PROFILE_BALANCE].iterations;
+    point->energyIterations = profilePhases[PROFILE_ENERGY].iterations;
+    point->bolsigRuns = profilePhases[PROFILE_BOLSIG_RUN].calls;
+    point->boltzmannCalls = profilePhases[PROFILE_TWOTERM].calls + profilePhases[PROFILE_TABLE].calls + profilePhases[PROFILE_BOLSIG_INPUT].calls;
+    for (l=0 ; l<point->NoReferences ; l++)
+        point->actual[l] = benchmarkQuantity(point->quantity[l]);
+
+    finalizeSimulation();
+
+    return NULL;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Find the best (smallest) time of a point in the history file. Returns 0 if the point is not in the history.
+// --------------------------------------------------------------------------------------------------------
+double bestBenchmarkTime (const char *name)
+{
+    // Local variables
+    char line[8*MAXCHAR], date[MAXCHAR], point[MAXCHAR];
+    double time, best=0.0;
+    FILE *fp;
+
+    fp = fopen(benchmarkHistory,"r");
+    if (fp == NULL)
+        return 0.0;
+
+    while (fgets(line, sizeof(line), fp) != NULL)
+        if (line[0] != '#' && sscanf(line, "%s %s %lf", date, point, &time) == 3 && strcmp(point,name) == 0 && time > 0.0)
+            if (best == 0.0 || time < best)
+                best = time;
+
+    fclose(fp);
+    return best;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve all the points of the benchmark file one after the other, check their results against the reference
+// values, compare their times with the history and append them to it. Returns the number of failed points.
+// --------------------------------------------------------------------------------------------------------
+int runBenchmark (const char *filename)
+{
+    // Local variables
+    int l, m, failures=0;
+    double best, error, total=0.0;
+    bool failed, slow;
+    char date[MAXCHAR];
+    const char *status;
+    time_t now = time(NULL);
+    pthread_t thread_id;
+    FILE *fp;
+
+    readBenchmark(filename);
+    strftime(date, MAXCHAR, "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    printf("Benchmark: %d points of the file %s\n\n", NoBenchmarkPoints, filename);
+    printf("%-16s %10s %6s %8s %8s %8s %8s   %s\n", "Point", "Time (s)", "Outer", "Balance", "Energy", "Boltz.", "BOLSIG+", "Status");
+
+    fp = fopen(benchmarkHistory,"a");
+    if (fp == NULL)
+    {
+        printf("Error: The file %s cannot be written!\n",benchmarkHistory);
+        exit(EXIT_FAILURE);
+    }
+    if (ftell(fp) == 0)
+        fprintf(fp, "# date\tpoint\ttime\titerations\tbalanceIterations\tenergyIterations\tboltzmannCalls\tbolsigRuns\tstatus\tresults\n");
+
+    for (l=0 ; l<NoBenchmarkPoints ; l++)
+    {
+        // The best time of the history is found before the new time is appended
+        best = bestBenchmarkTime(benchmarkPoints[l].name);
+
+        if (pthread_create(&thread_id, NULL, benchmarkWorker, &l) != 0)
+        {
+            printf("Error: The thread of the benchmark point %s cannot be created!\n",benchmarkPoints[l].name);
+            exit(EXIT_FAILURE);
+        }
+        pthread_join(thread_id, NULL);
+
+        // Check the results and the time
+        failed = (benchmarkPoints[l].status != SOLUTION_CONVERGED || benchmarkPoints[l].warnings > 0);
+        for (m=0 ; m<benchmarkPoints[l].NoReferences ; m++)
+            if (!(relativeError(benchmarkPoints[l].actual[m], benchmarkPoints[l].reference[m]) <= benchmarkPoints[l].tolerance[m]))
+                failed = true;
+        slow = (best > 0.0 && benchmarkTimeTolerance > 0.0 && benchmarkPoints[l].time > (1.0+benchmarkTimeTolerance)*best);
+        status = failed ? "FAIL" : (slow ? "SLOW" : "PASS");
+        if (failed || slow)
+            failures++;
+        total += benchmarkPoints[l].time;
+
+        printf("%-16s %10.3f %6d %8ld %8ld %8d %8d   %s", benchmarkPoints[l].name, benchmarkPoints[l].time, benchmarkPoints[l].iterations,
+               benchmarkPoints[l].balanceIterations, benchmarkPoints[l].energyIterations, benchmarkPoints[l].boltzmannCalls, benchmarkPoints[l].bolsigRuns, status);
+        if (best > 0.0)
+            printf(" (best %.3f s)", best);
+        printf("\n");
+        if (benchmarkPoints[l].status != SOLUTION_CONVERGED)
+            printf("    the solution %s\n", convergenceStatusName(benchmarkPoints[l].status));
+        if (benchmarkPoints[l].warnings > 0)
+            printf("    %d warnings during the solution\n", benchmarkPoints[l].warnings);
+        for (m=0 ; m<benchmarkPoints[l].NoReferences ; m++)
+        {
+            error = relativeError(benchmarkPoints[l].actual[m], benchmarkPoints[l].reference[m]);
+            if (!(error <= benchmarkPoints[l].tolerance[m]))
+                printf("    %s=%.4e reference=%.4e error=%.2e tolerance=%.1e\n", benchmarkPoints[l].quantity[m], benchmarkPoints[l].actual[m],
+                       benchmarkPoints[l].reference[m], error, benchmarkPoints[l].tolerance[m]);
+        }
+
+        // History of the point
+        fprintf(fp, "%s\t%s\t%.4f\t%d\t%ld\t%ld\t%d\t%d\t%s\t", date, benchmarkPoints[l].name, benchmarkPoints[l].time, benchmarkPoints[l].iterations,
+                benchmarkPoints[l].balanceIterations, benchmarkPoints[l].energyIterations, benchmarkPoints[l].boltzmannCalls, benchmarkPoints[l].bolsigRuns, status);
+        for (m=0 ; m<benchmarkPoints[l].NoReferences ; m++)
+            fprintf(fp, "%s%s=%.6e", m > 0 ? " " : "", benchmarkPoints[l].quantity[m], benchmarkPoints[l].actual[m]);
+        fprintf(fp, "\n");
+        fflush(fp);
+    }
+
+    fclose(fp);
+    free(benchmarkPoints);
+
+    printf("\nTotal time %.3f s, %d of %d points failed. The results were appended to the file: %s\n", total, failures, NoBenchmarkPoints, benchmarkHistory);
+
+    return failures;
+}
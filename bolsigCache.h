@@ -0,0 +1,239 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          bolsigCache.h
+    Type:               header file
+    Short Description:  This file contains the persistent on-disk cache of the BOLSIG+ results.
+
+Description
+===========
+BOLSIG+ is deterministic: its output only depends on the conditions of the input file and on the
+cross sections. The conditions are written by writeBOLSIGinput with a fixed number of digits, so
+they are already quantized, and every BOLSIG+ output file is stored in the cache directory under a
+64-bit FNV-1a hash of the input file (without the lines of the file names) and of the cross-section
+file, so the species, the options and the conditions are all part of the key. When the same input
+appears again, in the same or in another run, the stored file is copied to the BOLSIG+ output file
+instead of running BOLSIG+.
+
+The cache can be shared by many processes (and the threads of a sweep) at the same time. A new
+entry is first written to a temporary file with a unique name (process id and sweep point) and
+is then renamed to its final name. The rename is atomic, so a reader sees either a complete entry
+or no entry at all, and two processes that store the same entry simply replace one complete file
+with another identical one. A temporary file that was not written completely (e.g. on a full disk)
+is removed instead of renamed, so a truncated entry is never stored.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- hashBytes                     uint64_t    Update a 64-bit FNV-1a hash with a block of bytes.
+- hashFile                      uint64_t    Update a 64-bit FNV-1a hash with the contents of a file.
+- bolsigCacheKey                void        Calculate the cache key of the current BOLSIG+ input file.
+- copyFile                      int         Copy a file to another file.
+- bolsigCacheLoad               bool        Copy the cached BOLSIG+ output for the current input file, if any.
+- bolsigCacheStore              void        Store the BOLSIG+ output file in the cache.
+
+---------------------------------------------------------------------------------------------  */
+
+#define FNVoffsetBasis 14695981039346656037ULL
+#define FNVprime 1099511628211ULL
+
+// Length of the cache key (16 hexadecimal digits) with the terminating null character, and of the paths of the
+// entries (the cache directory, the key and the suffix of the temporary files)
+#define BOLSIGCACHEKEY 17
+#define BOLSIGCACHEPATH (MAXCHAR+BOLSIGCACHEKEY+48)
+
+// Hash of the cross-section file, calculated once, and statistics of the cache
+THREAD_LOCAL bool useCache=false, cacheMiss=false;
+THREAD_LOCAL uint64_t crossSectionsHash=0;
+THREAD_LOCAL int count_cacheHits=0, count_cacheMisses=0;
+
+
+// --------------------------------------------------------------------------------------------------------
+// Update the 64-bit FNV-1a hash with a block of bytes
+// --------------------------------------------------------------------------------------------------------
+uint64_t hashBytes (uint64_t hash, const char *bytes, size_t size)
+{
+    // Local variables
+    size_t l;
+
+    for (l=0 ; l<size ; l++)
+    {
+        hash ^= (unsigned char) bytes[l];
+        hash *= FNVprime;
+    }
+
+    return hash;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Update the 64-bit FNV-1a hash with the contents of a file
+// --------------------------------------------------------------------------------------------------------
+uint64_t hashFile (uint64_t hash, const char *filename)
+{
+    // Local variables
+    char buffer[4096];
+    size_t size;
+
+    // Open file
+    FILE * fp;
+    fp = fopen(filename,"rb");
+
+    // Checκ if file exists
+    if (fp==NULL)
+    {
+        printf("Error: The file %s was not found!\n",filename);
+        exit(EXIT_FAILURE);
+    }
+
+    while ((size = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+        hash = hashBytes(hash, buffer, size);
+
+    // Close file
+    fclose(fp);
+
+    return hash;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the cache key of the current BOLSIG+ input file, i.e. the hash of all its lines, except the
+// lines of the file names (the cross-section and the output files, which end with "/ File"), and of the
+// cross-section file. The file names are not part of the key, so the entries are shared by runs with
+// different BOLSIG+ file names.
+// --------------------------------------------------------------------------------------------------------
+void bolsigCacheKey (char key[BOLSIGCACHEKEY])
+{
+    // Local variables
+    char line[16*MAXCHAR];
+    uint64_t hash;
+
+    if (crossSectionsHash == 0)
+        crossSectionsHash = hashFile(FNVoffsetBasis, BOLSIG_crossSections);
+    hash = crossSectionsHash;
+
+    // Open file
+    FILE * fp;
+    fp = fopen(BOLSIG_input,"r");
+
+    // Checκ if file exists
+    if (fp==NULL)
+    {
+        printf("Error: The file %s was not found!\n",BOLSIG_input);
+        exit(EXIT_FAILURE);
+    }
+
+    while (fgets(line, sizeof(line), fp) != NULL)
+        if (strstr(line,"/ File") == NULL)
+            hash = hashBytes(hash, line, strlen(line));
+
+    // Close file
+    fclose(fp);
+
+    snprintf(key, BOLSIGCACHEKEY, "%016llx", (unsigned long long) hash);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Copy the file source to the file destination. Returns 0 on success and 1 if a file cannot be opened, read or
+// written completely, in which case the destination is removed.
+// --------------------------------------------------------------------------------------------------------
+int copyFile (const char *source, const char *destination)
+{
+    // Local variables
+    char buffer[4096];
+    size_t size;
+    bool failed=false;
+    FILE *fp_in, *fp_out;
+
+    fp_in = fopen(source,"rb");
+    if (fp_in == NULL)
+        return 1;
+
+    fp_out = fopen(destination,"wb");
+    if (fp_out == NULL)
+    {
+        fclose(fp_in);
+        return 1;
+    }
+
+    while (!failed && (size = fread(buffer, 1, sizeof(buffer), fp_in)) > 0)
+        failed = (fwrite(buffer, 1, size, fp_out) != size);
+    if (ferror(fp_in))
+        failed = true;
+
+    fclose(fp_in);
+    if (fclose(fp_out) != 0)
+        failed = true;
+
+    if (failed)
+    {
+        remove(destination);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// If the cache contains the results of the current BOLSIG+ input file, copy them to the BOLSIG+ output
+// file and return true. Otherwise return false, and BOLSIG+ must be run.
+// --------------------------------------------------------------------------------------------------------
+bool bolsigCacheLoad ()
+{
+    // Local variables
+    char key[BOLSIGCACHEKEY], entry[BOLSIGCACHEPATH];
+
+    bolsigCacheKey(key);
+    snprintf(entry, sizeof(entry), "%s/%s.dat", BOLSIG_cache, key);
+
+    if (copyFile(entry, BOLSIG_output) == 0)
+    {
+        count_cacheHits++;
+        return true;
+    }
+
+    count_cacheMisses++;
+    return false;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Store the BOLSIG+ output file in the cache, under the key of the current BOLSIG+ input file. The entry
+// is written to a temporary file, which is renamed atomically to its final name. Only the results that
+// passed the checks of readBOLSIGoutput are stored.
+// --------------------------------------------------------------------------------------------------------
+void bolsigCacheStore ()
+{
+    // Local variables
+    char key[BOLSIGCACHEKEY], entry[BOLSIGCACHEPATH], entry_tmp[BOLSIGCACHEPATH];
+
+    bolsigCacheKey(key);
+    snprintf(entry, sizeof(entry), "%s/%s.dat", BOLSIG_cache, key);
+    snprintf(entry_tmp, sizeof(entry_tmp), "%s/%s.tmp.%ld.%d", BOLSIG_cache, key, (long) getpid(), workerId);
+
+    // Create the cache directory, if it does not exist
+    #ifdef _WIN32
+        mkdir(BOLSIG_cache);
+    #else
+        mkdir(BOLSIG_cache, 0755);
+    #endif
+
+    if (copyFile(BOLSIG_output, entry_tmp) != 0)
+    {
+        logMessage(LOG_WARNING, "Warning: The BOLSIG+ results could not be stored in the cache directory %s\n", BOLSIG_cache);
+        return;
+    }
+    if (rename(entry_tmp, entry) != 0)
+        remove(entry_tmp);
+}
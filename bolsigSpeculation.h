@@ -0,0 +1,293 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          bolsigSpeculation.h
+    Type:               header file
+    Short Description:  This file contains the speculative BOLSIG+ runs, which are overlapped with
+                        the outer iterations.
+
+Description
+===========
+The outer iterations are serial: the BOLSIG+ run of an iteration needs the densities and the gas
+temperature of the same iteration. When BOLSIG_speculation is not zero, the BOLSIG+ runs of the
+next BOLSIG_speculationDepth iterations are started in the background, each in its own scratch
+directory (see scratch.h), with the densities and the gas temperature extrapolated linearly from
+the last two iterations. When an iteration needs BOLSIG+, the speculative run whose conditions
+are closest to the actual conditions is used, if the relative differences of E/N, Tg, ionization
+degree, ion/neutral mass ratio and hydrogen fraction are all within BOLSIG_speculation. Otherwise
+the speculative runs are stopped, BOLSIG+ is run for the actual conditions and new speculative
+runs are started from them at the same time.
+
+Near convergence the changes between the iterations become small and the predictions are used,
+so up to BOLSIG_speculationDepth+1 BOLSIG+ runs are running at the same time. Since the speculative
+results are used only when the predicted conditions converge to the actual ones, the converged
+solution does not depend on the tolerance. The speculative runs need idle cores, so they are
+disabled on a single processor, and they are not available on Windows, where BOLSIG+ runs through
+the shell.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- bolsigConditions              void        Calculate the conditions of BOLSIG+ that are compared.
+- initializeSpeculativeBOLSIG   void        Create the scratch directories of the speculative runs.
+- cancelSpeculativeBOLSIG       void        Stop the speculative runs and forget the previous iterations.
+- finalizeSpeculativeBOLSIG     void        Stop the speculative runs and remove their scratch directories.
+- acceptSpeculativeBOLSIG       bool        Read the results of a speculative run that matches the actual conditions.
+- launchSpeculativeBOLSIG       void        Start the speculative runs of the next iterations.
+
+---------------------------------------------------------------------------------------------  */
+
+// Conditions of BOLSIG+ that are compared: E/N, Tg, ionization degree, ion/neutral mass ratio, H fraction
+#define NoSpeculationConditions 5
+
+// Variables of the extrapolation: nH, nH+, nH2+, nH3+, Tg. The other unknowns of the mechanism keep their
+// current densities.
+#define NoSpeculationVariables 5
+
+typedef struct
+{
+    pid_t pid;                                      // BOLSIG+ process (0 = no run)
+    int target;                                     // Call of solveElectronKinetics that the run predicts
+    double conditions[NoSpeculationConditions];     // Predicted conditions
+    char directory[MAXCHAR];                        // Scratch directory of the run
+} speculativeRun;
+
+THREAD_LOCAL speculativeRun speculativeRuns[MAXSPECULATIONDEPTH];
+THREAD_LOCAL double speculationPrevious[NoSpeculationVariables];
+THREAD_LOCAL int count_speculationCalls=0, count_speculationRuns=0, count_speculationHits=0;
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the conditions of the BOLSIG+ input file that are compared, from the current densities and gas
+// temperature (see writeBOLSIGinput)
+// --------------------------------------------------------------------------------------------------------
+void bolsigConditions (double conditions[NoSpeculationConditions])
+{
+    conditions[0] = Vm2toTd*E/nNeutral;
+    conditions[1] = Tg;
+    conditions[2] = fabs(ne/nNeutral);
+    conditions[3] = ((nHplus+nH2plus+nH3plus)/(nHplus/mH+nH2plus/mH2+nH3plus/mH3))*((nH/n)/mH+(nH2/n)/mH2);
+    conditions[4] = nH/(nH+nH2);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Create the scratch directories of the speculative runs, after the scratch directory of the thread
+// --------------------------------------------------------------------------------------------------------
+void initializeSpeculativeBOLSIG ()
+{
+    // Local variables
+    int l;
+
+    #ifdef _WIN32
+        BOLSIG_speculation = 0.0;
+    #endif
+
+    // The speculative runs only compete with the actual run, if there is no idle core
+    count_speculationCalls = count_speculationRuns = count_speculationHits = 0;
+    if (BOLSIG_speculation > 0.0 && sysconf(_SC_NPROCESSORS_ONLN) < 2)
+    {
+        if (printScreenOutput)
+            logMessage(LOG_WARNING, "Warning: The speculative BOLSIG+ runs are disabled, since there is only one processor.\n");
+        BOLSIG_speculation = 0.0;
+    }
+    if (BOLSIG_speculation <= 0.0)
+        return;
+
+    for (l=0 ; l<BOLSIG_speculationDepth ; l++)
+    {
+        speculativeRuns[l].pid = 0;
+        makeScratchDirectory(speculativeRuns[l].directory);
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Stop the speculative runs and forget the previous iterations, when a new solution starts
+// --------------------------------------------------------------------------------------------------------
+void cancelSpeculativeBOLSIG ()
+{
+    // Local variables
+    int l;
+
+    if (BOLSIG_speculation <= 0.0)
+        return;
+
+    for (l=0 ; l<BOLSIG_speculationDepth ; l++)
+    {
+        stopBOLSIG(speculativeRuns[l].pid);
+        speculativeRuns[l].pid = 0;
+    }
+    count_speculationCalls = 0;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Stop the speculative runs and remove their scratch directories
+// --------------------------------------------------------------------------------------------------------
+void finalizeSpeculativeBOLSIG ()
+{
+    // Local variables
+    int l;
+
+    cancelSpeculativeBOLSIG();
+    if (BOLSIG_speculation <= 0.0)
+        return;
+
+    for (l=0 ; l<BOLSIG_speculationDepth ; l++)
+        deleteScratchDirectory(speculativeRuns[l].directory);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Look for a speculative run whose predicted conditions match the actual conditions within the tolerance.
+// If there is one, wait for it, read its results and return true. The runs that predicted this or an earlier
+// call are stopped. If no run matches, or its output file is not complete, all the runs are stopped, since
+// they were started from the same (wrong) extrapolation, and BOLSIG+ is run for the actual conditions.
+// --------------------------------------------------------------------------------------------------------
+bool acceptSpeculativeBOLSIG (bolsigResults *results)
+{
+    // Local variables
+    int l, m, best=-1;
+    double actual[NoSpeculationConditions], difference, bestDifference=BOLSIG_speculation;
+    char output[MAXCHAR];
+    bool accepted=false;
+
+    count_speculationCalls++;
+
+    bolsigConditions(actual);
+    for (l=0 ; l<BOLSIG_speculationDepth ; l++)
+    {
+        if (speculativeRuns[l].pid <= 0)
+            continue;
+
+        difference = 0.0;
+        for (m=0 ; m<NoSpeculationConditions ; m++)
+            difference = fmax(difference, relativeError(actual[m], speculativeRuns[l].conditions[m]));
+        if (difference <= bestDifference)
+        {
+            bestDifference = difference;
+            best = l;
+        }
+    }
+
+    // Read the results of the best run, if it finished normally
+    if (best >= 0)
+    {
+        accepted = waitBOLSIG(speculativeRuns[best].pid);
+        speculativeRuns[best].pid = 0;
+
+        // A truncated or bad output file is not an error, the actual conditions are run instead
+        if (accepted && snprintf(output, sizeof(output), "%s/%s", speculativeRuns[best].directory, fileName(BOLSIG_output)) < (int) sizeof(output))
+            accepted = readBOLSIGoutput(output, results, false);
+        else
+            accepted = false;
+        if (accepted)
+            count_speculationHits++;
+    }
+
+    // Stop the runs that are not needed any more
+    for (l=0 ; l<BOLSIG_speculationDepth ; l++)
+        if (speculativeRuns[l].pid > 0 && (!accepted || speculativeRuns[l].target <= count_speculationCalls))
+        {
+            stopBOLSIG(speculativeRuns[l].pid);
+            speculativeRuns[l].pid = 0;
+        }
+
+    return accepted;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Start the speculative runs of the next calls that have no run yet. The densities and the gas temperature
+// of each call are extrapolated linearly from the current and the previous call, and the BOLSIG+ input file
+// is written for them in the scratch directory of the run.
+// --------------------------------------------------------------------------------------------------------
+void launchSpeculativeBOLSIG ()
+{
+    // Local variables
+    int l, m, step;
+    double x[NoSpeculationVariables] = {nH, nHplus, nH2plus, nH3plus, Tg};
+    double x_pred[NoSpeculationVariables];
+    char input[MAXCHAR], output[MAXCHAR], savedInput[MAXCHAR], savedOutput[MAXCHAR];
+    bool valid, running;
+
+    // The first call has no previous call to extrapolate from
+    if (count_speculationCalls > 1)
+    {
+        strcpy(savedInput, BOLSIG_input);
+        strcpy(savedOutput, BOLSIG_output);
+
+        for (step=1 ; step<=BOLSIG_speculationDepth ; step++)
+        {
+            // Skip the calls that have a run already
+            running = false;
+            for (l=0 ; l<BOLSIG_speculationDepth ; l++)
+                if (speculativeRuns[l].pid > 0 && speculativeRuns[l].target == count_speculationCalls+step)
+                    running = true;
+            if (running)
+                continue;
+
+            // Predicted state, which must be physical
+            valid = true;
+            for (m=0 ; m<NoSpeculationVariables ; m++)
+            {
+                x_pred[m] = x[m] + step*(x[m] - speculationPrevious[m]);
+                if (!isfinite(x_pred[m]) || x_pred[m] <= 0.0)
+                    valid = false;
+            }
+            if (!valid)
+                break;
+
+            nH = x_pred[0];
+            nHplus = x_pred[1];
+            nH2plus = x_pred[2];
+            nH3plus = x_pred[3];
+            Tg = x_pred[4];
+            updateClosureDensities();
+            if (nH2 <= 0.0)
+                break;
+
+            // Free scratch directory
+            for (l=0 ; l<BOLSIG_speculationDepth ; l++)
+                if (speculativeRuns[l].pid <= 0)
+                    break;
+
+            if (snprintf(input, sizeof(input), "%s/%s", speculativeRuns[l].directory, fileName(savedInput)) >= (int) sizeof(input) ||
+                snprintf(output, sizeof(output), "%s/%s", speculativeRuns[l].directory, fileName(savedOutput)) >= (int) sizeof(output))
+                break;
+            strcpy(BOLSIG_input, input);
+            strcpy(BOLSIG_output, output);
+            remove(output);
+            writeBOLSIGinput();
+
+            bolsigConditions(speculativeRuns[l].conditions);
+            speculativeRuns[l].target = count_speculationCalls+step;
+            speculativeRuns[l].pid = startBOLSIG(speculativeRuns[l].directory, input);
+            if (speculativeRuns[l].pid > 0)
+                count_speculationRuns++;
+        }
+
+        // Restore the actual state
+        nH = x[0];
+        nHplus = x[1];
+        nH2plus = x[2];
+        nH3plus = x[3];
+        Tg = x[4];
+        updateClosureDensities();
+        strcpy(BOLSIG_input, savedInput);
+        strcpy(BOLSIG_output, savedOutput);
+    }
+
+    for (m=0 ; m<NoSpeculationVariables ; m++)
+        speculationPrevious[m] = x[m];
+}
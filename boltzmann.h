@@ -0,0 +1,452 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          boltzmann.h
+    Type:               header file
+    Short Description:  This file contains the in-process two-term Boltzmann solver, which
+                        calculates the same quantities as BOLSIG+ without running it.
+
+Description
+===========
+The electron energy distribution function (EEDF) is calculated with the two-term approximation
+of the Boltzmann equation, with the cross sections of the reaction index that readCrossSections
+(see functions.h) builds at startup, following the formulation of Hagelaar and Pitchford [1] that BOLSIG+
+also uses. The EEDF F(eps) is normalized so that the integral of eps^(1/2)*F is unity, and it
+satisfies the steady state equation
+
+    d/d(eps) [ W*F - D*dF/d(eps) ] = S
+
+where W and D are the cooling and heating coefficients of the elastic collisions, the electric
+field and the electron-electron collisions, and S contains the inelastic collisions and the
+temporal growth of the electron density by ionization. The equation is discretized with the
+exponential (Scharfetter-Gummel) scheme on a uniform grid, and the inelastic terms are integrated
+exactly for the piecewise linear cross sections, so that the number of electrons is conserved.
+
+[1] G. J. M. Hagelaar and L. C. Pitchford. "Solving the Boltzmann equation to obtain electron
+    transport coefficients and rate coefficients for fluid models". In: Plasma Sources Science
+    and Technology 14.4 (2005), pp. 722-733. doi: 10.1088/0963-0252/14/4/011 .
+
+Function name                   Type        Description
+=============                   ====        ===========
+- crossSection                  double      Interpolate the cross section of a collision process.
+- crossSectionMoment            double      Integrate eps*sigma(eps) of a collision process between two energies.
+- snapMaxEnergy                 double      Round a maximum energy of the grid to the fixed ladder of energies.
+- bernoulli                     double      Bernoulli function of the exponential scheme.
+- twoTermBoltzmann              double      Solve the two-term Boltzmann equation and calculate the rate coefficients.
+- solveBoltzmann                double      Solve the two-term Boltzmann equation for the current plasma state.
+- compareBoltzmann              void        Compare the two-term Boltzmann solver with the BOLSIG+ results.
+
+---------------------------------------------------------------------------------------------  */
+
+// Number of cells of the energy grid
+#define EEDFgridPoints 200
+
+// Solution of the previous call, used as initial guess of the next one
+THREAD_LOCAL double *EEDF_previous, EEDFmaxEnergy=0.0;
+
+// The maximum energy of the grid is one of the energies EEDFbaseEnergy*2^(k/EEDFenergySteps), so that the
+// grid of an operating point does not depend on the previous calls
+#define EEDFbaseEnergy 60.0
+#define EEDFenergySteps 8
+
+// Keep the maximum energy of the previous call in a wider range of the EEDF decay, so that the rate
+// coefficients are smooth functions of the plasma state (see continuation.h)
+THREAD_LOCAL bool EEDFfixedGrid=false;
+
+
+// --------------------------------------------------------------------------------------------------------
+// Cross section of a collision process at the energy eps (eV). The table is interpolated linearly and
+// extrapolated with constant values, and the cross section is zero below the threshold energy. If the
+// table starts above the threshold, the cross section rises linearly from zero at the threshold.
+// --------------------------------------------------------------------------------------------------------
+double crossSection (const collisionProcess *process, double eps)
+{
+    // Local variables
+    int l;
+
+    if ((strcmp(process->type,"EXCITATION") == 0 || strcmp(process->type,"IONIZATION") == 0) && eps < process->param)
+        return 0.0;
+    if (eps <= process->energy[0])
+    {
+        if (process->param > 0.0 && process->energy[0] > process->param && (strcmp(process->type,"EXCITATION") == 0 || strcmp(process->type,"IONIZATION") == 0))
+            return process->crossSec[0]*(eps-process->param)/(process->energy[0]-process->param);
+        return process->crossSec[0];
+    }
+    if (eps >= process->energy[process->points-1])
+        return process->crossSec[process->points-1];
+
+    for (l=1 ; process->energy[l] < eps ; l++);
+
+    return process->crossSec[l-1] + (process->crossSec[l]-process->crossSec[l-1])*(eps-process->energy[l-1])/(process->energy[l]-process->energy[l-1]);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Integral of eps*sigma(eps) from eps=a to eps=b. The cross section is linear between the points of the
+// table (and the threshold energy), so the integral is calculated exactly piece by piece.
+// --------------------------------------------------------------------------------------------------------
+double crossSectionMoment (const collisionProcess *process, double a, double b)
+{
+    // Local variables
+    int l;
+    double integral=0.0, e0, e1, s0, s1, slope;
+
+    if ((strcmp(process->type,"EXCITATION") == 0 || strcmp(process->type,"IONIZATION") == 0) && a < process->param)
+        a = process->param;
+    if (b <= a)
+        return 0.0;
+
+    // Walk through the linear pieces of the cross section that overlap [a,b]
+    e0 = a;
+    l = 0;
+    while (e0 < b)
+    {
+        while (l < process->points && process->energy[l] <= e0)
+            l++;
+        e1 = (l < process->points) ? fmin(process->energy[l], b) : b;
+
+        s0 = crossSection(process, e0);
+        s1 = crossSection(process, e1);
+        slope = (e1 > e0) ? (s1-s0)/(e1-e0) : 0.0;
+
+        // Integral of eps*(s0 + slope*(eps-e0)) from e0 to e1
+        integral += (s0 - slope*e0)*(e1*e1 - e0*e0)/2.0 + slope*(e1*e1*e1 - e0*e0*e0)/3.0;
+        e0 = e1;
+    }
+
+    return integral;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Round a maximum energy of the grid to the nearest energy of the fixed geometric ladder
+// --------------------------------------------------------------------------------------------------------
+double snapMaxEnergy (double epsMax)
+{
+    return EEDFbaseEnergy*pow(2.0, round(EEDFenergySteps*log2(epsMax/EEDFbaseEnergy))/EEDFenergySteps);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Bernoulli function z/(exp(z)-1) of the exponential scheme
+// --------------------------------------------------------------------------------------------------------
+double bernoulli (double z)
+{
+    if (fabs(z) < 1.0e-6)
+        return 1.0 - 0.5*z;
+    return z/expm1(z);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the two-term Boltzmann equation for the conditions that are written in the BOLSIG+ input file
+// (reduced field EN in V m2, angular frequency over density WN in m3/s, gas temperature, ionization degree,
+// electron density and mole fractions of the neutral species). The rate coefficients and the threshold
+// energies of all the processes are stored in the K_local and Ethr_local arrays, and the electron
+// temperature is returned. The maximum energy of the grid is adapted so that the EEDF decays by about
+// ten orders of magnitude, as in BOLSIG+: it is the energy of the ladder (see snapMaxEnergy) that is
+// nearest to this decay, whatever the maximum energy of the previous call. On a two-cycle between two
+// energies of the ladder, the higher one is used.
+// --------------------------------------------------------------------------------------------------------
+double twoTermBoltzmann (double EN, double WN, double Tgas, double ionDegree, double ne_local, const double *fractions, double **K_local, double **Ethr_local)
+{
+    // Local variables
+    const int NG = EEDFgridPoints;
+    const double gamma = sqrt(2.0*e/me);
+    int i, j, l, iter, trial;
+    double F[NG], F_new[NG], eps_b[NG+1], W[NG+1], D[NG+1], Cee_W[NG+1], Cee_D[NG+1], sigmaM_b[NG+1];
+    double A1, A2, A3, sigma_m, sigma_e, sigma_t, q, Tgas_eV, lnLambda, a_ee, z, Wb, Db;
+    double dEps, epsMax, epsNew, epsPrevious=0.0, nu_growth, meanEnergy, err, ratio, lo, hi, overlap, factor, shift;
+    bool lastTrial=false;
+    double (*A)[NG] = malloc(sizeof(double[NG][NG]));
+    double (*Cinel)[NG] = malloc(sizeof(double[NG][NG]));
+    collisionProcess *process;
+
+    Tgas_eV = kB*Tgas/e;
+
+    // Initial maximum energy and EEDF from the previous call, otherwise a Maxwellian of 5 eV
+    epsMax = snapMaxEnergy((EEDFmaxEnergy > 0.0) ? EEDFmaxEnergy : EEDFbaseEnergy);
+    if (EEDF_previous == NULL)
+    {
+        EEDF_previous = (double*) calloc(NG, sizeof(double));
+        for (i=0 ; i<NG ; i++)
+            EEDF_previous[i] = exp(-(i+0.5)*epsMax/NG/(2.0/3.0*5.0));
+    }
+    for (i=0 ; i<NG ; i++)
+        F[i] = EEDF_previous[i];
+
+    nu_growth = 0.0;
+    meanEnergy = 0.0;
+    for (trial=0 ; trial<10 ; trial++)
+    {
+        dEps = epsMax/NG;
+        for (i=0 ; i<=NG ; i++)
+            eps_b[i] = i*dEps;
+
+        // Inelastic collision operator: losses in cell i and gains in cell i from the cells j above it
+        for (i=0 ; i<NG ; i++)
+            for (j=0 ; j<NG ; j++)
+                Cinel[i][j] = 0.0;
+        for (l=0 ; l<NoCollisions ; l++)
+        {
+            process = &collisions[l];
+            if (strcmp(process->type,"ELASTIC") == 0 || strcmp(process->type,"EFFECTIVE") == 0)
+                continue;
+
+            // Equal energy sharing of the primary and secondary electrons of the ionization
+            factor = (strcmp(process->type,"IONIZATION") == 0) ? 2.0 : 1.0;
+            shift = (strcmp(process->type,"ATTACHMENT") == 0) ? -1.0 : process->param;
+
+            for (i=0 ; i<NG ; i++)
+            {
+                Cinel[i][i] -= fractions[process->species]*gamma*crossSectionMoment(process, eps_b[i], eps_b[i+1]);
+                if (shift < 0.0)
+                    continue;
+
+                // Electrons that end up in cell i come from the energies [lo,hi]
+                lo = factor*eps_b[i] + shift;
+                hi = factor*eps_b[i+1] + shift;
+                for (j=(int)(lo/dEps) ; j<NG && eps_b[j] < hi ; j++)
+                {
+                    overlap = crossSectionMoment(process, fmax(lo, eps_b[j]), fmin(hi, eps_b[j+1]));
+                    Cinel[i][j] += factor*fractions[process->species]*gamma*overlap;
+                }
+            }
+        }
+
+        // Elastic and field coefficients at the cell boundaries
+        for (i=0 ; i<=NG ; i++)
+        {
+            sigma_m = 0.0;
+            sigma_e = 0.0;
+            for (l=0 ; l<NoCollisions ; l++)
+            {
+                process = &collisions[l];
+                sigma_t = crossSection(process, eps_b[i]);
+                if (strcmp(process->type,"ELASTIC") == 0 || strcmp(process->type,"EFFECTIVE") == 0)
+                    sigma_e += fractions[process->species]*2.0*process->param*sigma_t;
+                sigma_m += fractions[process->species]*sigma_t;
+            }
+
+            // The effective momentum transfer includes the inelastic processes, so they are removed from the energy loss
+            for (l=0 ; l<NoCollisions ; l++)
+            {
+                process = &collisions[l];
+                if (strcmp(process->type,"EFFECTIVE") != 0)
+                    continue;
+                for (j=0 ; j<NoCollisions ; j++)
+                    if (collisions[j].species == process->species && strcmp(collisions[j].type,"ELASTIC") != 0 && strcmp(collisions[j].type,"EFFECTIVE") != 0)
+                    {
+                        sigma_e -= fractions[process->species]*2.0*process->param*crossSection(&collisions[j], eps_b[i]);
+                        sigma_m -= fractions[process->species]*crossSection(&collisions[j], eps_b[i]);
+                    }
+            }
+
+            W[i] = -gamma*eps_b[i]*eps_b[i]*sigma_e;
+            D[i] = gamma*Tgas_eV*eps_b[i]*eps_b[i]*sigma_e;
+            sigmaM_b[i] = sigma_m;
+        }
+
+        // Iterations for the growth rate and the electron-electron collisions, which depend on F
+        for (iter=0 ; iter<500 ; iter++)
+        {
+            // Electron-electron collision coefficients
+            for (i=0 ; i<=NG ; i++)
+            {
+                Cee_W[i] = 0.0;
+                Cee_D[i] = 0.0;
+            }
+            if (ionDegree > 0.0 && iter > 0)
+            {
+                lnLambda = log(12.0*pi*ne_local*pow(eps0*(2.0/3.0)*meanEnergy/(ne_local*e), 1.5));
+                a_ee = gamma*e*e/(24.0*pi*eps0*eps0)*lnLambda;
+
+                A1 = 0.0;
+                A2 = 0.0;
+                A3 = 0.0;
+                for (j=0 ; j<NG ; j++)
+                    A3 += F[j]*dEps;
+                for (i=0 ; i<=NG ; i++)
+                {
+                    Cee_W[i] = -3.0*a_ee*ionDegree*A1;
+                    Cee_D[i] = 2.0*a_ee*ionDegree*(A2 + pow(eps_b[i],1.5)*A3);
+                    if (i < NG)
+                    {
+                        A1 += F[i]*2.0/3.0*(pow(eps_b[i+1],1.5) - pow(eps_b[i],1.5));
+                        A2 += F[i]*2.0/5.0*(pow(eps_b[i+1],2.5) - pow(eps_b[i],2.5));
+                        A3 -= F[i]*dEps;
+                    }
+                }
+            }
+
+            // Assemble the matrix of the flux differences and the collision terms
+            for (i=0 ; i<NG ; i++)
+                for (j=0 ; j<NG ; j++)
+                    A[i][j] = -Cinel[i][j];
+            for (i=1 ; i<NG ; i++)
+            {
+                // Momentum transfer including the temporal growth, and the effective high-frequency field
+                sigma_m = sigmaM_b[i] + nu_growth/(gamma*sqrt(eps_b[i]));
+                q = WN/(gamma*sqrt(eps_b[i]));
+
+                // Flux through the boundary between the cells i-1 and i
+                Wb = W[i] + Cee_W[i];
+                Db = D[i] + Cee_D[i] + gamma/3.0*EN*EN*eps_b[i]*sigma_m/(sigma_m*sigma_m + q*q);
+                z = Wb*dEps/Db;
+                A[i-1][i-1] += Db/dEps*bernoulli(-z);
+                A[i-1][i] -= Db/dEps*bernoulli(z);
+                A[i][i-1] -= Db/dEps*bernoulli(-z);
+                A[i][i] += Db/dEps*bernoulli(z);
+            }
+            for (i=0 ; i<NG ; i++)
+                A[i][i] += nu_growth*2.0/3.0*(pow(eps_b[i+1],1.5) - pow(eps_b[i],1.5));
+
+            // Replace the first equation with the normalization of the EEDF
+            for (j=0 ; j<NG ; j++)
+            {
+                A[0][j] = 2.0/3.0*(pow(eps_b[j+1],1.5) - pow(eps_b[j],1.5));
+                F_new[j] = 0.0;
+            }
+            F_new[0] = 1.0;
+
+            // The inelastic gains only come from higher energies, so the matrix is upper Hessenberg
+            if (solveHessenbergSystem(NG, A, F_new) != 0)
+            {
+                printf("Error: Singular matrix in the two-term Boltzmann solver!\n");
+                exit(EXIT_FAILURE);
+            }
+
+            // Under-relaxation of the nonlinear electron-electron terms and convergence check
+            err = 0.0;
+            for (i=0 ; i<NG ; i++)
+            {
+                F_new[i] = fmax(F_new[i], 0.0);
+                if (iter > 0)
+                    F_new[i] = 0.5*F[i] + 0.5*F_new[i];
+                if (F_new[i] > 1.0e-10*F_new[0])
+                    err = fmax(err, relativeError(F_new[i], F[i]));
+                F[i] = F_new[i];
+            }
+
+            // Net growth rate and mean energy of the new EEDF
+            nu_growth = 0.0;
+            meanEnergy = 0.0;
+            for (l=0 ; l<NoCollisions ; l++)
+            {
+                process = &collisions[l];
+                if (strcmp(process->type,"IONIZATION") != 0 && strcmp(process->type,"ATTACHMENT") != 0)
+                    continue;
+                for (i=0 ; i<NG ; i++)
+                    nu_growth += ((strcmp(process->type,"IONIZATION") == 0) ? 1.0 : -1.0)*fractions[process->species]*gamma*crossSectionMoment(process, eps_b[i], eps_b[i+1])*F[i];
+            }
+            for (i=0 ; i<NG ; i++)
+                meanEnergy += F[i]*2.0/5.0*(pow(eps_b[i+1],2.5) - pow(eps_b[i],2.5));
+
+            if (iter > 1 && err < 1.0e-4)
+                break;
+        }
+
+        // Adapt the maximum energy so that F decays about ten orders of magnitude. With a fixed grid the
+        // maximum energy is kept in a wider range of the decay.
+        ratio = F[NG-1]/F[0];
+        if (lastTrial || (EEDFfixedGrid && ratio > 1.0e-14 && ratio < 1.0e-6))
+            break;
+        factor = (ratio > 0.0) ? log(1.0e-10)/log(ratio) : 0.7;
+        epsNew = snapMaxEnergy(epsMax*fmin(2.0, fmax(0.5, factor)));
+        if (epsNew == epsMax || (epsNew == epsPrevious && epsNew < epsMax))
+            break;
+        lastTrial = (epsNew == epsPrevious);
+        epsPrevious = epsMax;
+        epsMax = epsNew;
+
+        // Interpolate the EEDF on the new grid
+        for (i=0 ; i<NG ; i++)
+            F_new[i] = F[i];
+        for (i=0 ; i<NG ; i++)
+        {
+            j = (int)((i+0.5)*epsMax/NG/dEps);
+            F[i] = (j < NG) ? F_new[j] : F_new[NG-1]*1.0e-3;
+        }
+    }
+
+    // Rate coefficients and threshold energies
+    for (l=0 ; l<NoCollisions ; l++)
+    {
+        process = &collisions[l];
+        K_local[process->reaction][process->subreaction] = 0.0;
+        for (i=0 ; i<NG ; i++)
+            K_local[process->reaction][process->subreaction] += gamma*crossSectionMoment(process, eps_b[i], eps_b[i+1])*F[i];
+
+        if (strcmp(process->type,"EXCITATION") == 0 || strcmp(process->type,"IONIZATION") == 0)
+            Ethr_local[process->reaction][process->subreaction] = process->param*eVtoJ;
+        else
+            Ethr_local[process->reaction][process->subreaction] = 0.0;
+    }
+
+    // Keep the solution for the next call
+    for (i=0 ; i<NG ; i++)
+        EEDF_previous[i] = F[i];
+    EEDFmaxEnergy = epsMax;
+
+    free(A);
+    free(Cinel);
+
+    return (2.0*meanEnergy)/dgrFreedom;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the two-term Boltzmann equation for the current plasma state, with the same conditions that are
+// written in the BOLSIG+ input file, and return the electron temperature
+// --------------------------------------------------------------------------------------------------------
+double solveBoltzmann (double **K_local, double **Ethr_local)
+{
+    // The gas composition fractions are in the order of the neutralSpecies array (see writeBOLSIGinput)
+    return twoTermBoltzmann(E/nNeutral, freq/nNeutral, Tg, fabs(ne/nNeutral), ne, neutralFraction, K_local, Ethr_local);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the two-term Boltzmann equation for the current plasma state and print its relative differences
+// from the BOLSIG+ results, which are already stored in the K and Ethr arrays
+// --------------------------------------------------------------------------------------------------------
+void compareBoltzmann (double Te_BOLSIG)
+{
+    // Local variables
+    double **K_twoTerm, **Ethr_twoTerm, Te_twoTerm, K_BOLSIG;
+    int i, reaction, subreaction;
+
+    allocate(&K_twoTerm, react_num, subreact_num);
+    allocate(&Ethr_twoTerm, react_num, subreact_num);
+
+    Te_twoTerm = solveBoltzmann(K_twoTerm, Ethr_twoTerm);
+
+    logMessage(LOG_ITERATION, "Two-term Boltzmann solver vs BOLSIG+:  Te %10.4e  %10.4e  (%+.2e)\n", Te_twoTerm, Te_BOLSIG, (Te_twoTerm-Te_BOLSIG)/Te_BOLSIG);
+    for (i=0 ; i<count_BOLSIG ; i++)
+    {
+        reaction = map_reactions[i][0];
+        subreaction = map_reactions[i][1];
+        if (reaction == 0)
+            continue;
+        K_BOLSIG = K[reaction][subreaction];
+        logMessage(LOG_ITERATION, "    K%d%c  %10.4e  %10.4e  (%+.2e)\n", reaction, (subreaction>0) ? 'a'+subreaction-1 : ' ', K_twoTerm[reaction][subreaction], K_BOLSIG, (K_BOLSIG != 0.0) ? (K_twoTerm[reaction][subreaction]-K_BOLSIG)/K_BOLSIG : 0.0);
+    }
+
+    for (i=0 ; i<react_num ; i++)
+    {
+        free(K_twoTerm[i]);
+        free(Ethr_twoTerm[i]);
+    }
+    free(K_twoTerm);
+    free(Ethr_twoTerm);
+}
@@ -0,0 +1,310 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          chempaig.c
+    Type:               source
+    Short Description:  This file contains the source code of the libchempaig library (see
+                        chempaig.h), which is built with "make library".
+
+Description
+===========
+The state of the solver is thread-local (see variables.h), so every context owns a thread, which
+holds the state of the context between the calls. chempaigSolve passes the conditions to the thread
+of the context and waits for the solution. The thread reads the input file and allocates the arrays
+once, when the context is created, and then solves the model for every new set of conditions from
+the initial guess or from its previous solution. The EEDF of the in-process Boltzmann solver and the
+table of the rate coefficients are kept as well, so they are also warm-started.
+
+Only the functions of chempaig.h are exported from the shared library.
+
+Function name                   Type                Description
+=============                   ====                ===========
+- chempaigWorker                void*               Hold the state of a context and solve its requests.
+- chempaigCreate                chempaigContext*    Create a solver context from an input file.
+- chempaigGetConditions         void                Get the operating conditions of the input file of a context.
+- chempaigSolve                 int                 Solve the model for new operating conditions.
+- chempaigDestroy               void                Release a solver context.
+
+---------------------------------------------------------------------------------------------  */
+
+// Include C libraries (_GNU_SOURCE for the working directory of the BOLSIG+ process, see scratch.h)
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <errno.h>
+#include <dirent.h>
+#include <time.h>
+#include <stdarg.h>
+#ifndef _WIN32
+    #include <sys/mman.h>
+    #include <sys/wait.h>
+    #include <signal.h>
+    #include <spawn.h>
+    #include <fcntl.h>
+#endif
+
+// Include header files
+#include "variables.h"
+#include "functions.h"
+#include "sparse.h"
+#include "mechanism.h"
+#include "solvers.h"
+#include "boltzmann.h"
+#include "rateTables.h"
+#include "bolsigCache.h"
+#include "scratch.h"
+#include "bolsigSpeculation.h"
+#include "profiler.h"
+#include "convergence.h"
+#include "convergenceHistory.h"
+#include "simulation.h"
+#include "chempaig.h"
+
+// Requests to the thread of a context
+#define chempaigSolveRequest 1
+#define chempaigExitRequest 2
+
+struct chempaigContext
+{
+    pthread_t thread;
+    pthread_mutex_t lock;           // Serializes the calls on the context
+    sem_t request, done;            // Request to the thread, and its completion
+    int id, command, status;
+    char inputFile[MAXCHAR];
+
+    chempaigConditions defaults;    // Conditions and initial temperatures of the input file
+    double Tg_input, Te_input;
+
+    chempaigConditions conditions;  // Current request and its result
+    chempaigState guess;
+    bool useGuess, hasSolution;
+    chempaigResult result;
+};
+
+// Number of the contexts created so far
+int count_contexts=0;
+pthread_mutex_t contextsLock = PTHREAD_MUTEX_INITIALIZER;
+
+
+// --------------------------------------------------------------------------------------------------------
+// Hold the state of a context in the thread-local variables of this thread, and solve the model for every
+// request until the context is released
+// --------------------------------------------------------------------------------------------------------
+void *chempaigWorker (void *arg)
+{
+    // Local variables
+    int l;
+    chempaigContext *ctx = (chempaigContext*) arg;
+    chempaigState *x;
+
+    workerId = ctx->id;
+    printScreenOutput = false;
+
+    // Read the input file and allocate the arrays once
+    readfile(ctx->inputFile);
+
+    initializeSimulation();
+
+    // The species of the mechanism are reported by name in the result
+    if (mechanism.NoSpecies > CHEMPAIG_MAXSPECIES)
+    {
+        printf("Error: The mechanism %s has more than %d species!\n",mechanismFile,CHEMPAIG_MAXSPECIES);
+        exit(EXIT_FAILURE);
+    }
+    ctx->result.NoSpecies = mechanism.NoSpecies;
+    for (l=0 ; l<mechanism.NoSpecies ; l++)
+    {
+        if (strlen(mechanism.name[l]) >= CHEMPAIG_NAMELENGTH)
+        {
+            printf("Error: The name of the species %s is longer than %d characters!\n",mechanism.name[l],CHEMPAIG_NAMELENGTH-1);
+            exit(EXIT_FAILURE);
+        }
+        strcpy(ctx->result.speciesName[l], mechanism.name[l]);
+    }
+
+    ctx->defaults.p = p/TorrtoPa;
+    ctx->defaults.pin = pin/TorrtoPa;
+    ctx->defaults.Tgi = Tgi;
+    ctx->defaults.Qi = Qi/sccmtom3s;
+    ctx->defaults.E = E;
+    ctx->Tg_input = Tg;
+    ctx->Te_input = Te;
+    sem_post(&ctx->done);
+
+    while (true)
+    {
+        sem_wait(&ctx->request);
+        if (ctx->command == chempaigExitRequest)
+            break;
+
+        // New operating conditions
+        p = ctx->conditions.p*TorrtoPa;
+        pin = ctx->conditions.pin*TorrtoPa;
+        Tgi = ctx->conditions.Tgi;
+        Qi = ctx->conditions.Qi*sccmtom3s;
+        E = ctx->conditions.E;
+
+        // Start from the initial guess, from the previous solution, or from the initial values of the input file.
+        // The total density and the gas density of the model are set with the initial gas temperature of the
+        // input file, so they are the same with every initial guess.
+        x = ctx->useGuess ? &ctx->guess : (ctx->hasSolution ? &ctx->result.state : NULL);
+        Tg = ctx->Tg_input;
+        Te = (x != NULL) ? x->Te : ctx->Te_input;
+        initializeSolution(!ctx->hasSolution);
+        if (x != NULL)
+        {
+            Tg = Tg_0 = x->Tg;
+            calculateGasTemperatureRates();
+            nH = nH_0 = nH_old = x->nH;
+            nHplus = nHplus_0 = nHplus_old = x->nHplus;
+            nH2plus = nH2plus_0 = nH2plus_old = x->nH2plus;
+            nH3plus = nH3plus_0 = nH3plus_old = x->nH3plus;
+            updateClosureDensities();
+            ne_0 = ne_old = ne;
+            nH2_0 = nH2_old = nH2;
+            Tg_old = Tg;
+            Te_old = Te;
+        }
+
+        runSimulation();
+
+        ctx->result.state.ne = ne;
+        ctx->result.state.nH = nH;
+        ctx->result.state.nH2 = nH2;
+        ctx->result.state.nHplus = nHplus;
+        ctx->result.state.nH2plus = nH2plus;
+        ctx->result.state.nH3plus = nH3plus;
+        ctx->result.state.Tg = Tg;
+        ctx->result.state.Te = Te;
+        ctx->result.n = n;
+        ctx->result.iterations = count;
+        for (l=0 ; l<mechanism.NoSpecies ; l++)
+            ctx->result.speciesDensity[l] = speciesDensity[l];
+
+        // A solution that is not finite, or that stopped after an error of a solver, is not used to start the
+        // next one. A solution that stopped without converging is finite, so it is used.
+        ctx->status = (isfinite(ne) && isfinite(nH) && isfinite(Tg) && isfinite(Te)) ? convergenceStatus : CHEMPAIG_DIVERGED;
+        ctx->hasSolution = (ctx->status != CHEMPAIG_DIVERGED && ctx->status != CHEMPAIG_FAILED);
+        sem_post(&ctx->done);
+    }
+
+    finalizeSimulation();
+
+    return NULL;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Create a solver context from an input file. The input file is read by the thread of the context, which
+// is ready when this function returns.
+// --------------------------------------------------------------------------------------------------------
+CHEMPAIG_API chempaigContext *chempaigCreate (const char *inputFile)
+{
+    // Local variables
+    chempaigContext *ctx;
+
+    ctx = (chempaigContext*) calloc(1, sizeof(chempaigContext));
+    if (ctx == NULL)
+        return NULL;
+
+    snprintf(ctx->inputFile, MAXCHAR, "%s", inputFile);
+    pthread_mutex_lock(&contextsLock);
+    ctx->id = ++count_contexts;
+    pthread_mutex_unlock(&contextsLock);
+
+    pthread_mutex_init(&ctx->lock, NULL);
+    sem_init(&ctx->request, 0, 0);
+    sem_init(&ctx->done, 0, 0);
+
+    if (pthread_create(&ctx->thread, NULL, chempaigWorker, ctx) != 0)
+    {
+        pthread_mutex_destroy(&ctx->lock);
+        sem_destroy(&ctx->request);
+        sem_destroy(&ctx->done);
+        free(ctx);
+        return NULL;
+    }
+    sem_wait(&ctx->done);
+
+    return ctx;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Get the operating conditions of the input file of the context
+// --------------------------------------------------------------------------------------------------------
+CHEMPAIG_API void chempaigGetConditions (chempaigContext *ctx, chempaigConditions *conditions)
+{
+    *conditions = ctx->defaults;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the model for the operating conditions, starting from the initial guess, or from the previous
+// solution of the context if initialGuess is NULL
+// --------------------------------------------------------------------------------------------------------
+CHEMPAIG_API int chempaigSolve (chempaigContext *ctx, const chempaigConditions *conditions, const chempaigState *initialGuess, chempaigResult *result)
+{
+    // Local variables
+    int status;
+
+    pthread_mutex_lock(&ctx->lock);
+
+    ctx->command = chempaigSolveRequest;
+    ctx->conditions = *conditions;
+    ctx->useGuess = (initialGuess != NULL);
+    if (initialGuess != NULL)
+        ctx->guess = *initialGuess;
+
+    sem_post(&ctx->request);
+    sem_wait(&ctx->done);
+
+    *result = ctx->result;
+    status = ctx->status;
+
+    pthread_mutex_unlock(&ctx->lock);
+
+    return status;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Release the solver context and the memory of its thread
+// --------------------------------------------------------------------------------------------------------
+CHEMPAIG_API void chempaigDestroy (chempaigContext *ctx)
+{
+    if (ctx == NULL)
+        return;
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->command = chempaigExitRequest;
+    sem_post(&ctx->request);
+    pthread_join(ctx->thread, NULL);
+    pthread_mutex_unlock(&ctx->lock);
+
+    pthread_mutex_destroy(&ctx->lock);
+    sem_destroy(&ctx->request);
+    sem_destroy(&ctx->done);
+    free(ctx);
+}
@@ -0,0 +1,130 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          chempaig.h
+    Type:               header file
+    Short Description:  This file contains the public interface of the libchempaig library, which
+                        solves the model in-process from another program.
+
+Description
+===========
+A solver context is created once from an input file, which gives the geometry, the reactions, the
+numerical solvers and the initial conditions. The context keeps the cross sections, the arrays and
+the last solution in memory, so every call of chempaigSolve only solves the model for the new
+operating conditions, without reading or writing any file (except for the BOLSIG+ files in the
+private scratch directory of the context, when the BOLSIG backend is used without a cache hit). For
+example:
+
+    chempaigContext *ctx = chempaigCreate("input.txt");
+    chempaigConditions conditions;
+    chempaigResult result;
+
+    chempaigGetConditions(ctx, &conditions);
+    conditions.E = 5500.0;
+    chempaigSolve(ctx, &conditions, NULL, &result);     // Starts from the previous solution
+    chempaigDestroy(ctx);
+
+Different contexts can be used at the same time from different threads. The calls on the same
+context are serialized. The input file is checked when the context is created, and errors in it
+still terminate the program, as in the standalone code (also a mechanism with more than
+CHEMPAIG_MAXSPECIES species, or with longer names than CHEMPAIG_NAMELENGTH). The errors of the
+solvers during a solution (a singular Jacobian, an energy equation without a positive gas
+temperature, or a failure of BOLSIG+) do not: chempaigSolve returns CHEMPAIG_FAILED, and the
+context remains usable.
+
+Function name                   Type                Description
+=============                   ====                ===========
+- chempaigCreate                chempaigContext*    Create a solver context from an input file.
+- chempaigGetConditions         void                Get the operating conditions of the input file of a context.
+- chempaigSolve                 int                 Solve the model for new operating conditions.
+- chempaigDestroy               void                Release a solver context.
+
+---------------------------------------------------------------------------------------------  */
+
+#ifndef CHEMPAIG_H
+#define CHEMPAIG_H
+
+#ifdef _WIN32
+    #define CHEMPAIG_API
+#else
+    #define CHEMPAIG_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Opaque solver context
+typedef struct chempaigContext chempaigContext;
+
+// Operating conditions, in the units of the input file
+typedef struct
+{
+    double p;           // Pressure [Torr]
+    double pin;         // Inlet pressure [Torr]
+    double Tgi;         // Inlet temperature [K]
+    double Qi;          // Inlet flow rate [sccm]
+    double E;           // Electric field [V/m]
+} chempaigConditions;
+
+// State of the plasma: species densities [m-3], gas temperature [K] and electron temperature [eV]
+typedef struct
+{
+    double ne, nH, nH2, nHplus, nH2plus, nH3plus;
+    double Tg, Te;
+} chempaigState;
+
+// Maximum number of species of the mechanism in a solution, and maximum length of their names
+#define CHEMPAIG_MAXSPECIES 64
+#define CHEMPAIG_NAMELENGTH 32
+
+// Converged solution, with the densities of all the species of the mechanism [m-3] in the order of the
+// mechanism file (e.g. also the argon species of mechanismAr.txt, which are not in chempaigState)
+typedef struct
+{
+    chempaigState state;
+    double n;           // Total density [m-3]
+    int iterations;     // Number of outer iterations
+    int NoSpecies;      // Number of species of the mechanism
+    char speciesName[CHEMPAIG_MAXSPECIES][CHEMPAIG_NAMELENGTH];
+    double speciesDensity[CHEMPAIG_MAXSPECIES];
+} chempaigResult;
+
+// Create a solver context from an input file. Returns NULL if its thread cannot be created.
+CHEMPAIG_API chempaigContext *chempaigCreate (const char *inputFile);
+
+// Get the operating conditions of the input file of the context
+CHEMPAIG_API void chempaigGetConditions (chempaigContext *ctx, chempaigConditions *conditions);
+
+// Status of a solution, as in convergence.h
+#define CHEMPAIG_CONVERGED 0
+#define CHEMPAIG_MAXITERATIONS 1
+#define CHEMPAIG_STAGNATED 2
+#define CHEMPAIG_DIVERGED 3
+#define CHEMPAIG_FAILED 4
+
+// Solve the model for the operating conditions, starting from the initial guess. If initialGuess is NULL,
+// the solution starts from the previous solution of the context (or from the initial values of the input
+// file at the first call). Returns the status of the solution: CHEMPAIG_CONVERGED, or the reason why the
+// outer iterations stopped (CHEMPAIG_DIVERGED if the solution is not finite, CHEMPAIG_FAILED after an error of
+// a solver).
+CHEMPAIG_API int chempaigSolve (chempaigContext *ctx, const chempaigConditions *conditions, const chempaigState *initialGuess, chempaigResult *result);
+
+// Release the solver context
+CHEMPAIG_API void chempaigDestroy (chempaigContext *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,494 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          continuation.h
+    Type:               header file
+    Short Description:  This file contains the continuation of the steady-state solution along an
+                        operating parameter (p, pin, Tgi, Qi or E).
+
+Description
+===========
+The line "continuation E 5000.0 6000.0 20.0;" of the input file solves the model at E=5000 V/m with
+the usual outer iterations, and then follows the solution up to E=6000 V/m, starting with a step of
+20 V/m. The steady state is a fixed point of one outer iteration G (Boltzmann equation, energy
+equation and balance equations) on the unknowns u, the log of the unknown densities of the mechanism
+(nH, nH+, nH2+, nH3+ and the unknowns of the other species, see mechanism.h) and of Tg, so every
+point solves F(u,lambda) = G(u,lambda) - u = 0 for the parameter lambda, which is scaled by its
+start value. Each point is predicted from the previous one along the tangent of the solution curve,
+and corrected with quasi-Newton iterations on F. The Jacobian is calculated with finite differences
+at the first point, and it is then kept from point to point with Broyden updates at every corrector
+iteration. It is calculated again only when the corrector fails. The extra equation of the corrector
+is
+
+    Natural:    lambda = lambda_predicted
+    Arclength:  t_u.(u-u_0) + t_lambda.(lambda-lambda_0) = ds   (pseudo-arclength)
+
+The natural continuation stops at a turning point of the curve, where dF/du is singular, while the
+pseudo-arclength continuation follows the curve around it. The first tangent is the solution of the
+linear system with the right-hand side (0,...,0,1), and the next ones are the secants through the
+last two points. The step ds grows when the corrector converges in a few iterations and it is halved
+when the corrector fails. Every point is written to the file continuationOutput as soon as it
+converges.
+
+The Jacobian needs smooth rate coefficients, so the TwoTerm and Table Boltzmann solvers are best
+suited, and the energy grid of the two-term solver is kept fixed as long as possible. The rates of
+the BOLSIG+ output file have four significant digits.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- setContinuationParameter      void        Set the value of the continuation parameter.
+- setContinuationState          void        Set the plasma state from the unknowns of the continuation.
+- continuationResidual          bool        Calculate the fixed point residual of an outer iteration.
+- continuationJacobian          bool        Calculate the Jacobian of the residual with finite differences.
+- correctContinuationPoint      int         Correct a predicted point with quasi-Newton iterations.
+- writeContinuationPoint        void        Write a converged point to the screen and to the results file.
+- runContinuation               void        Follow the solution from the start to the end value of the parameter.
+
+---------------------------------------------------------------------------------------------  */
+
+// Limits of the continuation and of its corrector
+#define ContinuationMaxPoints 1000
+#define ContinuationMaxCorrector 12
+#define ContinuationTolerance 1.0e-8
+#define ContinuationPerturbation 1.0e-6
+
+// Initial gas temperature, which sets the total density of the model, and scale of the parameter
+THREAD_LOCAL double continuationTg, continuationScale;
+
+
+// --------------------------------------------------------------------------------------------------------
+// Set the value of the continuation parameter, in the units of the input file. The total density and the
+// gas density of the model depend on the pressure, so they are calculated again.
+// --------------------------------------------------------------------------------------------------------
+void setContinuationParameter (double value)
+{
+    if (strcmp(continuationParameter,"p") == 0)
+        p = value*TorrtoPa;
+    else if (strcmp(continuationParameter,"pin") == 0)
+        pin = value*TorrtoPa;
+    else if (strcmp(continuationParameter,"Tgi") == 0)
+        Tgi = value;
+    else if (strcmp(continuationParameter,"Qi") == 0)
+        Qi = value*sccmtom3s;
+    else if (strcmp(continuationParameter,"E") == 0)
+        E = value;
+    else
+    {
+        printf("Error: The continuation parameter %s is not one of: p, pin, Tgi, Qi, E\n",continuationParameter);
+        exit(EXIT_FAILURE);
+    }
+
+    n = p/(kB*continuationTg);
+    rho = p/(RH2*continuationTg);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Set the plasma state from the N unknowns of the continuation: the log of the unknown densities of the
+// mechanism and of Tg (the last one)
+// --------------------------------------------------------------------------------------------------------
+void setContinuationState (int N, const double y[N+1])
+{
+    // Local variables
+    int l;
+    double x[N];
+
+    for (l=0 ; l<N-1 ; l++)
+        x[l] = exp(y[l]);
+    Tg = Tg_0 = exp(y[N-1]);
+    setUnknowns(x);
+    nH_0 = nH;
+    nHplus_0 = nHplus;
+    nH2plus_0 = nH2plus;
+    nH3plus_0 = nH3plus;
+    copyOtherUnknowns(speciesDensity_0);
+    ne_0 = ne;
+    nH2_0 = nH2;
+    calculateGasTemperatureRates();
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the fixed point residual F = log(G(u)) - u of one outer iteration G from the state u, at the
+// scaled parameter value y[N]. Returns false if the new state is not positive and finite, or after an error
+// of a solver (see solverError).
+// --------------------------------------------------------------------------------------------------------
+bool continuationResidual (int N, const double y[N+1], double F[N])
+{
+    // Local variables
+    int l;
+    double x[N];
+
+    setContinuationParameter(y[N]*continuationScale);
+    setContinuationState(N, y);
+
+    // One outer iteration, starting after the solution of the balance equations
+    solverFailed = false;
+    solveElectronKinetics();
+    solveEnergyEquation();
+    solveBalanceEquations();
+    if (solverFailed)
+        return false;
+
+    getUnknowns(x, false);
+    x[N-1] = Tg;
+    for (l=0 ; l<N ; l++)
+    {
+        if (!(x[l] > 0.0) || !isfinite(x[l]))
+            return false;
+        F[l] = log(x[l]) - y[l];
+    }
+
+    return true;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the Jacobian of the residual with respect to the unknowns and the parameter with forward finite
+// differences, in the first N rows of J. F is the residual at y.
+// --------------------------------------------------------------------------------------------------------
+bool continuationJacobian (int N, const double y[N+1], const double F[N], double J[N+1][N+1])
+{
+    // Local variables
+    int l, m;
+    double y_h[N+1], F_h[N];
+
+    for (m=0 ; m<=N ; m++)
+    {
+        memcpy(y_h, y, sizeof(y_h));
+        y_h[m] += ContinuationPerturbation;
+        if (!continuationResidual(N, y_h, F_h))
+            return false;
+        for (l=0 ; l<N ; l++)
+            J[l][m] = (F_h[l] - F[l])/ContinuationPerturbation;
+    }
+
+    return true;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Correct the predicted point y with quasi-Newton iterations on the residual and the extra equation of the
+// continuation: the gradient of the extra equation is the tangent t for the pseudo-arclength method, with
+// the step ds from the previous point y0, or the unit vector of the parameter if natural is true, with the
+// parameter fixed at lambda. The Jacobian J of the previous point is used, or it is calculated again at the
+// predicted point if newJacobian is true, and it is updated with the Broyden formula at every iteration.
+// Returns the number of iterations, or -1 if the corrector does not converge.
+// --------------------------------------------------------------------------------------------------------
+int correctContinuationPoint (int N, double y[N+1], const double y0[N+1], const double t[N+1], double ds, bool natural, double lambda, double J[N+1][N+1],
+                              bool newJacobian, int *evaluations)
+{
+    // Local variables
+    int l, m, iter;
+    double F[N], F_old[N], A[N+1][N+1], b[N+1];
+    double residual, norm, JdY;
+
+    (*evaluations)++;
+    if (!continuationResidual(N, y, F))
+        return -1;
+    if (newJacobian)
+    {
+        *evaluations += N+1;
+        if (!continuationJacobian(N, y, F, J))
+            return -1;
+    }
+
+    // Gradient of the extra equation
+    for (m=0 ; m<=N ; m++)
+        J[N][m] = natural ? (m == N) : t[m];
+
+    for (iter=1 ; iter<=ContinuationMaxCorrector ; iter++)
+    {
+        for (l=0 ; l<N ; l++)
+            b[l] = -F[l];
+        if (natural)
+            b[N] = lambda - y[N];
+        else
+        {
+            b[N] = ds;
+            for (m=0 ; m<=N ; m++)
+                b[N] -= t[m]*(y[m] - y0[m]);
+        }
+
+        memcpy(A, J, sizeof(A));
+        if (solveLinearSystem(N+1, A, b) != 0)
+            return -1;
+
+        norm = 0.0;
+        for (m=0 ; m<=N ; m++)
+        {
+            y[m] += b[m];
+            norm += b[m]*b[m];
+        }
+
+        memcpy(F_old, F, sizeof(F));
+        (*evaluations)++;
+        if (!continuationResidual(N, y, F))
+            return -1;
+
+        residual = 0.0;
+        for (l=0 ; l<N ; l++)
+            residual = fmax(residual, fabs(F[l]));
+
+        // The residual is the relative change of one outer iteration, as in the convergence check of runSimulation
+        if (residual < ContinuationTolerance)
+            return iter;
+
+        // Broyden update of the rows of the residual: J += (dF - J*dy)*dy'/(dy'*dy)
+        if (norm > 0.0)
+            for (l=0 ; l<N ; l++)
+            {
+                JdY = 0.0;
+                for (m=0 ; m<=N ; m++)
+                    JdY += J[l][m]*b[m];
+                for (m=0 ; m<=N ; m++)
+                    J[l][m] += (F[l] - F_old[l] - JdY)*b[m]/norm;
+            }
+    }
+
+    return -1;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write a converged point to the screen and to the results file, with the densities of all the species of
+// the mechanism
+// --------------------------------------------------------------------------------------------------------
+void writeContinuationPoint (FILE *fp, int point, double lambda, int iterations, int evaluations)
+{
+    // Local variables
+    int l;
+
+    fprintf(fp, "%d\t%.6g\t%d\t%d\t%.4e", point, lambda, iterations, evaluations, n);
+    for (l=0 ; l<mechanism.NoSpecies ; l++)
+        fprintf(fp, "\t%.4e", speciesDensity[l]);
+    fprintf(fp, "\t%.2f\t%.2f\n", Tg, Te);
+    fflush(fp);
+
+    printf("Continuation point %d: %s=%.6g Iterations=%d Evaluations=%d ne=%.4e nH=%.4e Tg=%.2f Te=%.2f\n", point, continuationParameter, lambda,
+           iterations, evaluations, ne, nH, Tg, Te);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Follow the solution from the start to the end value of the continuation parameter. The convergence status
+// is set to converged only if the continuation reached the end value, or the start value after a turning point.
+// --------------------------------------------------------------------------------------------------------
+void runContinuation ()
+{
+    // Local variables
+    int N, l, point, iterations, evaluations;
+    bool natural, last, returned=false;
+    double direction, lambdaEnd, ds, dsMin, dsMax, alpha, norm;
+
+    if (strcmp(continuationMethod,"Natural") != 0 && strcmp(continuationMethod,"Arclength") != 0)
+    {
+        printf("Error: The continuation method %s is not one of: Natural, Arclength\n",continuationMethod);
+        exit(EXIT_FAILURE);
+    }
+    natural = (strcmp(continuationMethod,"Natural") == 0);
+
+    // The parameter is scaled by its start value, so that its steps are comparable to those of the log of the state
+    continuationScale = (continuationStart != 0.0) ? fabs(continuationStart) : ((continuationEnd != 0.0) ? fabs(continuationEnd) : 1.0);
+    direction = (continuationEnd >= continuationStart) ? 1.0 : -1.0;
+    lambdaEnd = continuationEnd/continuationScale;
+
+    FILE * fp;
+    fp = fopen(continuationOutput,"w");
+    if (fp == NULL)
+    {
+        printf("Error: The file %s cannot be written!\n",continuationOutput);
+        exit(EXIT_FAILURE);
+    }
+    printf("%s continuation of %s from %g to %g\n\n", continuationMethod, continuationParameter, continuationStart, continuationEnd);
+
+    // Solve the first point with the outer iterations
+    printScreenOutput = false;
+    continuationTg = Tg;
+    setContinuationParameter(continuationStart);
+    initializeSimulation();
+
+    // The density columns of the results file are named after the species of the mechanism
+    fprintf(fp, "# point\t%s\tIterations\tEvaluations\tn", continuationParameter);
+    for (l=0 ; l<mechanism.NoSpecies ; l++)
+        fprintf(fp, "\tn%s", mechanism.name[l]);
+    fprintf(fp, "\tTg\tTe\n");
+
+    runSimulation();
+    if (convergenceStatus != SOLUTION_CONVERGED)
+    {
+        printf("Error: The first point of the continuation did not converge, the solution %s!\n",convergenceStatusName(convergenceStatus));
+        exit(EXIT_FAILURE);
+    }
+
+    point = 0;
+    writeContinuationPoint(fp, point, continuationStart, count, count);
+    EEDFfixedGrid = true;
+
+    // Unknowns of the continuation: the log of the unknown densities of the mechanism and of Tg, and the parameter
+    N = mechanism.NoUnknowns+1;
+
+    double y0[N+1], y[N+1], t[N+1], J[N+1][N+1], J_previous[N+1][N+1], A[N+1][N+1], F[N];
+
+    getUnknowns(y0, false);
+    y0[N-1] = Tg;
+    for (l=0 ; l<N ; l++)
+        y0[l] = log(y0[l]);
+    y0[N] = continuationStart/continuationScale;
+
+    // Tangent at the first point: the solution of J*t = (0,...,0,1) with the unit vector of the parameter in the last row
+    if (!continuationResidual(N, y0, F) || !continuationJacobian(N, y0, F, J))
+    {
+        printf("Error: The Jacobian of the continuation cannot be calculated at the first point!\n");
+        exit(EXIT_FAILURE);
+    }
+    for (l=0 ; l<=N ; l++)
+    {
+        J[N][l] = (l == N);
+        t[l] = (l == N);
+    }
+    memcpy(A, J, sizeof(A));
+    if (solveLinearSystem(N+1, A, t) != 0)
+    {
+        printf("Error: The Jacobian of the continuation is singular at the first point!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // The first step of the parameter is the step of the input file
+    ds = continuationStep/continuationScale;
+    if (!natural)
+    {
+        norm = 0.0;
+        for (l=0 ; l<=N ; l++)
+            norm += t[l]*t[l];
+        ds *= sqrt(norm);
+    }
+    dsMin = 1.0e-4*ds;
+    dsMax = 20.0*ds;
+
+    last = ((lambdaEnd - y0[N])*direction <= 0.0);
+    while (!last && point < ContinuationMaxPoints)
+    {
+        // Normalize the tangent. The first tangent, and every tangent of the natural continuation, point in the
+        // direction of the end value.
+        norm = 0.0;
+        for (l=0 ; l<=N ; l++)
+            norm += t[l]*t[l];
+        norm = sqrt(norm);
+        if ((point == 0 || natural) && t[N]*direction < 0.0)
+            norm = -norm;
+        for (l=0 ; l<=N ; l++)
+            t[l] /= norm;
+
+        // Predictor along the tangent. The natural continuation steps the parameter by ds.
+        alpha = natural ? direction*ds/t[N] : ds;
+        if ((y0[N] + alpha*t[N] - lambdaEnd)*direction > 0.0 || (natural && t[N]*direction <= 0.0))
+        {
+            // The last point is solved at the end value of the parameter
+            if (t[N]*direction <= 0.0)
+            {
+                printf("Error: The natural continuation reached a turning point at %s=%g. Use the Arclength method.\n",continuationParameter,y0[N]*continuationScale);
+                convergenceStatus = SOLUTION_STAGNATED;
+                break;
+            }
+            alpha = (lambdaEnd - y0[N])/t[N];
+            last = true;
+        }
+        for (l=0 ; l<=N ; l++)
+            y[l] = y0[l] + alpha*t[l];
+
+        // Corrector, with the Jacobian of the previous point and then with a new Jacobian
+        evaluations = 0;
+        memcpy(J_previous, J, sizeof(J));
+        iterations = correctContinuationPoint(N, y, y0, t, ds, natural || last, last ? lambdaEnd : y[N], J, false, &evaluations);
+        if (iterations < 0)
+        {
+            for (l=0 ; l<=N ; l++)
+                y[l] = y0[l] + alpha*t[l];
+            iterations = correctContinuationPoint(N, y, y0, t, ds, natural || last, last ? lambdaEnd : y[N], J, true, &evaluations);
+        }
+        if (iterations < 0)
+        {
+            memcpy(J, J_previous, sizeof(J));
+            last = false;
+            ds *= 0.5;
+            if (ds < dsMin)
+            {
+                printf("Error: The continuation stopped at %s=%g, the step became too small.\n",continuationParameter,y0[N]*continuationScale);
+                convergenceStatus = solverFailed ? SOLUTION_FAILED : SOLUTION_STAGNATED;
+                break;
+            }
+            continue;
+        }
+
+        // A corrected point past the end value is solved again at the end value
+        if (!last && (y[N] - lambdaEnd)*direction > 0.0)
+        {
+            alpha = (lambdaEnd - y0[N])/t[N];
+            for (l=0 ; l<=N ; l++)
+                y[l] = y0[l] + alpha*t[l];
+            last = true;
+            iterations = correctContinuationPoint(N, y, y0, t, ds, true, lambdaEnd, J, false, &evaluations);
+            if (iterations < 0)
+            {
+                for (l=0 ; l<=N ; l++)
+                    y[l] = y0[l] + alpha*t[l];
+                iterations = correctContinuationPoint(N, y, y0, t, ds, true, lambdaEnd, J, true, &evaluations);
+            }
+            if (iterations < 0)
+            {
+                printf("Error: The continuation did not converge at the end value %s=%g\n",continuationParameter,continuationEnd);
+                convergenceStatus = solverFailed ? SOLUTION_FAILED : SOLUTION_DIVERGED;
+                break;
+            }
+        }
+
+        point++;
+        writeContinuationPoint(fp, point, y[N]*continuationScale, iterations, evaluations);
+
+        // The pseudo-arclength continuation can turn back past the start value after a turning point
+        if (!natural && (y[N] - continuationStart/continuationScale)*direction < 0.0)
+        {
+            printf("The continuation returned to the start value of %s after a turning point.\n",continuationParameter);
+            returned = true;
+            break;
+        }
+
+        // New tangent along the secant through the last two points, which is normalized at the next step
+        for (l=0 ; l<=N ; l++)
+        {
+            t[l] = y[l] - y0[l];
+            y0[l] = y[l];
+        }
+
+        // Adapt the step to the number of the corrector iterations
+        if (iterations <= 4)
+            ds = fmin(1.5*ds, dsMax);
+        else if (iterations >= 8)
+            ds = 0.5*ds;
+    }
+
+    // The continuation is successful if it reached the end value, or the start value after a turning point
+    if (convergenceStatus == SOLUTION_CONVERGED && !last && !returned)
+    {
+        printf("Error: The continuation stopped at %s=%g, after the maximum number of %d points.\n",continuationParameter,y0[N]*continuationScale,
+               ContinuationMaxPoints);
+        convergenceStatus = SOLUTION_MAXITERATIONS;
+    }
+
+    fclose(fp);
+
+    printf("\nThe results of the continuation were written to the file: %s\n", continuationOutput);
+
+    finalizeSimulation();
+}
@@ -0,0 +1,283 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          convergence.h
+    Type:               header file
+    Short Description:  This file contains the relaxation of the SOR solvers and the convergence
+                        control of the outer iterations.
+
+Description
+===========
+The changes of the unknowns are measured with a weighted maximum norm: the change of every unknown is
+divided by rtol*|x| + atol, where rtol is convergenceTolerance (or the speciesTolerance of the
+species) and atol is absoluteTolerance for the densities and zero for Tg, so the iterations have
+converged when the norm is below 1. The absolute tolerance keeps the species with negligible
+densities from deciding the convergence.
+
+With relaxationMethod Fixed, the SOR updates of the species balance and of the energy equation use
+the factors r1, r2 and r3 of the input file. With relaxationMethod Adaptive these are the initial
+factors, and the factor of every equation is adjusted from the history of its full (unrelaxed)
+change: it is halved when the change reverses its sign, since the update oscillates, and it grows
+by half when the change keeps its sign and decreases, since the update creeps towards the solution.
+The factors are at most 1 and the update never drops a density below a tenth of its value, so the
+densities remain positive. With densityVariables Log the densities are relaxed geometrically, as
+x_0*(target/x_0)^factor, and the factors are adjusted from the changes of their logarithms, so the
+trace species relax as fast as the neutrals. The factors are kept between the outer iterations of a
+solution. Since the relaxed change is small for a small factor, the SOR iterations converge when the
+full change is below the tolerance.
+
+The outer iterations stop when their norm is below 1, when they reach maxIterations, when the norm
+is not halved in stagnationIterations iterations (stagnated), when the unknowns are not finite
+or the norm grows by DIVERGENCEFACTOR over its best value (diverged), or after an error of a solver
+(failed, e.g. a singular Jacobian or a failed BOLSIG+ run). The SOR iterations stop at
+maxInnerIterations, and the Newton solvers of the balance equations use the smallest tolerance of
+the unknowns. The reason why the outer iterations stopped is kept in convergenceStatus, which the
+drivers report.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- initializeConvergence         void        Set the tolerances of the unknowns and allocate the relaxation factors.
+- resetConvergence              void        Start the convergence control of a new solution.
+- weightedChange                double      Change of an unknown relative to its tolerance.
+- relaxUnknown                  double      Relaxed SOR update of an unknown, which adapts its relaxation factor.
+- convergenceNorm               double      Weighted norm of the change of the unknowns and Tg in an outer iteration.
+- convergenceStatusName         const char* Description of the status of the solution.
+- checkConvergence              bool        Decide if the outer iterations continue, and why they stop.
+- finalizeConvergence           void        Release the memory of the convergence control.
+
+---------------------------------------------------------------------------------------------  */
+
+// Status of the solution
+#define SOLUTION_RUNNING -1
+#define SOLUTION_CONVERGED 0
+#define SOLUTION_MAXITERATIONS 1
+#define SOLUTION_STAGNATED 2
+#define SOLUTION_DIVERGED 3
+#define SOLUTION_FAILED 4
+
+// Limits of the adaptive relaxation factors, and growth of the norm over its best value that is divergence
+#define MINRELAXATION 1.0e-12
+#define MAXRELAXATION 1.0
+#define DIVERGENCEFACTOR 1.0e4
+
+// Relative tolerances and relaxation factors of the unknowns and of Tg (the last one), and the last full
+// changes of the SOR updates
+THREAD_LOCAL double *unknownTolerance=NULL, *relaxFactor=NULL, *relaxChange=NULL;
+THREAD_LOCAL int convergenceStatus=SOLUTION_RUNNING, bestIteration=0;
+THREAD_LOCAL double outerNorm=0.0, bestNorm=0.0;
+
+// Tolerance of the Newton solvers of the balance equations: the smallest relative tolerance of the unknowns
+THREAD_LOCAL double innerTolerance=1.0e-8;
+
+
+// --------------------------------------------------------------------------------------------------------
+// Set the relative tolerances of the unknowns of the mechanism and of the Newton solvers, and allocate the
+// relaxation factors, after the mechanism is read
+// --------------------------------------------------------------------------------------------------------
+void initializeConvergence ()
+{
+    // Local variables
+    int l, m, s, N = mechanism.NoUnknowns;
+
+    unknownTolerance = (double*) malloc((N+1)*sizeof(double));
+    relaxFactor = (double*) malloc((N+1)*sizeof(double));
+    relaxChange = (double*) calloc(N+1, sizeof(double));
+
+    for (l=0 ; l<=N ; l++)
+        unknownTolerance[l] = convergenceTolerance;
+    innerTolerance = convergenceTolerance;
+
+    for (m=0 ; m<NoSpeciesTolerances ; m++)
+    {
+        s = findSpecies(speciesToleranceName[m]);
+        for (l=0 ; l<N ; l++)
+            if (mechanism.unknown[l] == s)
+                break;
+        if (s < 0 || l == N)
+        {
+            printf("Error: The species %s of speciesTolerance is not an unknown of the mechanism!\n",speciesToleranceName[m]);
+            exit(EXIT_FAILURE);
+        }
+        unknownTolerance[l] = speciesToleranceValue[m];
+        innerTolerance = fmin(innerTolerance, speciesToleranceValue[m]);
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Start the convergence control of a new solution, with the relaxation factors of the input file
+// --------------------------------------------------------------------------------------------------------
+void resetConvergence ()
+{
+    // Local variables
+    int l, N = mechanism.NoUnknowns;
+
+    for (l=0 ; l<N ; l++)
+        relaxFactor[l] = (l == 2) ? r2 : r1;
+    relaxFactor[N] = r3;
+
+    convergenceStatus = SOLUTION_RUNNING;
+    solverFailed = false;
+    outerNorm = 0.0;
+    bestNorm = INFINITY;
+    bestIteration = 0;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Change of the unknown l (l = mechanism.NoUnknowns for Tg) relative to its tolerance at the value x. It is
+// below 1 for a converged unknown.
+// --------------------------------------------------------------------------------------------------------
+double weightedChange (int l, double change, double x)
+{
+    return fabs(change)/(unknownTolerance[l]*fabs(x) + ((l < mechanism.NoUnknowns) ? absoluteTolerance : 0.0));
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Relaxed SOR update of the unknown l from x_0 towards the value target of the full update. With the adaptive
+// relaxation the factor of the unknown is adjusted first, from the sign and the size of the full change of the
+// previous update (first is true at the first update of an SOR solution). The weighted change of the update is
+// added to norm (the full change with the adaptive relaxation), which is infinite if the unknown is not finite.
+// --------------------------------------------------------------------------------------------------------
+double relaxUnknown (int l, double x_0, double target, bool first, double *norm)
+{
+    // Local variables
+    double x, change;
+    bool adaptive = (strcmp(relaxationMethod,"Adaptive") == 0);
+    bool logVariable = (strcmp(densityVariables,"Log") == 0 && l < mechanism.NoUnknowns);
+
+    // The change of a density in the log variables is the log of its ratio, with the target limited to a
+    // hundredth of the density
+    change = logVariable ? log(fmax(target, 0.01*x_0)/x_0) : target - x_0;
+
+    if (adaptive)
+    {
+        if (first)
+            relaxChange[l] = 0.0;
+        if (change*relaxChange[l] < 0.0)
+            relaxFactor[l] = fmax(MINRELAXATION, 0.5*relaxFactor[l]);
+        else if (fabs(change) < fabs(relaxChange[l]))
+            relaxFactor[l] = fmin(MAXRELAXATION, 1.5*relaxFactor[l]);
+        relaxChange[l] = change;
+    }
+
+    if (logVariable)
+        x = x_0*exp(relaxFactor[l]*change);
+    else
+        x = (1.0-relaxFactor[l])*x_0 + relaxFactor[l]*target;
+
+    // The update keeps the unknown positive
+    if (adaptive && x < 0.1*x_0)
+        x = 0.1*x_0;
+
+    if (!isfinite(x))
+        *norm = INFINITY;
+    else
+        *norm = fmax(*norm, weightedChange(l, adaptive ? target - x_0 : x - x_0, x));
+
+    return x;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Weighted norm of the change of the unknowns and Tg in the last outer iteration. It is infinite if an
+// unknown is not finite.
+// --------------------------------------------------------------------------------------------------------
+double convergenceNorm ()
+{
+    // Local variables
+    int l, N = mechanism.NoUnknowns;
+    double x[N], x_old[N], norm=0.0;
+
+    getUnknowns(x, false);
+    x_old[0] = nH_old;
+    x_old[1] = nHplus_old;
+    x_old[2] = nH2plus_old;
+    x_old[3] = nH3plus_old;
+    for (l=NoHydrogenUnknowns ; l<N ; l++)
+        x_old[l] = speciesDensity_old[mechanism.unknown[l]];
+
+    for (l=0 ; l<N ; l++)
+    {
+        if (!isfinite(x[l]))
+            return INFINITY;
+        norm = fmax(norm, weightedChange(l, x[l] - x_old[l], x[l]));
+    }
+    if (!isfinite(Tg))
+        return INFINITY;
+
+    return fmax(norm, weightedChange(N, Tg - Tg_old, Tg));
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Description of the status of a solution
+// --------------------------------------------------------------------------------------------------------
+const char *convergenceStatusName (int status)
+{
+    switch (status)
+    {
+        case SOLUTION_CONVERGED:        return "converged";
+        case SOLUTION_MAXITERATIONS:    return "reached maxIterations";
+        case SOLUTION_STAGNATED:        return "stagnated";
+        case SOLUTION_DIVERGED:         return "diverged";
+        case SOLUTION_FAILED:           return "failed";
+        default:                        return "is running";
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Decide from the norm of the current outer iteration if the outer iterations continue. If they stop, the
+// reason is stored in convergenceStatus and the solutions that did not converge are reported as warnings.
+// --------------------------------------------------------------------------------------------------------
+bool checkConvergence (double norm)
+{
+    outerNorm = norm;
+
+    // An error of a solver in this iteration (see solverError) stops the outer iterations
+    if (solverFailed)
+        convergenceStatus = SOLUTION_FAILED;
+    else if (!isfinite(norm) || norm > DIVERGENCEFACTOR*bestNorm)
+        convergenceStatus = SOLUTION_DIVERGED;
+    else if (norm <= 1.0)
+        convergenceStatus = SOLUTION_CONVERGED;
+    else if (count >= maxIterations)
+        convergenceStatus = SOLUTION_MAXITERATIONS;
+    else if (norm < 0.5*bestNorm)
+    {
+        // Progress: the norm is halved
+        bestNorm = norm;
+        bestIteration = count;
+    }
+    else if (stagnationIterations > 0 && count - bestIteration >= stagnationIterations)
+        convergenceStatus = SOLUTION_STAGNATED;
+
+    if (convergenceStatus != SOLUTION_RUNNING && convergenceStatus != SOLUTION_CONVERGED)
+        logMessage(LOG_WARNING, "Warning: The outer iterations stopped at iteration %d, the solution %s (norm=%.2e)\n", count, convergenceStatusName(convergenceStatus), norm);
+
+    return (convergenceStatus == SOLUTION_RUNNING);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Release the memory of the convergence control
+// --------------------------------------------------------------------------------------------------------
+void finalizeConvergence ()
+{
+    free(unknownTolerance);
+    free(relaxFactor);
+    free(relaxChange);
+    unknownTolerance = relaxFactor = relaxChange = NULL;
+}
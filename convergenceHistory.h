@@ -0,0 +1,217 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          convergenceHistory.h
+    Type:               header file
+    Short Description:  This file contains the buffered writer of the convergence history of the outer
+                        iterations.
+
+Description
+===========
+When historyOutput is not none, every outer iteration adds a row to the convergence history: the
+solution and the iteration, the elapsed time and the times of the balance equations, the electron
+kinetics and the energy equation in the iteration (from the timers of profiler.h, which are turned
+on by the history), the inner iterations, Tg, Te and ne, the weighted norm of the convergence
+control (see convergence.h), and the relative changes of the electron, H2 and unknown densities, of
+Tg and of Te. The rows are stored as numbers in a buffer of HISTORYBUFFER rows, which is written to
+the file only when it is full and at the end, so the outer iterations do no formatting and no I/O.
+
+With historyFormat CSV the file is a table of comma-separated values with a header line of the
+column names. With historyFormat binary the file starts with the 8 bytes "CPHIST1\n", the number
+of columns as a 32-bit integer and the names of the columns as null-terminated strings, followed by
+the rows as doubles, in the byte order of the machine. The threads of a sweep and the contexts of
+the library write their own files, with the number of the sweep point or context appended to the
+file name.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- initializeHistory             void        Set the columns of the history and write the header of the file.
+- flushHistory                  void        Write the rows of the buffer to the file.
+- recordHistory                 void        Add the row of the current outer iteration to the buffer.
+- finalizeHistory               void        Write the last rows and release the memory of the history.
+
+---------------------------------------------------------------------------------------------  */
+
+// Rows kept in memory before they are written
+#define HISTORYBUFFER 256
+
+// Columns before the relative changes of the densities
+#define NoHistoryFixedColumns 12
+
+THREAD_LOCAL bool useHistory=false;
+THREAD_LOCAL int NoHistoryColumns=0, NoHistoryRows=0;
+THREAD_LOCAL double *historyBuffer=NULL;
+THREAD_LOCAL char (*historyColumn)[MAXCHAR]=NULL;
+THREAD_LOCAL char historyFile[MAXCHAR];
+
+
+// --------------------------------------------------------------------------------------------------------
+// Set the columns of the history from the unknowns of the mechanism and write the header of the file, when
+// the simulation is initialized
+// --------------------------------------------------------------------------------------------------------
+void initializeHistory ()
+{
+    // Local variables
+    int l, c;
+    int32_t NoColumns32;
+    const char *fixed[NoHistoryFixedColumns] = {"solution", "iteration", "time", "balanceTime", "electronTime", "energyTime",
+                                                "balanceIterations", "energyIterations", "Tg", "Te", "ne", "norm"};
+    FILE *fp;
+
+    useHistory = (strcmp(historyOutput,"") != 0 && strcmp(historyOutput,"none") != 0);
+    if (!useHistory)
+        return;
+
+    NoHistoryColumns = NoHistoryFixedColumns + 2 + mechanism.NoUnknowns + 2;
+    historyColumn = malloc(NoHistoryColumns*sizeof(*historyColumn));
+    historyBuffer = (double*) malloc(HISTORYBUFFER*NoHistoryColumns*sizeof(double));
+    NoHistoryRows = 0;
+
+    c = 0;
+    for (l=0 ; l<NoHistoryFixedColumns ; l++)
+        snprintf(historyColumn[c++], MAXCHAR, "%s", fixed[l]);
+    snprintf(historyColumn[c++], MAXCHAR, "err_e");
+    snprintf(historyColumn[c++], MAXCHAR, "err_H2");
+    for (l=0 ; l<mechanism.NoUnknowns ; l++)
+        snprintf(historyColumn[c++], MAXCHAR, "err_%s", mechanism.name[mechanism.unknown[l]]);
+    snprintf(historyColumn[c++], MAXCHAR, "err_Tg");
+    snprintf(historyColumn[c++], MAXCHAR, "err_Te");
+
+    workerFileName(historyOutput, historyFile);
+    fp = fopen(historyFile, "wb");
+    if (fp == NULL)
+    {
+        printf("Error: Could not open the file: %s\n",historyFile);
+        exit(EXIT_FAILURE);
+    }
+
+    if (strcmp(historyFormat,"binary") == 0)
+    {
+        NoColumns32 = NoHistoryColumns;
+        fwrite("CPHIST1\n", 1, 8, fp);
+        fwrite(&NoColumns32, sizeof(int32_t), 1, fp);
+        for (c=0 ; c<NoHistoryColumns ; c++)
+            fwrite(historyColumn[c], 1, strlen(historyColumn[c])+1, fp);
+    }
+    else
+    {
+        for (c=0 ; c<NoHistoryColumns ; c++)
+            fprintf(fp, (c == 0) ? "%s" : ",%s", historyColumn[c]);
+        fprintf(fp, "\n");
+    }
+
+    fclose(fp);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write the rows of the buffer to the end of the file and empty the buffer
+// --------------------------------------------------------------------------------------------------------
+void flushHistory ()
+{
+    // Local variables
+    int l, c;
+    const double *row;
+    FILE *fp;
+
+    if (!useHistory || NoHistoryRows == 0)
+        return;
+
+    fp = fopen(historyFile, "ab");
+    if (fp == NULL)
+    {
+        printf("Error: Could not open the file: %s\n",historyFile);
+        exit(EXIT_FAILURE);
+    }
+
+    if (strcmp(historyFormat,"binary") == 0)
+        fwrite(historyBuffer, sizeof(double), NoHistoryRows*NoHistoryColumns, fp);
+    else
+        for (l=0 ; l<NoHistoryRows ; l++)
+        {
+            // The solution, the iteration and the inner iterations (columns 0, 1, 6 and 7) are integers
+            row = &historyBuffer[l*NoHistoryColumns];
+            for (c=0 ; c<NoHistoryColumns ; c++)
+                fprintf(fp, (c < 2 || c == 6 || c == 7) ? "%s%.0f" : "%s%.9e", (c == 0) ? "" : ",", row[c]);
+            fprintf(fp, "\n");
+        }
+
+    fclose(fp);
+    NoHistoryRows = 0;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Add the row of the current outer iteration to the buffer, after the relative changes of the iteration are
+// calculated and before the densities are stored for the next one
+// --------------------------------------------------------------------------------------------------------
+void recordHistory ()
+{
+    // Local variables
+    int l, s, c=0;
+    double *row, electronTime=0.0;
+    const profileIteration *timers;
+    const double hydrogenErrors[NoHydrogenUnknowns] = {err_H, err_Hplus, err_H2plus, err_H3plus};
+
+    if (!useHistory)
+        return;
+
+    if (NoHistoryRows == HISTORYBUFFER)
+        flushHistory();
+    row = &historyBuffer[NoHistoryRows*NoHistoryColumns];
+    NoHistoryRows++;
+
+    // Times of the iteration until now, from the timers of the profiler
+    timers = &profileIterations[NoProfileIterations-1];
+    for (l=PROFILE_TWOTERM ; l<=PROFILE_BOLSIG_OUTPUT ; l++)
+        electronTime += timers->time[l];
+
+    row[c++] = profileSolutions;
+    row[c++] = count;
+    row[c++] = profileClock() - profileOrigin;
+    row[c++] = timers->time[PROFILE_BALANCE];
+    row[c++] = electronTime;
+    row[c++] = timers->time[PROFILE_ENERGY];
+    row[c++] = count_SB;
+    row[c++] = count_Tg;
+    row[c++] = Tg;
+    row[c++] = Te;
+    row[c++] = ne;
+    row[c++] = outerNorm;
+    row[c++] = err_e;
+    row[c++] = err_H2;
+    for (l=0 ; l<mechanism.NoUnknowns ; l++)
+    {
+        s = mechanism.unknown[l];
+        row[c++] = (l < NoHydrogenUnknowns) ? hydrogenErrors[l] : relativeError(speciesDensity[s], speciesDensity_old[s]);
+    }
+    row[c++] = err_Tg;
+    row[c++] = err_Te;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write the last rows of the buffer and release the memory of the history, when the simulation is finalized
+// --------------------------------------------------------------------------------------------------------
+void finalizeHistory ()
+{
+    if (!useHistory)
+        return;
+
+    flushHistory();
+    free(historyBuffer);
+    free(historyColumn);
+    historyBuffer = NULL;
+    historyColumn = NULL;
+    useHistory = false;
+}
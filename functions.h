@@ -18,13 +18,19 @@ File info
 Function name                   Type        Description
 =============                   ====        ===========
 - allocate                      void        Allocate an array (int or double) according to the input argumets
+- logEnabled                    bool        Check if the messages of a verbosity level are printed.
+- logMessage                    void        Print a message of a verbosity level.
+- solverError                   void        Report an error of a solver, which stops the solution without exiting.
 - readfile                      void        Read the variables of the input file.
+- fileName                      const char* Return the file name of a path, without its directory.
 - writeBOLSIGinput              void        Write the BOLSIG+ inpur file.
-- countBolsigReactions          int         Count how many reactions exist in the BOLSIG+ cross section file.
+- parseReactionLabel            void        Convert a "REACTION:" label of the cross-section file to reaction/subreaction numbers.
+- readCrossSections             void        Read the reactions of the cross-section file once, in an in-memory reaction index.
 - mapRateCoeffs                 void        Sort the reactions written in the BOLSI+ cross section file in the correct order.
-- readRateCoeff                 void        Read the rate constants from the BOLSIG+ output file.
-- readThresholdEnergies         void        Read the threshold energies from the BOLSIG+ output file.
-- calculateTe                   double      Calculate the electron temperature Te from the BOLSIG+ output file.
+- mapFile                       char*       Map a file in memory for reading.
+- unmapFile                     void        Release a file that was mapped with mapFile.
+- readBOLSIGoutput              bool        Read the results of the BOLSIG+ output file in a single pass.
+- storeBOLSIGresults            double      Store the BOLSIG+ rate coefficients and threshold energies and calculate Te.
 - relativeError                 double      Calculate the reletive error between the two input values.
 - printScreen_beginning         void        Display in screen the initial information of the simulation.
 - printScreen_K_Ethr            void        Display in screen the reaction rates or/and the threshold energies.
@@ -55,6 +61,56 @@ void allocate_double (double*** arr, int row, int col)
 #define allocate(arr, row, col ) _Generic(arr, int***: allocate_int, double***: allocate_double)(arr, row, col)
 
 
+// --------------------------------------------------------------------------------------------------------
+// Check if the messages of a verbosity level are printed. The warnings are printed by the points of a sweep
+// too, the other levels only when the screen output is enabled.
+// --------------------------------------------------------------------------------------------------------
+bool logEnabled (int level)
+{
+    return verbosity >= level && (printScreenOutput || level <= LOG_WARNING);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Print a message of a verbosity level, with the format of printf. The warnings are counted, also when they
+// are not printed.
+// --------------------------------------------------------------------------------------------------------
+void logMessage (int level, const char *format, ...)
+{
+    // Local variables
+    va_list arguments;
+
+    if (level == LOG_WARNING)
+        warningCount++;
+    if (!logEnabled(level))
+        return;
+
+    va_start(arguments, format);
+    vprintf(format, arguments);
+    va_end(arguments);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Report an error of a solver during the solution, with the format of printf. The program is not terminated,
+// so that the library does not exit the host program: the solver keeps its previous values and the outer
+// iterations stop at the end of the current iteration with the status SOLUTION_FAILED (see convergence.h).
+// --------------------------------------------------------------------------------------------------------
+void solverError (const char *format, ...)
+{
+    // Local variables
+    va_list arguments;
+
+    solverFailed = true;
+    if (!logEnabled(LOG_ERROR))
+        return;
+
+    va_start(arguments, format);
+    vprintf(format, arguments);
+    va_end(arguments);
+}
+
+
 // --------------------------------------------------------------------------------------------------------
 // Read variables from the input file
 // --------------------------------------------------------------------------------------------------------
@@ -96,6 +152,7 @@ void readfile (char filename[MAXCHAR])
             while (str[0] != ';')
             {
                 NoNeutralSpecies++;
+                neutralSpecies = realloc(neutralSpecies, NoNeutralSpecies*sizeof(*neutralSpecies));
                 if (str[strlen(str)-1] == ';')
                 {
                     str[strlen(str)-1] = '\0';
@@ -432,640 +489,1482 @@ void readfile (char filename[MAXCHAR])
             }
         }
 
-        if (strcmp(str,"DH12") == 0)
+        if (strcmp(str,"mechanism") == 0)
         {
             fscanf(fp, "%s", str);
             if (str[strlen(str)-1] == ';')
             {
                 str[strlen(str)-1] = '\0';
-                DH12 = atof(str)*eVtoJ;
+                strcpy(mechanismFile, str);
             }
             else
             {
                 fscanf(fp, "%s", str_local);
                 if (str_local[0] == ';')
-                    DH12 = atof(str)*eVtoJ;
+                    strcpy(mechanismFile, str);
             }
         }
 
-        if (strcmp(str,"DH13") == 0)
+        if (strcmp(str,"epsilon") == 0)
         {
             fscanf(fp, "%s", str);
             if (str[strlen(str)-1] == ';')
             {
                 str[strlen(str)-1] = '\0';
-                DH13 = atof(str)*eVtoJ;
+                epsilon = atof(str);
             }
             else
             {
                 fscanf(fp, "%s", str_local);
                 if (str_local[0] == ';')
-                    DH13 = atof(str)*eVtoJ;
+                    epsilon = atof(str);
             }
         }
 
-        if (strcmp(str,"DH14") == 0)
+        if (strcmp(str,"Tatm") == 0)
         {
             fscanf(fp, "%s", str);
             if (str[strlen(str)-1] == ';')
             {
                 str[strlen(str)-1] = '\0';
-                DH14 = atof(str)*eVtoJ;
+                Tatm = atof(str);
             }
             else
             {
                 fscanf(fp, "%s", str_local);
                 if (str_local[0] == ';')
-                    DH14 = atof(str)*eVtoJ;
+                    Tatm = atof(str);
             }
         }
 
-        if (strcmp(str,"epsilon") == 0)
+        if (strcmp(str,"patm") == 0)
         {
             fscanf(fp, "%s", str);
             if (str[strlen(str)-1] == ';')
             {
                 str[strlen(str)-1] = '\0';
-                epsilon = atof(str);
+                patm = atof(str);
             }
             else
             {
                 fscanf(fp, "%s", str_local);
                 if (str_local[0] == ';')
-                    epsilon = atof(str);
+                    patm = atof(str);
             }
         }
 
-        if (strcmp(str,"Tatm") == 0)
+
+        if (strcmp(str,"BOLSIG_input") == 0)
         {
             fscanf(fp, "%s", str);
             if (str[strlen(str)-1] == ';')
             {
                 str[strlen(str)-1] = '\0';
-                Tatm = atof(str);
+                strcpy(BOLSIG_input, str);
             }
             else
             {
                 fscanf(fp, "%s", str_local);
                 if (str_local[0] == ';')
-                    Tatm = atof(str);
+                    strcpy(BOLSIG_input, str);
             }
         }
 
-        if (strcmp(str,"patm") == 0)
+        if (strcmp(str,"BOLSIG_output") == 0)
         {
             fscanf(fp, "%s", str);
             if (str[strlen(str)-1] == ';')
             {
                 str[strlen(str)-1] = '\0';
-                patm = atof(str);
+                strcpy(BOLSIG_output, str);
             }
             else
             {
                 fscanf(fp, "%s", str_local);
                 if (str_local[0] == ';')
-                    patm = atof(str);
+                    strcpy(BOLSIG_output, str);
             }
         }
 
-
-        if (strcmp(str,"BOLSIG_input") == 0)
+        if (strcmp(str,"BOLSIG_crossSections") == 0)
         {
             fscanf(fp, "%s", str);
             if (str[strlen(str)-1] == ';')
             {
                 str[strlen(str)-1] = '\0';
-                strcpy(BOLSIG_input, str);
+                strcpy(BOLSIG_crossSections, str);
             }
             else
             {
                 fscanf(fp, "%s", str_local);
                 if (str_local[0] == ';')
-                    strcpy(BOLSIG_input, str);
+                    strcpy(BOLSIG_crossSections, str);
             }
         }
 
-        if (strcmp(str,"BOLSIG_output") == 0)
+        if (strcmp(str,"BOLSIG_cache") == 0)
         {
             fscanf(fp, "%s", str);
             if (str[strlen(str)-1] == ';')
             {
                 str[strlen(str)-1] = '\0';
-                strcpy(BOLSIG_output, str);
+                strcpy(BOLSIG_cache, str);
             }
             else
             {
                 fscanf(fp, "%s", str_local);
                 if (str_local[0] == ';')
-                    strcpy(BOLSIG_output, str);
+                    strcpy(BOLSIG_cache, str);
             }
         }
 
-        if (strcmp(str,"BOLSIG_crossSections") == 0)
+        if (strcmp(str,"verbosity") == 0)
         {
             fscanf(fp, "%s", str);
             if (str[strlen(str)-1] == ';')
             {
                 str[strlen(str)-1] = '\0';
-                strcpy(BOLSIG_crossSections, str);
+                verbosity = atoi(str);
             }
             else
             {
                 fscanf(fp, "%s", str_local);
                 if (str_local[0] == ';')
-                    strcpy(BOLSIG_crossSections, str);
+                    verbosity = atoi(str);
             }
         }
 
-        if (strcmp(str,"printScreenK") == 0)
+        if (strcmp(str,"historyOutput") == 0)
         {
             fscanf(fp, "%s", str);
             if (str[strlen(str)-1] == ';')
             {
                 str[strlen(str)-1] = '\0';
-                if (strcmp(str,"true") == 0 || strcmp(str,"TRUE") == 0 || strcmp(str,"True") == 0 )
-                    printScreenK = true;
-                else if (strcmp(str,"false") == 0 || strcmp(str,"FALSE") == 0 || strcmp(str,"False") == 0 )
-                    printScreenK = false;
-                else
-                {
-                    printf("ERROR\n");
-                }
+                strcpy(historyOutput, str);
             }
             else
             {
                 fscanf(fp, "%s", str_local);
                 if (str_local[0] == ';')
-                {
-                    if (strcmp(str,"true") == 0 || strcmp(str,"TRUE") == 0 || strcmp(str,"True") == 0 )
-                        printScreenK = true;
-                    else if (strcmp(str,"false") == 0 || strcmp(str,"FALSE") == 0 || strcmp(str,"False") == 0 )
-                        printScreenK = false;
-                    else
-                    {
-                    printf("Error: Unknown input value in printScreenK in the file: input.txt\n");
-                    exit(EXIT_FAILURE);
-                    }
-                }
+                    strcpy(historyOutput, str);
             }
         }
 
-        if (strcmp(str,"printScreenEthr") == 0)
+        if (strcmp(str,"historyFormat") == 0)
         {
             fscanf(fp, "%s", str);
             if (str[strlen(str)-1] == ';')
             {
                 str[strlen(str)-1] = '\0';
-                if (strcmp(str,"true") == 0 || strcmp(str,"TRUE") == 0 || strcmp(str,"True") == 0 )
-                    printScreenEthr = true;
-                else if (strcmp(str,"false") == 0 || strcmp(str,"FALSE") == 0 || strcmp(str,"False") == 0 )
-                    printScreenEthr = false;
-                else
-                {
-                    printf("Error: Unknown input value in printScreenEthr in the file: input.txt\n");
-                    exit(EXIT_FAILURE);
-                }
+                strcpy(historyFormat, str);
             }
             else
             {
                 fscanf(fp, "%s", str_local);
                 if (str_local[0] == ';')
-                {
-                    if (strcmp(str,"true") == 0 || strcmp(str,"TRUE") == 0 || strcmp(str,"True") == 0 )
-                        printScreenEthr = true;
-                    else if (strcmp(str,"false") == 0 || strcmp(str,"FALSE") == 0 || strcmp(str,"False") == 0 )
-                        printScreenEthr = false;
-                    else
-                    {
-                        printf("ERROR\n");
-                    }
-                }
+                    strcpy(historyFormat, str);
+            }
+            if (strcmp(historyFormat,"CSV") != 0 && strcmp(historyFormat,"binary") != 0)
+            {
+                printf("Error: Unknown input value in historyFormat in the file: input.txt. Availiable formats: CSV or binary.\n");
+                exit(EXIT_FAILURE);
             }
         }
 
-
-    }
-
-    // Close file
-    fclose(fp);
-}
-
-
-// --------------------------------------------------------------------------------------------------------
-// Write VOLSIG input file
-// --------------------------------------------------------------------------------------------------------
-void writeBOLSIGinput ()
-{
-    // Open file
-    FILE * fp;
-    fp = fopen(BOLSIG_input,"w");
-
-    fprintf(fp, "! Comment\n");
-    fprintf(fp, "/ Comment\n");
-    fprintf(fp, "\n");
-
-    fprintf(fp, "/NOSCREEN\n");
-    fprintf(fp, "\n");
-
-    fprintf(fp, "CLEARCOLLISIONS\n");
-    fprintf(fp, "\n");
-
-    fprintf(fp, "READCOLLISIONS\n");
-    fprintf(fp, "%s\t\t/ File\n", BOLSIG_crossSections);
-    for (i=0 ; i<NoNeutralSpecies ; i++)
-        fprintf(fp, "%s\t", neutralSpecies[i]);
-    fprintf(fp, "\t\t\t\t/ Species\n");
-    fprintf(fp, "%d\t\t\t\t\t\t/ Extrapolate: 0= No 1= Yes\n", 1);
-    fprintf(fp, "\n");
-
-    fprintf(fp, "CONDITIONS\n");
-    fprintf(fp, "%.4lf\t\t\t\t\t/ Electric field / N (Td) \n", Vm2toTd*E/(nH+nH2));
-    fprintf(fp, "%.4e\t\t\t\t/ Angular field frequency / N (m3/s) \n", freq/(nH+nH2));
-    fprintf(fp, "0.0\t\t\t\t\t\t/ Cosine of E-B field angle  \n");
-    fprintf(fp, "%.2lf\t\t\t\t\t/ Gas temperature (K)  \n",Tg);
-    fprintf(fp, "0.0\t\t\t\t\t\t/ Excitation temperature (K)\n");
-    fprintf(fp, "0.0\t\t\t\t\t\t/ Transition energy (eV)\n");
-    fprintf(fp, "%.4e\t\t\t\t/ Ionization degree \n", fabs(ne/(nH+nH2)));
-    // fprintf(fp, "%.4e\t\t\t\t/ Ionization degree \n", 0.0);
-    // fprintf(fp, "%.1e\t\t\t\t\t/ Plasma density (1/m3) \n",n);
-    fprintf(fp, "%.1e\t\t\t\t\t/ Plasma density (1/m3) \n",ne);
-    fprintf(fp, "%.1f\t\t\t\t\t\t/ Ion charge parameter \n",1.0);
-    fprintf(fp, "%.4e\t\t\t\t/ Ion/neutral mass ratio \n", ((nHplus+nH2plus+nH3plus)/(nHplus/mH+nH2plus/mH2+nH3plus/mH3))*((nH/n)/mH+(nH2/n)/mH2) );
-    // fprintf(fp, "%.4e\t\t\t\t/ Ion/neutral mass ratio \n", 1.0 );
-    // fprintf(fp, "%.4e\t\t\t\t/ Ion/neutral mass ratio \n", (nHplus/mH + nH2plus/mH2 + nH3plus/mH3)/(nH/mH + nH2/mH2) );
-    fprintf(fp, "%d\t\t\t\t\t\t/ e-e momentum effects: 0=No; 1=Yes* \n",0);
-    fprintf(fp, "%d\t\t\t\t\t\t/ Energy sharing: 1=Equal*; 2=One takes all \n", 1);
-    fprintf(fp, "%d\t\t\t\t\t\t/ Growth: 1=Temporal*; 2=Spatial; 3=Not included; 4=Grad-n expansion \n", 1);
-    fprintf(fp, "%.1f\t\t\t\t\t\t/ Maxwellian mean energy (eV) \n", 0.0);
-    fprintf(fp, "%d\t\t\t\t\t\t/ # of grid points \n", 200);
-    fprintf(fp, "%d\t\t\t\t\t\t/ Manual grid: 0=No; 1=Linear; 2=Parabolic \n", 0);
-    fprintf(fp, "%.1f\t\t\t\t\t\t/ Manual maximum energy (eV) \n", 1.0);
-    fprintf(fp, "%.1e\t\t\t\t\t/ Precision \n", 1.0e-10);
-    fprintf(fp, "%.1e\t\t\t\t\t/ Convergence \n", 1.0e-4);
-    fprintf(fp, "%d\t\t\t\t\t/ Maximum # of iterations \n", 2000);
-    fprintf(fp, "%f  %f\t\t/ Gas composition fractions \n", nH2/(nH+nH2), nH/(nH+nH2) );
-    fprintf(fp, "%d\t\t\t\t\t\t/ Normalize composition to unity: 0=No; 1=Yes \n", 1);
-    fprintf(fp, "\n");
-
-    fprintf(fp, "RUN\n");
-    fprintf(fp, "\n");
-
-    fprintf(fp, "SAVERESULTS\n");
-    fprintf(fp, "%s\t\t/ File\n", BOLSIG_output);
-    fprintf(fp, "%d\t\t\t\t\t\t/ Format: 1=Run by run; 2=Combined; 3=E/N; 4=Energy; 5=SIGLO; 6=PLASIMO\n", 1);
-    fprintf(fp, "%d\t\t\t\t\t\t/ Conditions: 0=No; 1=Yes\n", 1);
-    fprintf(fp, "%d\t\t\t\t\t\t/ Transport coefficients: 0=No; 1=Yes\n", 1);
-    fprintf(fp, "%d\t\t\t\t\t\t/ Rate coefficients: 0=No; 1=Yes\n", 1);
-    fprintf(fp, "%d\t\t\t\t\t\t/ Reverse rate coefficients: 0=No; 1=Yes\n", 0);
-    fprintf(fp, "%d\t\t\t\t\t\t/ Energy loss coefficients: 0=No; 1=Yes\n", 0);
-    fprintf(fp, "%d\t\t\t\t\t\t/ Distribution function: 0=No; 1=Yes\n", 0);
-    fprintf(fp, "%d\t\t\t\t\t\t/ Skip failed runs: 0=No; 1=Yes\n", 0);
-    fprintf(fp, "\n");
-
-    fprintf(fp, "END\n");
-
-    fclose(fp);
-}
-
-// --------------------------------------------------------------------------------------------------------
-// Correspond reaction number in BOLSIG+ with reaction number in reference paper
-// --------------------------------------------------------------------------------------------------------
-int countBolsigReactions ()
-{
-    // Local variables
-    int count_R=0;
-
-    // Open file
-    FILE * fp;
-    fp = fopen(BOLSIG_crossSections,"r");
-
-    // Read line-by-line the crossSection file
-    while (fgets(str, MAXCHAR, fp) != NULL)
-    {
-        // Delete '\n' character from string
-        str[strcspn(str, "\n")] = 0;
-
-        // Count the reactions
-        if (strcmp(str,"ELASTIC")==0 || strcmp(str,"EFFECTIVE")==0 || strcmp(str,"IONIZATION")==0 || strcmp(str,"ATTACHMENT")==0 || strcmp(str,"EXCITATION")==0 || strcmp(str,"ROTATION")==0)
-            count_R++;
-    }
-
-    // Close file
-    fclose(fp);
-
-    // Return the number of reactions
-    return (count_R+1);
-}
-
-
-// --------------------------------------------------------------------------------------------------------
-// Correspond reaction number in BOLSIG+ with reaction number in reference paper
-// --------------------------------------------------------------------------------------------------------
-void mapRateCoeffs (int **array_map)
-{
-    // Local variables
-    char reaction_str[MAXCHAR], subreaction_str[MAXCHAR];
-    int count_R=0;
-    char str_species[MAXCHAR], str_local[MAXCHAR];
-    int *array_species;
-    int **array_map_temp;
-
-    // Allocate local arrays
-    array_species = (int*) calloc(count_BOLSIG, sizeof(int));
-    allocate(&array_map_temp, count_BOLSIG, 2);
-
-    // Open file
-    FILE * fp;
-    fp = fopen(BOLSIG_crossSections,"r");
-
-    // Read line-by-line the crossSection file
-    count_R=0;
-    while (fgets(str, MAXCHAR, fp) != NULL)
-    {
-        // Delete '\n' character from string
-        str[strcspn(str, "\n")] = 0;
-
-        // Read the reaction and subreaction number
-        if (strcmp(str,"ELASTIC")==0 || strcmp(str,"EFFECTIVE")==0 || strcmp(str,"IONIZATION")==0 || strcmp(str,"ATTACHMENT")==0 || strcmp(str,"EXCITATION")==0 || strcmp(str,"ROTATION")==0)
+        if (strcmp(str,"profileOutput") == 0)
         {
-            // Count reactions as they appear in BOLSIG+ cross-section file
-            count_R++;
-
-            // Determine the neutral species of each reaction 
-            fscanf(fp, "%s", str_species);
-
-            // Check if there are more neutral spieces in the cross-sections file tham in the input file
-            for (i=0 ; i<NoNeutralSpecies ; i++)
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
             {
-                if (strcmp(str_species,neutralSpecies[i]) == 0)
-                {
-                    break;
-                }
-                if (i == NoNeutralSpecies-1)
-                {
-                    printf("Error: Unknown neutral species in a reaction in the file: %s\n", BOLSIG_crossSections);
-                    exit(EXIT_FAILURE);
-                }
+                str[strlen(str)-1] = '\0';
+                strcpy(profileOutput, str);
             }
-
-            // Search for the "REACTION:" entry of the reaction
-            fscanf(fp, "%s", str);
-            while (!feof(fp))
+            else
             {
-                strncpy(str_local,str,8);   // check for the 'REACTION' word inside the cross section info of each reaction
-                str_local[8] = 0;   // terminate the string at the 8th position
-                if (strcmp(str_local,"REACTION") == 0)
-                {
-                    // Clear the strings contents (optional)
-                    memset(reaction_str,'\0', strlen(reaction_str));
-                    memset(subreaction_str,'\0', strlen(subreaction_str));
-
-                    // Read the rest of the line that begins with "REACTION:"
-                    fgets(str, MAXCHAR, fp);
-
-                    // Read every character of the rest of the line and determine which one is for the reaction and which the subreaction
-                    i=0;
-                    j=0;
-                    k=0;
-                    while (str[i]!='\n')
-                    {
-                        // If the character is one of the following characters, ignore it
-                        if (str[i]==' ' || str[i]==':' || str[i]=='-' || str[i]==',' || str[i]=='(' || str[i]==')' || str[i]=='[' || str[i]==']' || str[i]=='_')
-                        {
-                            i++;
-                            continue;
-                        }
-
-                        // Check is the character is digit of letter
-                        if (isdigit(str[i]))
-                        {
-                            reaction_str[j]=str[i];
-                            j++;
-                        }
-                        else if (isalpha(str[i]))
-                        {
-                            subreaction_str[k]=str[i];
-                            k++;
-                        }
-                        else
-                        {
-                            printf("Error: Unknown character '%c' in reaction No.%d in the file: %s\n",str[i],count_R,BOLSIG_output);
-                            exit(EXIT_FAILURE);
-                        }
-
-                        // Go to the next character
-                        i++;
-                    }
-
-                    // End strings with the end character '\n' to avoid errors
-                    reaction_str[j] = 0;
-                    subreaction_str[k] = 0;
-
-                    // Match the subreaction letters to numbers for the int-type array
-                    for (i=0 ; i<NoNeutralSpecies ; i++)
-                    {
-                        if (strcmp(str_species,neutralSpecies[i]) == 0)
-                        {
-                            // Correspond neutral species with reaction
-                            array_species[count_R] = i;
-
-                            // Convert the reaction number into int
-                            array_map_temp[count_R][0] = atoi(reaction_str);
-
-                            if (strcmp(subreaction_str,"") == 0);
-                            else if (strcmp(subreaction_str,"a") == 0 || strcmp(subreaction_str,"A") == 0)
-                                array_map_temp[count_R][1] = 1;
-                            else if (strcmp(subreaction_str,"b") == 0 || strcmp(subreaction_str,"B") == 0)
-                                array_map_temp[count_R][1] = 2;
-                            else if (strcmp(subreaction_str,"c") == 0 || strcmp(subreaction_str,"C") == 0)
-                                array_map_temp[count_R][1] = 3;
-                            else
-                            {
-                                printf("Error: Unknown character '%s' in a subreaction in the file: %s. Availiable subreactions: a, b or c.\n",subreaction_str,BOLSIG_crossSections);
-                                exit(EXIT_FAILURE);
-                            }
-                        }
-                    }
-
-                    // Go to another reaction
-                    break;
-                }
-                else
-                    fscanf(fp, "%s", str);
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(profileOutput, str);
             }
         }
-    }
 
-    // Put the reactions in the order that they appear in the BOLSIG output file
-    j=0;
-    for (i=0 ; i<NoNeutralSpecies ; i++)
-        for (count_R = 1; count_R < count_BOLSIG; count_R++)
-            if (array_species[count_R]==i)
+        if (strcmp(str,"profileTrace") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
             {
-                j++;
-                array_map[j][0] = array_map_temp[count_R][0];
-                array_map[j][1] = array_map_temp[count_R][1];
+                str[strlen(str)-1] = '\0';
+                strcpy(profileTrace, str);
             }
-
-
-    // Close file
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(profileTrace, str);
+            }
+        }
+
+        if (strcmp(str,"BOLSIG_speculation") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                BOLSIG_speculation = atof(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    BOLSIG_speculation = atof(str);
+            }
+        }
+
+        if (strcmp(str,"BOLSIG_speculationDepth") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                BOLSIG_speculationDepth = atoi(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    BOLSIG_speculationDepth = atoi(str);
+            }
+            if (BOLSIG_speculationDepth < 1 || BOLSIG_speculationDepth > MAXSPECULATIONDEPTH)
+            {
+                printf("Error: The value of BOLSIG_speculationDepth in the file: input.txt must be between 1 and %d.\n",MAXSPECULATIONDEPTH);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if (strcmp(str,"speciesSolver") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                strcpy(speciesSolver, str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(speciesSolver, str);
+            }
+            if (strcmp(speciesSolver,"SOR") != 0 && strcmp(speciesSolver,"Newton") != 0 && strcmp(speciesSolver,"Coupled") != 0)
+            {
+                printf("Error: Unknown input value in speciesSolver in the file: input.txt. Availiable solvers: SOR, Newton or Coupled.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if (strcmp(str,"energySolver") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                strcpy(energySolver, str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(energySolver, str);
+            }
+            if (strcmp(energySolver,"SOR") != 0 && strcmp(energySolver,"Newton") != 0)
+            {
+                printf("Error: Unknown input value in energySolver in the file: input.txt. Availiable solvers: SOR or Newton.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if (strcmp(str,"andersonDepth") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                andersonDepth = atoi(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    andersonDepth = atoi(str);
+            }
+        }
+
+        if (strcmp(str,"densityVariables") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                strcpy(densityVariables, str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(densityVariables, str);
+            }
+            if (strcmp(densityVariables,"Linear") != 0 && strcmp(densityVariables,"Log") != 0)
+            {
+                printf("Error: Unknown input value in densityVariables in the file: input.txt. Availiable variables: Linear or Log.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if (strcmp(str,"relaxationMethod") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                strcpy(relaxationMethod, str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(relaxationMethod, str);
+            }
+            if (strcmp(relaxationMethod,"Fixed") != 0 && strcmp(relaxationMethod,"Adaptive") != 0)
+            {
+                printf("Error: Unknown input value in relaxationMethod in the file: input.txt. Availiable methods: Fixed or Adaptive.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if (strcmp(str,"convergenceTolerance") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                convergenceTolerance = atof(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    convergenceTolerance = atof(str);
+            }
+        }
+
+        if (strcmp(str,"absoluteTolerance") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                absoluteTolerance = atof(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    absoluteTolerance = atof(str);
+            }
+        }
+
+        if (strcmp(str,"speciesTolerance") == 0)
+        {
+            if (NoSpeciesTolerances == MAXSPECIESTOLERANCES)
+            {
+                printf("Error: More than %d species tolerances in the file: input.txt\n",MAXSPECIESTOLERANCES);
+                exit(EXIT_FAILURE);
+            }
+
+            // Species name and relative tolerance, which is checked against the mechanism by initializeConvergence
+            fscanf(fp, "%s", speciesToleranceName[NoSpeciesTolerances]);
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                speciesToleranceValue[NoSpeciesTolerances++] = atof(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    speciesToleranceValue[NoSpeciesTolerances++] = atof(str);
+            }
+        }
+
+        if (strcmp(str,"maxIterations") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                maxIterations = atoi(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    maxIterations = atoi(str);
+            }
+        }
+
+        if (strcmp(str,"maxInnerIterations") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                maxInnerIterations = atoi(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    maxInnerIterations = atoi(str);
+            }
+        }
+
+        if (strcmp(str,"stagnationIterations") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                stagnationIterations = atoi(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    stagnationIterations = atoi(str);
+            }
+        }
+
+        if (strcmp(str,"boltzmannSolver") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                strcpy(boltzmannSolver, str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(boltzmannSolver, str);
+            }
+            if (strcmp(boltzmannSolver,"BOLSIG") != 0 && strcmp(boltzmannSolver,"TwoTerm") != 0 && strcmp(boltzmannSolver,"Compare") != 0 && strcmp(boltzmannSolver,"Table") != 0)
+            {
+                printf("Error: Unknown input value in boltzmannSolver in the file: input.txt. Availiable solvers: BOLSIG, TwoTerm, Table or Compare.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if (strcmp(str,"sweep") == 0)
+        {
+            if (NoSweeps == MAXSWEEPS)
+            {
+                printf("Error: More than %d sweep variables in the file: input.txt\n",MAXSWEEPS);
+                exit(EXIT_FAILURE);
+            }
+
+            // Variable name and values until the semicolon
+            fscanf(fp, "%s", sweepVariable[NoSweeps]);
+            NoSweepValues[NoSweeps] = 0;
+            while (fscanf(fp, "%s", str) == 1)
+            {
+                bool last = (str[strlen(str)-1] == ';');
+                if (last)
+                    str[strlen(str)-1] = '\0';
+                if (strlen(str) > 0)
+                {
+                    if (NoSweepValues[NoSweeps] == MAXSWEEPVALUES)
+                    {
+                        printf("Error: More than %d values of the sweep variable %s in the file: input.txt\n",MAXSWEEPVALUES,sweepVariable[NoSweeps]);
+                        exit(EXIT_FAILURE);
+                    }
+                    strcpy(sweepValues[NoSweeps][NoSweepValues[NoSweeps]++], str);
+                }
+                if (last)
+                    break;
+            }
+
+            // A range of values is given as: range start end points
+            if (NoSweepValues[NoSweeps] > 0 && strcmp(sweepValues[NoSweeps][0],"range") == 0)
+            {
+                double start = atof(sweepValues[NoSweeps][1]), end = atof(sweepValues[NoSweeps][2]);
+                int points = atoi(sweepValues[NoSweeps][3]);
+                if (NoSweepValues[NoSweeps] != 4 || points < 1 || points > MAXSWEEPVALUES)
+                {
+                    printf("Error: Wrong range of the sweep variable %s in the file: input.txt. The range is given as: range start end points\n",sweepVariable[NoSweeps]);
+                    exit(EXIT_FAILURE);
+                }
+                for (i=0 ; i<points ; i++)
+                    sprintf(sweepValues[NoSweeps][i], "%.6g", (points > 1) ? start + (end-start)*i/(points-1) : start);
+                NoSweepValues[NoSweeps] = points;
+            }
+
+            if (NoSweepValues[NoSweeps] == 0)
+            {
+                printf("Error: No values of the sweep variable %s in the file: input.txt\n",sweepVariable[NoSweeps]);
+                exit(EXIT_FAILURE);
+            }
+            NoSweeps++;
+        }
+
+        if (strcmp(str,"sweepThreads") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                sweepThreads = atoi(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    sweepThreads = atoi(str);
+            }
+        }
+
+        if (strcmp(str,"sweepOutput") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                strcpy(sweepOutput, str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(sweepOutput, str);
+            }
+        }
+
+        if (strcmp(str,"continuation") == 0)
+        {
+            // Parameter name, start value, end value and initial step until the semicolon
+            double values[3];
+            int NoValues=0;
+            fscanf(fp, "%s", continuationParameter);
+            while (fscanf(fp, "%s", str) == 1)
+            {
+                bool last = (str[strlen(str)-1] == ';');
+                if (last)
+                    str[strlen(str)-1] = '\0';
+                if (strlen(str) > 0 && NoValues < 3)
+                    values[NoValues] = atof(str);
+                if (strlen(str) > 0)
+                    NoValues++;
+                if (last)
+                    break;
+            }
+            if (NoValues != 3 || values[2] == 0.0)
+            {
+                printf("Error: Wrong continuation of the parameter %s in the file: input.txt. It is given as: continuation parameter start end step\n",continuationParameter);
+                exit(EXIT_FAILURE);
+            }
+            continuationStart = values[0];
+            continuationEnd = values[1];
+            continuationStep = fabs(values[2]);
+            useContinuation = true;
+        }
+
+        if (strcmp(str,"continuationMethod") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                strcpy(continuationMethod, str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(continuationMethod, str);
+            }
+        }
+
+        if (strcmp(str,"continuationOutput") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                strcpy(continuationOutput, str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(continuationOutput, str);
+            }
+        }
+
+        if (strcmp(str,"transientTimes") == 0)
+        {
+            // Output times until the semicolon, or a range of times given as: log start end points, or
+            // linear start end points
+            double values[MAXTRANSIENTTIMES];
+            char spacing[MAXCHAR]="";
+            int NoValues=0, points;
+            while (fscanf(fp, "%s", str) == 1)
+            {
+                bool last = (str[strlen(str)-1] == ';');
+                if (last)
+                    str[strlen(str)-1] = '\0';
+                if (strlen(str) > 0)
+                {
+                    if (NoValues == 0 && spacing[0] == '\0' && (strcmp(str,"log") == 0 || strcmp(str,"linear") == 0))
+                        strcpy(spacing, str);
+                    else if (NoValues == MAXTRANSIENTTIMES)
+                    {
+                        printf("Error: More than %d transient output times in the file: input.txt\n",MAXTRANSIENTTIMES);
+                        exit(EXIT_FAILURE);
+                    }
+                    else
+                        values[NoValues++] = atof(str);
+                }
+                if (last)
+                    break;
+            }
+
+            if (spacing[0] != '\0')
+            {
+                points = (NoValues == 3) ? (int)values[2] : 0;
+                if (NoValues != 3 || points < 1 || points > MAXTRANSIENTTIMES || (strcmp(spacing,"log") == 0 && values[0] <= 0.0))
+                {
+                    printf("Error: Wrong range of the transient output times in the file: input.txt. The range is given as: log start end points, or linear start end points\n");
+                    exit(EXIT_FAILURE);
+                }
+                for (i=0 ; i<points ; i++)
+                {
+                    if (points == 1)
+                        transientTime[i] = values[1];
+                    else if (strcmp(spacing,"log") == 0)
+                        transientTime[i] = values[0]*pow(values[1]/values[0], (double)i/(points-1));
+                    else
+                        transientTime[i] = values[0] + (values[1]-values[0])*i/(points-1);
+                }
+                NoTransientTimes = points;
+            }
+            else
+            {
+                for (i=0 ; i<NoValues ; i++)
+                    transientTime[i] = values[i];
+                NoTransientTimes = NoValues;
+            }
+
+            if (NoTransientTimes == 0)
+            {
+                printf("Error: No transient output times in the file: input.txt\n");
+                exit(EXIT_FAILURE);
+            }
+            for (i=0 ; i<NoTransientTimes ; i++)
+                if (transientTime[i] < 0.0 || (i > 0 && transientTime[i] <= transientTime[i-1]))
+                {
+                    printf("Error: The transient output times must be positive and increasing in the file: input.txt\n");
+                    exit(EXIT_FAILURE);
+                }
+        }
+
+        if (strcmp(str,"transientEvent") == 0)
+        {
+            if (NoTransientEvents == MAXTRANSIENTEVENTS)
+            {
+                printf("Error: More than %d transient events in the file: input.txt\n",MAXTRANSIENTEVENTS);
+                exit(EXIT_FAILURE);
+            }
+
+            // Time, parameter and new value until the semicolon
+            fscanf(fp, "%s", str);
+            transientEventTime[NoTransientEvents] = atof(str);
+            fscanf(fp, "%s", transientEventParameter[NoTransientEvents]);
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+                str[strlen(str)-1] = '\0';
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] != ';')
+                    strcpy(str, "");
+            }
+            if (strlen(str) == 0)
+            {
+                printf("Error: Wrong transient event in the file: input.txt. It is given as: transientEvent time parameter value\n");
+                exit(EXIT_FAILURE);
+            }
+            transientEventValue[NoTransientEvents] = atof(str);
+
+            if (strcmp(transientEventParameter[NoTransientEvents],"pin") != 0 && strcmp(transientEventParameter[NoTransientEvents],"Tgi") != 0 &&
+                strcmp(transientEventParameter[NoTransientEvents],"Qi") != 0 && strcmp(transientEventParameter[NoTransientEvents],"E") != 0)
+            {
+                printf("Error: The parameter %s of the transient event is not one of: pin, Tgi, Qi, E\n",transientEventParameter[NoTransientEvents]);
+                exit(EXIT_FAILURE);
+            }
+            if (NoTransientEvents > 0 && transientEventTime[NoTransientEvents] < transientEventTime[NoTransientEvents-1])
+            {
+                printf("Error: The transient events must be given in the order of their times in the file: input.txt\n");
+                exit(EXIT_FAILURE);
+            }
+            NoTransientEvents++;
+        }
+
+        if (strcmp(str,"transientTolerance") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                transientTolerance = atof(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    transientTolerance = atof(str);
+            }
+        }
+
+        if (strcmp(str,"transientOutput") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                strcpy(transientOutput, str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(transientOutput, str);
+            }
+        }
+
+        if (strcmp(str,"pulseWaveform") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                strcpy(pulseWaveform, str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(pulseWaveform, str);
+            }
+        }
+
+        if (strcmp(str,"pulseVariable") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                strcpy(pulseVariable, str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(pulseVariable, str);
+            }
+        }
+
+        if (strcmp(str,"pulseFrequency") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                pulseFrequency = atof(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    pulseFrequency = atof(str);
+            }
+        }
+
+        if (strcmp(str,"pulseDutyCycle") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                pulseDutyCycle = atof(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    pulseDutyCycle = atof(str);
+            }
+        }
+
+        if (strcmp(str,"pulseDepth") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                pulseDepth = atof(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    pulseDepth = atof(str);
+            }
+        }
+
+        if (strcmp(str,"pulseIterations") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                pulseIterations = atoi(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    pulseIterations = atoi(str);
+            }
+        }
+
+        if (strcmp(str,"pulseTolerance") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                pulseTolerance = atof(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    pulseTolerance = atof(str);
+            }
+        }
+
+        if (strcmp(str,"pulseSamples") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                pulseSamples = atoi(str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    pulseSamples = atoi(str);
+            }
+        }
+
+        if (strcmp(str,"pulseOutput") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                strcpy(pulseOutput, str);
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                    strcpy(pulseOutput, str);
+            }
+        }
+
+        if (strcmp(str,"printScreenK") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                if (strcmp(str,"true") == 0 || strcmp(str,"TRUE") == 0 || strcmp(str,"True") == 0 )
+                    printScreenK = true;
+                else if (strcmp(str,"false") == 0 || strcmp(str,"FALSE") == 0 || strcmp(str,"False") == 0 )
+                    printScreenK = false;
+                else
+                {
+                    printf("ERROR\n");
+                }
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                {
+                    if (strcmp(str,"true") == 0 || strcmp(str,"TRUE") == 0 || strcmp(str,"True") == 0 )
+                        printScreenK = true;
+                    else if (strcmp(str,"false") == 0 || strcmp(str,"FALSE") == 0 || strcmp(str,"False") == 0 )
+                        printScreenK = false;
+                    else
+                    {
+                    printf("Error: Unknown input value in printScreenK in the file: input.txt\n");
+                    exit(EXIT_FAILURE);
+                    }
+                }
+            }
+        }
+
+        if (strcmp(str,"printScreenEthr") == 0)
+        {
+            fscanf(fp, "%s", str);
+            if (str[strlen(str)-1] == ';')
+            {
+                str[strlen(str)-1] = '\0';
+                if (strcmp(str,"true") == 0 || strcmp(str,"TRUE") == 0 || strcmp(str,"True") == 0 )
+                    printScreenEthr = true;
+                else if (strcmp(str,"false") == 0 || strcmp(str,"FALSE") == 0 || strcmp(str,"False") == 0 )
+                    printScreenEthr = false;
+                else
+                {
+                    printf("Error: Unknown input value in printScreenEthr in the file: input.txt\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            else
+            {
+                fscanf(fp, "%s", str_local);
+                if (str_local[0] == ';')
+                {
+                    if (strcmp(str,"true") == 0 || strcmp(str,"TRUE") == 0 || strcmp(str,"True") == 0 )
+                        printScreenEthr = true;
+                    else if (strcmp(str,"false") == 0 || strcmp(str,"FALSE") == 0 || strcmp(str,"False") == 0 )
+                        printScreenEthr = false;
+                    else
+                    {
+                        printf("ERROR\n");
+                    }
+                }
+            }
+        }
+
+
+    }
+
+    // Close file
     fclose(fp);
 }
 
 
 // --------------------------------------------------------------------------------------------------------
-// Read rate coefficients from BOLSIG++ output file
+// Return the file name of a path, without its directory
 // --------------------------------------------------------------------------------------------------------
-void readRateCoeff (double **K_local)
+const char *fileName (const char *path)
 {
     // Local variables
-    double K_value;
+    const char *name = strrchr(path, '/');
 
+    #ifdef _WIN32
+        if (strrchr(path, '\\') > name)
+            name = strrchr(path, '\\');
+    #endif
+
+    return (name != NULL) ? name+1 : path;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write VOLSIG input file
+// --------------------------------------------------------------------------------------------------------
+void writeBOLSIGinput ()
+{
     // Open file
     FILE * fp;
-    fp = fopen(BOLSIG_output,"r");
+    fp = fopen(BOLSIG_input,"w");
 
-    // Checκ if file exists
-    if (fp==NULL)
-    {
-        printf("Error: The file %s was not found!\n",BOLSIG_output);
-        exit(EXIT_FAILURE);
-    }
+    fprintf(fp, "! Comment\n");
+    fprintf(fp, "/ Comment\n");
+    fprintf(fp, "\n");
 
-    // Map rate coefficients according to the order they appear in the BOLSIG output file
-    mapRateCoeffs(map_reactions);
+    fprintf(fp, "/NOSCREEN\n");
+    fprintf(fp, "\n");
 
-    // Read line-by-line the BOLSIG output file
-    while (fgets(str, MAXCHAR, fp) != NULL)
-    {
-        str[strcspn(str, "\n")] = 0;
+    fprintf(fp, "CLEARCOLLISIONS\n");
+    fprintf(fp, "\n");
 
-        // Read the BOLSIG output  file coefficients
-        if (strcmp(str,"Rate coefficients (m3/s)") == 0)
-        {
-            for (i = 1; i < count_BOLSIG; i++)
-            {
-                fscanf(fp, "%s", str);
-                fscanf(fp, "%s", str);
-                fscanf(fp, "%s", str);
+    fprintf(fp, "READCOLLISIONS\n");
+    fprintf(fp, "%s\t\t/ File\n", fileName(BOLSIG_crossSections));
+    for (i=0 ; i<NoNeutralSpecies ; i++)
+        fprintf(fp, "%s\t", neutralSpecies[i]);
+    fprintf(fp, "\t\t\t\t/ Species\n");
+    fprintf(fp, "%d\t\t\t\t\t\t/ Extrapolate: 0= No 1= Yes\n", 1);
+    fprintf(fp, "\n");
 
-                if (strcmp(str,"Elastic") == 0)
-                {
-                    fscanf(fp, "%lf", &K_value);
-                }
-                else
-                {
-                    fscanf(fp, "%s", str);
-                    fscanf(fp, "%s", str);
-                    fscanf(fp, "%lf", &K_value);
-                }
-                K_local[map_reactions[i][0]][map_reactions[i][1]] = K_value;
-            }
+    fprintf(fp, "CONDITIONS\n");
+    fprintf(fp, "%.4lf\t\t\t\t\t/ Electric field / N (Td) \n", Vm2toTd*E/nNeutral);
+    fprintf(fp, "%.4e\t\t\t\t/ Angular field frequency / N (m3/s) \n", freq/nNeutral);
+    fprintf(fp, "0.0\t\t\t\t\t\t/ Cosine of E-B field angle  \n");
+    fprintf(fp, "%.2lf\t\t\t\t\t/ Gas temperature (K)  \n",Tg);
+    fprintf(fp, "0.0\t\t\t\t\t\t/ Excitation temperature (K)\n");
+    fprintf(fp, "0.0\t\t\t\t\t\t/ Transition energy (eV)\n");
+    fprintf(fp, "%.4e\t\t\t\t/ Ionization degree \n", fabs(ne/nNeutral));
+    // fprintf(fp, "%.4e\t\t\t\t/ Ionization degree \n", 0.0);
+    // fprintf(fp, "%.1e\t\t\t\t\t/ Plasma density (1/m3) \n",n);
+    fprintf(fp, "%.1e\t\t\t\t\t/ Plasma density (1/m3) \n",ne);
+    fprintf(fp, "%.1f\t\t\t\t\t\t/ Ion charge parameter \n",1.0);
+    fprintf(fp, "%.4e\t\t\t\t/ Ion/neutral mass ratio \n", ((nHplus+nH2plus+nH3plus)/(nHplus/mH+nH2plus/mH2+nH3plus/mH3))*((nH/n)/mH+(nH2/n)/mH2) );
+    // fprintf(fp, "%.4e\t\t\t\t/ Ion/neutral mass ratio \n", 1.0 );
+    // fprintf(fp, "%.4e\t\t\t\t/ Ion/neutral mass ratio \n", (nHplus/mH + nH2plus/mH2 + nH3plus/mH3)/(nH/mH + nH2/mH2) );
+    fprintf(fp, "%d\t\t\t\t\t\t/ e-e momentum effects: 0=No; 1=Yes* \n",0);
+    fprintf(fp, "%d\t\t\t\t\t\t/ Energy sharing: 1=Equal*; 2=One takes all \n", 1);
+    fprintf(fp, "%d\t\t\t\t\t\t/ Growth: 1=Temporal*; 2=Spatial; 3=Not included; 4=Grad-n expansion \n", 1);
+    fprintf(fp, "%.1f\t\t\t\t\t\t/ Maxwellian mean energy (eV) \n", 0.0);
+    fprintf(fp, "%d\t\t\t\t\t\t/ # of grid points \n", 200);
+    fprintf(fp, "%d\t\t\t\t\t\t/ Manual grid: 0=No; 1=Linear; 2=Parabolic \n", 0);
+    fprintf(fp, "%.1f\t\t\t\t\t\t/ Manual maximum energy (eV) \n", 1.0);
+    fprintf(fp, "%.1e\t\t\t\t\t/ Precision \n", 1.0e-10);
+    fprintf(fp, "%.1e\t\t\t\t\t/ Convergence \n", 1.0e-4);
+    fprintf(fp, "%d\t\t\t\t\t/ Maximum # of iterations \n", 2000);
+    for (i=0 ; i<NoNeutralSpecies ; i++)
+        fprintf(fp, (i == 0) ? "%f" : "  %f", neutralFraction[i]);
+    fprintf(fp, "\t\t/ Gas composition fractions \n");
+    fprintf(fp, "%d\t\t\t\t\t\t/ Normalize composition to unity: 0=No; 1=Yes \n", 1);
+    fprintf(fp, "\n");
+
+    fprintf(fp, "RUN\n");
+    fprintf(fp, "\n");
+
+    fprintf(fp, "SAVERESULTS\n");
+    fprintf(fp, "%s\t\t/ File\n", fileName(BOLSIG_output));
+    fprintf(fp, "%d\t\t\t\t\t\t/ Format: 1=Run by run; 2=Combined; 3=E/N; 4=Energy; 5=SIGLO; 6=PLASIMO\n", 1);
+    fprintf(fp, "%d\t\t\t\t\t\t/ Conditions: 0=No; 1=Yes\n", 1);
+    fprintf(fp, "%d\t\t\t\t\t\t/ Transport coefficients: 0=No; 1=Yes\n", 1);
+    fprintf(fp, "%d\t\t\t\t\t\t/ Rate coefficients: 0=No; 1=Yes\n", 1);
+    fprintf(fp, "%d\t\t\t\t\t\t/ Reverse rate coefficients: 0=No; 1=Yes\n", 0);
+    fprintf(fp, "%d\t\t\t\t\t\t/ Energy loss coefficients: 0=No; 1=Yes\n", 0);
+    fprintf(fp, "%d\t\t\t\t\t\t/ Distribution function: 0=No; 1=Yes\n", 0);
+    fprintf(fp, "%d\t\t\t\t\t\t/ Skip failed runs: 0=No; 1=Yes\n", 0);
+    fprintf(fp, "\n");
+
+    fprintf(fp, "END\n");
+
+    fclose(fp);
+}
+
+// --------------------------------------------------------------------------------------------------------
+// Convert the rest of a "REACTION:" line (e.g. " 18 a") to the reaction and subreaction numbers. The digits
+// form the reaction number and the letters the subreaction: a, b, ..., z are 1, 2, ..., 26, and the labels
+// continue with aa, ab, ... (27, 28, ...), as the columns of a spreadsheet. The case is ignored.
+// --------------------------------------------------------------------------------------------------------
+void parseReactionLabel (const char *label, int *reaction, int *subreaction)
+{
+    // Local variables
+    char reaction_str[MAXCHAR], subreaction_str[MAXCHAR];
+    int i, j=0, k=0;
 
+    for (i=0 ; label[i]!='\0' && label[i]!='\n' ; i++)
+    {
+        // If the character is one of the following characters, ignore it
+        if (label[i]==' ' || label[i]==':' || label[i]=='-' || label[i]==',' || label[i]=='(' || label[i]==')' || label[i]=='[' || label[i]==']' || label[i]=='_' || label[i]=='\r' || label[i]=='\t')
+            continue;
+
+        if (isdigit(label[i]))
+            reaction_str[j++] = label[i];
+        else if (isalpha(label[i]))
+            subreaction_str[k++] = label[i];
+        else
+        {
+            printf("Error: Unknown character '%c' in a reaction label in the file: %s\n",label[i],BOLSIG_crossSections);
+            exit(EXIT_FAILURE);
         }
     }
+    reaction_str[j] = 0;
+    subreaction_str[k] = 0;
 
-    // Close file
-    fclose(fp);
+    *reaction = atoi(reaction_str);
+    *subreaction = 0;
+    for (i=0 ; i<k ; i++)
+        *subreaction = 26*(*subreaction) + (tolower(subreaction_str[i]) - 'a' + 1);
 }
 
 
 // --------------------------------------------------------------------------------------------------------
-// Read threshold energies from BOLSIG++ corss-sections file
+// Read the collision processes of the LXcat cross-section file in memory, once at startup. This is the
+// reaction index that is used by the BOLSIG+ output parsers and the in-process Boltzmann solver.
 // --------------------------------------------------------------------------------------------------------
-void readThresholdEnergies (double** Ethr_local)
+void readCrossSections ()
 {
     // Local variables
-    double Ethr_value;
+    char line[MAXCHAR], str_species[MAXCHAR];
+    int i, size, capacity=16;
+    double energy_value, crossSec_value;
+    collisionProcess *process;
 
     // Open file
     FILE * fp;
-    fp = fopen(BOLSIG_output,"r");
+    fp = fopen(BOLSIG_crossSections,"r");
 
     // Checκ if file exists
     if (fp==NULL)
     {
-        printf("Error: The file %s was not found!\n",BOLSIG_output);
+        printf("Error: The file %s was not found!\n",BOLSIG_crossSections);
         exit(EXIT_FAILURE);
     }
 
-    // Map rate coefficients according to the order they appear in the BOLSIG output file
-    mapRateCoeffs(map_reactions);
+    collisions = (collisionProcess*) calloc(capacity, sizeof(collisionProcess));
+    NoCollisions = 0;
 
-    // Read line-by-line the BOLSIG output file
-    while (fgets(str, MAXCHAR, fp) != NULL)
+    // Read line-by-line the crossSection file
+    while (fgets(line, MAXCHAR, fp) != NULL)
     {
-        str[strcspn(str, "\n")] = 0;
+        // Delete the trailing whitespace characters from the string
+        for (i=strlen(line)-1 ; i>=0 && isspace(line[i]) ; i--)
+            line[i] = 0;
+
+        if (strcmp(line,"ELASTIC")!=0 && strcmp(line,"EFFECTIVE")!=0 && strcmp(line,"IONIZATION")!=0 && strcmp(line,"ATTACHMENT")!=0 && strcmp(line,"EXCITATION")!=0 && strcmp(line,"ROTATION")!=0)
+            continue;
 
-        // Read the BOLSIG output file threshold energies
-        if (strcmp(str,"Rate coefficients (m3/s)") == 0)
+        if (NoCollisions == capacity)
         {
-            for (i = 1; i < count_BOLSIG; i++)
-            {
-                fscanf(fp, "%s", str);
-                fscanf(fp, "%s", str);
-                fscanf(fp, "%s", str);
+            capacity *= 2;
+            collisions = (collisionProcess*) realloc(collisions, capacity*sizeof(collisionProcess));
+            memset(&collisions[NoCollisions], 0, (capacity-NoCollisions)*sizeof(collisionProcess));
+        }
 
-                if (strcmp(str,"Elastic") == 0)
-                    Ethr_value = 0.0;
-                else
-                    fscanf(fp, "%lf", &Ethr_value);
+        // The rotational excitations are treated as the other excitations
+        process = &collisions[NoCollisions++];
+        strcpy(process->type, (strcmp(line,"ROTATION") == 0) ? "EXCITATION" : line);
+
+        // Neutral species of the reaction
+        fgets(line, MAXCHAR, fp);
+        sscanf(line, "%s", str_species);
+        process->species = -1;
+        for (i=0 ; i<NoNeutralSpecies ; i++)
+            if (strcmp(str_species,neutralSpecies[i]) == 0)
+                process->species = i;
+        if (process->species < 0)
+        {
+            printf("Error: Unknown neutral species in a reaction in the file: %s\n", BOLSIG_crossSections);
+            exit(EXIT_FAILURE);
+        }
 
-                // Go to the next line
-                fgets(str, MAXCHAR, fp);
+        // Threshold energy or mass ratio. The attachment processes do not have this line.
+        if (strcmp(process->type,"ATTACHMENT") != 0)
+        {
+            fgets(line, MAXCHAR, fp);
+            process->param = atof(line);
+        }
 
-                // Insert the energies in the right position in the array in Joules
-                // Ethr_temp[map_reactions[i][0]][map_reactions[i][1]] = Ethr_value*eVtoJ;
-                Ethr_local[map_reactions[i][0]][map_reactions[i][1]] = Ethr_value*eVtoJ;
+        // Comment lines until the beginning of the table, where the reaction label is found
+        while (fgets(line, MAXCHAR, fp) != NULL && strncmp(line,"-----",5) != 0)
+            if (strncmp(line,"REACTION:",9) == 0)
+                parseReactionLabel(line+9, &process->reaction, &process->subreaction);
+
+        // Cross-section table
+        size = 64;
+        process->energy = (double*) calloc(size, sizeof(double));
+        process->crossSec = (double*) calloc(size, sizeof(double));
+        process->points = 0;
+        while (fgets(line, MAXCHAR, fp) != NULL && strncmp(line,"-----",5) != 0)
+        {
+            if (sscanf(line, "%lf %lf", &energy_value, &crossSec_value) != 2)
+                continue;
+            if (process->points == size)
+            {
+                size *= 2;
+                process->energy = (double*) realloc(process->energy, size*sizeof(double));
+                process->crossSec = (double*) realloc(process->crossSec, size*sizeof(double));
             }
-
+            process->energy[process->points] = energy_value;
+            process->crossSec[process->points] = crossSec_value;
+            process->points++;
         }
     }
 
     // Close file
     fclose(fp);
+
+    // Index of the reactions by their reaction and subreaction numbers
+    allocate(&collisionIndex, react_num, subreact_num);
+    for (i=0 ; i<react_num ; i++)
+        for (size=0 ; size<subreact_num ; size++)
+            collisionIndex[i][size] = -1;
+    for (i=0 ; i<NoCollisions ; i++)
+    {
+        if (collisions[i].reaction >= react_num || collisions[i].subreaction >= subreact_num)
+        {
+            printf("Error: The reaction %d of the file %s exceeds the size of the rate coefficient arrays!\n", collisions[i].reaction, BOLSIG_crossSections);
+            exit(EXIT_FAILURE);
+        }
+        collisionIndex[collisions[i].reaction][collisions[i].subreaction] = i;
+    }
+
+    // The number of reactions plus one, since the arrays of the BOLSIG+ output start from 1
+    count_BOLSIG = NoCollisions+1;
 }
 
 
 // --------------------------------------------------------------------------------------------------------
-// Read threshold energies from BOLSIG++ corss-sections file
+// Correspond reaction number in BOLSIG+ with reaction number in reference paper. BOLSIG+ writes the rate
+// coefficients grouped by neutral species, in the order of the neutral species in its input file.
 // --------------------------------------------------------------------------------------------------------
-double calculateTe()
+void mapRateCoeffs (int **array_map)
 {
     // Local variables
-    double Te_BOLSIG, Emean;
-    char str_local[MAXCHAR];
+    int l, count_R=0;
+
+    for (i=0 ; i<NoNeutralSpecies ; i++)
+        for (l=0 ; l<NoCollisions ; l++)
+            if (collisions[l].species == i)
+            {
+                count_R++;
+                array_map[count_R][0] = collisions[l].reaction;
+                array_map[count_R][1] = collisions[l].subreaction;
+            }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Map a file in memory for reading and return its contents and size. The memory is released with unmapFile.
+// Returns NULL if the file is missing, empty or cannot be read.
+// --------------------------------------------------------------------------------------------------------
+const char *mapFile (const char *filename, size_t *size)
+{
+    // Local variables
+    char *data;
 
     // Open file
     FILE * fp;
-    fp = fopen(BOLSIG_output,"r");
+    fp = fopen(filename,"rb");
 
-    // Read word-by-word the BOLSIG output file
-    while (!feof(fp))
+    // Checκ if file exists
+    *size = 0;
+    if (fp==NULL)
+        return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    if (*size == 0)
     {
-        // Clear string
-        memset(str,'\0', strlen(str));
+        fclose(fp);
+        return NULL;
+    }
 
-        // Read word
-        fscanf(fp, "%s", str);
-        if (strcmp(str, "Mean") == 0)
+    #ifdef _WIN32
+        data = (char*) malloc(*size);
+        fseek(fp, 0, SEEK_SET);
+        if (fread(data, 1, *size, fp) != *size)
         {
-            fscanf(fp, "%s", str);
-            if (strcmp(str, "energy") == 0)
+            free(data);
+            data = NULL;
+        }
+    #else
+        data = (char*) mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+        if (data == MAP_FAILED)
+            data = NULL;
+    #endif
+
+    // Close file, the mapping remains valid
+    fclose(fp);
+
+    return data;
+}
+
+void unmapFile (const char *data, size_t size)
+{
+    if (data == NULL)
+        return;
+
+    #ifdef _WIN32
+        free((char*) data);
+    #else
+        munmap((char*) data, size);
+    #endif
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Read the BOLSIG+ output file in a single pass, into the struct results: the mean energy, the transport
+// coefficients and the rate coefficients and threshold energies, in the order of the BOLSIG+ output file
+// (from 1 to count_BOLSIG-1). The file is mapped in memory and the numbers are converted in place. For a run
+// that did not finish (missing or non-numeric results) or did not converge, false is returned, and if report
+// is true it is a solver error (see solverError). The results of a speculative run are only validated.
+// --------------------------------------------------------------------------------------------------------
+bool readBOLSIGoutput (const char *file, bolsigResults *results, bool report)
+{
+    // Local variables
+    const char *data, *line, *end, *next, *ptr;
+    char *number_end;
+    size_t size, label_length;
+    bool transport=false, rates=false;
+    int l, count_R=0;
+    double value;
+
+    // Labels of the transport coefficients in the BOLSIG+ output file and their place in the struct
+    const struct { const char *label; size_t offset; } labels[] =
+    {
+        {"Mean energy (eV)",                  offsetof(bolsigResults, meanEnergy)},
+        {"Mobility *N (1/m/V/s)",             offsetof(bolsigResults, mobility)},
+        {"Diffusion coefficient *N (1/m/s)",  offsetof(bolsigResults, diffusion)},
+        {"Energy mobility *N (1/m/V/s)",      offsetof(bolsigResults, energyMobility)},
+        {"Energy diffusion coef. D*N (1/m/s)",offsetof(bolsigResults, energyDiffusion)},
+        {"Total collision freq. /N (m3/s)",   offsetof(bolsigResults, collisionFrequency)},
+        {"Momentum frequency /N (m3/s)",      offsetof(bolsigResults, momentumFrequency)},
+        {"Total ionization freq. /N (m3/s)",  offsetof(bolsigResults, ionizationFrequency)},
+        {"Power /N (eV m3/s)",                offsetof(bolsigResults, power)},
+        {"Elastic power loss /N (eV m3/s)",   offsetof(bolsigResults, elasticPower)},
+        {"Inelastic power loss /N (eV m3/s)", offsetof(bolsigResults, inelasticPower)},
+        {"Growth power /N (eV m3/s)",         offsetof(bolsigResults, growthPower)},
+        {"Coulomb logarithm",                 offsetof(bolsigResults, coulombLogarithm)},
+        {"Maximum energy",                    offsetof(bolsigResults, maxEnergy)},
+        {"# of iterations",                   offsetof(bolsigResults, iterations)},
+    };
+
+    data = mapFile(file, &size);
+    if (data == NULL || data[size-1] != '\n')
+    {
+        unmapFile(data, size);
+        if (report)
+            solverError("Error: The BOLSIG+ run failed, the file %s is empty or incomplete!\n",file);
+        return false;
+    }
+
+    results->meanEnergy = NAN;
+    results->maxIterations = 0.0;
+    results->iterations = 0.0;
+
+    // Every line ends with '\n', so the numbers can be converted directly in the mapped file
+    end = data + size;
+    for (line=data ; line<end ; line=next+1)
+    {
+        next = memchr(line, '\n', end-line);
+
+        // Skip the leading spaces
+        for (ptr=line ; ptr<next && *ptr==' ' ; ptr++);
+
+        if (rates)
+        {
+            // Rate coefficient lines: "C1    H2    Ionization    15.40 eV        0.9742E-17", and without
+            // the threshold energy for the elastic collisions
+            if (*ptr != 'C' || !isdigit(ptr[1]))
+                break;
+            count_R++;
+            if (count_R >= count_BOLSIG)
+                break;
+
+            // Skip the label, the species and the type of the reaction
+            for (l=0 ; l<3 ; l++)
+            {
+                while (ptr<next && *ptr!=' ') ptr++;
+                while (ptr<next && *ptr==' ') ptr++;
+            }
+
+            results->threshold[count_R] = 0.0;
+            value = strtod(ptr, &number_end);
+            if (number_end != ptr)
+            {
+                for (ptr=number_end ; ptr<next && *ptr==' ' ; ptr++);
+                if (ptr+2 <= next && strncmp(ptr, "eV", 2) == 0)
+                {
+                    results->threshold[count_R] = value;
+                    value = strtod(ptr+2, &number_end);
+                    if (number_end == ptr+2)
+                        value = NAN;
+                }
+            }
+            else
+                value = NAN;
+
+            if (!isfinite(value))
+            {
+                unmapFile(data, size);
+                if (report)
+                    solverError("Error: The BOLSIG+ run failed, the rate coefficient C%d in the file %s is not a number!\n",count_R,file);
+                return false;
+            }
+            results->rate[count_R] = value;
+            continue;
+        }
+
+        if (next-ptr >= 24 && strncmp(ptr, "Rate coefficients (m3/s)", 24) == 0)
+        {
+            rates = true;
+            continue;
+        }
+
+        if (next-ptr >= 23 && strncmp(ptr, "Maximum # of iterations", 23) == 0)
+        {
+            results->maxIterations = strtod(ptr+23, NULL);
+            continue;
+        }
+
+        // The transport coefficients follow the mean energy. The conditions block before them contains
+        // some of the same labels (e.g. Maximum energy), which are not read.
+        if (next-ptr >= 16 && strncmp(ptr, "Mean energy (eV)", 16) == 0)
+            transport = true;
+        if (!transport)
+            continue;
+
+        for (l=0 ; l<(int)(sizeof(labels)/sizeof(labels[0])) ; l++)
+        {
+            label_length = strlen(labels[l].label);
+            if (next-ptr > (long)label_length && strncmp(ptr, labels[l].label, label_length) == 0 && ptr[label_length] == ' ')
             {
-                fscanf(fp, "%s", str);
-                fscanf(fp, "%lf", &Emean);
+                *(double*)((char*)results + labels[l].offset) = strtod(ptr+label_length, NULL);
                 break;
             }
         }
     }
 
-    Te_BOLSIG = (2.0*Emean)/dgrFreedom;
+    unmapFile(data, size);
 
-    // Close file
-    fclose(fp);
+    // Check that the run finished and converged
+    if (!isfinite(results->meanEnergy) || count_R != count_BOLSIG-1)
+    {
+        if (report)
+            solverError("Error: The BOLSIG+ run failed, the file %s does not contain the results of all the %d reactions!\n",file,count_BOLSIG-1);
+        return false;
+    }
+    if (results->maxIterations > 0.0 && results->iterations >= results->maxIterations)
+    {
+        if (report)
+            solverError("Error: The BOLSIG+ run did not converge in %.0f iterations!\n",results->maxIterations);
+        return false;
+    }
+
+    return true;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Store the rate coefficients and the threshold energies (in Joules) of the BOLSIG+ results in the K and Ethr
+// arrays, and return the electron temperature
+// --------------------------------------------------------------------------------------------------------
+double storeBOLSIGresults (const bolsigResults *results, double **K_local, double **Ethr_local)
+{
+    // Local variables
+    int l;
+
+    for (l=1 ; l<count_BOLSIG ; l++)
+    {
+        K_local[map_reactions[l][0]][map_reactions[l][1]] = results->rate[l];
+        Ethr_local[map_reactions[l][0]][map_reactions[l][1]] = results->threshold[l]*eVtoJ;
+    }
 
-    return Te_BOLSIG;
+    return (2.0*results->meanEnergy)/dgrFreedom;
 }
 
 
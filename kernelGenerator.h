@@ -0,0 +1,384 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          kernelGenerator.h
+    Type:               header file
+    Short Description:  This file contains the generator of the straight-line kernels of the reaction
+                        mechanism (see mechanism.h).
+
+Description
+===========
+The table-driven functions of mechanism.h loop over the reactions and reach the densities through the
+reactant slots. For a fixed mechanism the same work can be written out as straight-line C code: the
+parameters of the rate coefficients become literals, the densities and rates become local variables,
+the zero stoichiometric coefficients and the zero entries of the Jacobian disappear, and the compiler
+can schedule the whole evaluation. The kernels of mechanismKernels.h are generated with
+
+    ./solve -kernels <mechanism file> <kernels file>
+
+and compiled in with -DMECHANISM_KERNELS, which is what make kernels does. The kernels carry the hash
+of the mechanism they were generated from, and mechanism.h falls back to the table-driven functions if
+the mechanism file of the run differs.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- writeKernelNumber             void        Write a number as a double literal with all its digits.
+- writeKernelTerm               void        Write a term of a sum with its coefficient.
+- kernelProduct                 void        Write the product of the reactant densities of a reaction, without a slot.
+- writeKernelDensities          void        Write the densities of all the species as local variables.
+- writeMechanismKernels         void        Generate the kernels of the mechanism in a header file.
+
+---------------------------------------------------------------------------------------------  */
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write a number as a double literal, with all the digits of the double
+// --------------------------------------------------------------------------------------------------------
+void writeKernelNumber (FILE *fp, double value)
+{
+    // Local variables
+    char number[MAXCHAR];
+
+    snprintf(number, MAXCHAR, "%.17g", value);
+    if (strpbrk(number, ".eEn") == NULL)
+        strcat(number, ".0");
+    fprintf(fp, "%s", number);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write the term coefficient*term of a sum. The first term of the sum is written without the plus sign and
+// the unit coefficients are omitted.
+// --------------------------------------------------------------------------------------------------------
+void writeKernelTerm (FILE *fp, bool *first, double coefficient, const char *term)
+{
+    if (coefficient < 0.0)
+        fprintf(fp, *first ? "-" : " - ");
+    else if (!*first)
+        fprintf(fp, " + ");
+    *first = false;
+
+    if (fabs(coefficient) != 1.0)
+    {
+        writeKernelNumber(fp, fabs(coefficient));
+        fprintf(fp, "*");
+    }
+    fprintf(fp, "%s", term);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write in product the product of the densities of the reactants of the reaction r, without the reactant
+// slot skip (-1 for all the slots). The unused slots are omitted, and an empty product is "".
+// --------------------------------------------------------------------------------------------------------
+void kernelProduct (char product[MAXCHAR], int r, int skip)
+{
+    // Local variables
+    int slot, s;
+    char factor[MAXCHAR];
+
+    product[0] = '\0';
+    for (slot=0 ; slot<3 ; slot++)
+    {
+        s = mechanism.reactant[3*r+slot];
+        if (slot == skip || s == mechanism.NoSpecies)
+            continue;
+
+        snprintf(factor, MAXCHAR, "*d%d", s);
+        strcat(product, factor);
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write the densities of all the species as the local variables d0, d1, ..., from the unknowns x, with the
+// electron density from quasi-neutrality and the densities of the closure species from the total density n
+// --------------------------------------------------------------------------------------------------------
+void writeKernelDensities (FILE *fp)
+{
+    // Local variables
+    int l, s;
+    bool first=true;
+    char term[MAXCHAR];
+
+    for (l=0 ; l<mechanism.NoUnknowns ; l++)
+        fprintf(fp, "    const double d%d = x[%d];\t\t// %s\n", mechanism.unknown[l], l, mechanism.name[mechanism.unknown[l]]);
+
+    fprintf(fp, "    const double d%d = ", mechanism.electron);
+    for (l=0 ; l<mechanism.NoUnknowns ; l++)
+    {
+        if (mechanism.charge[mechanism.unknown[l]] == 0.0)
+            continue;
+        snprintf(term, MAXCHAR, "x[%d]", l);
+        writeKernelTerm(fp, &first, mechanism.charge[mechanism.unknown[l]], term);
+    }
+    if (first)
+        fprintf(fp, "0.0");
+    fprintf(fp, ";\t\t// %s\n", mechanism.name[mechanism.electron]);
+
+    for (s=0 ; s<mechanism.NoSpecies ; s++)
+    {
+        if (!isClosureSpecies(s))
+            continue;
+
+        fprintf(fp, "    const double d%d = ", s);
+        if (mechanism.fraction[s] != 1.0)
+        {
+            writeKernelNumber(fp, mechanism.fraction[s]);
+            fprintf(fp, "*");
+        }
+        fprintf(fp, "n");
+        for (l=0 ; l<mechanism.NoUnknowns ; l++)
+            if (mechanism.family[mechanism.unknown[l]] == s)
+                fprintf(fp, " - x[%d]", l);
+        fprintf(fp, ";\t\t// %s\n", mechanism.name[s]);
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Generate the straight-line kernels of the rate coefficients, the source terms, their Jacobian and their
+// derivatives with Tg in the header file kernelsFile, for the mechanism that has been read
+// --------------------------------------------------------------------------------------------------------
+void writeMechanismKernels (const char *kernelsFile)
+{
+    // Local variables
+    int l, m, p, r, s, slot, NR = mechanism.NoReactions, N = mechanism.NoUnknowns;
+    char term[2*MAXCHAR], product[MAXCHAR];
+    bool first, active[NR], (*used)[mechanism.NoSpecies] = malloc(N*sizeof(*used));
+    double nu;
+    FILE *fp;
+
+    fp = fopen(kernelsFile,"w");
+    if (fp == NULL)
+    {
+        printf("Error: The file %s could not be created!\n",kernelsFile);
+        exit(EXIT_FAILURE);
+    }
+
+    // Reactions that change the unknowns
+    for (r=0 ; r<NR ; r++)
+    {
+        active[r] = false;
+        for (l=0 ; l<N ; l++)
+            if (mechanism.nu[l*NR+r] != 0.0)
+                active[r] = true;
+    }
+
+    fprintf(fp, "/*  Kernels of the reaction mechanism %s, generated by: solve -kernels (see kernelGenerator.h).\n", mechanismFile);
+    fprintf(fp, "    Do not edit this file, generate it again when the mechanism changes (make kernels).  */\n\n");
+    fprintf(fp, "#define KERNEL_HASH 0x%016llxULL\n\n", (unsigned long long) mechanismHash());
+
+
+    // ----------------------------------------------------------------------------------
+    // Rate coefficients
+    // ----------------------------------------------------------------------------------
+    fprintf(fp, "// Rate coefficients that are constant or depend on the electron temperature\n");
+    fprintf(fp, "void kernelElectronTemperatureRates (double *k)\n{\n");
+    for (r=0 ; r<NR ; r++)
+    {
+        if (mechanism.form[r] != rateConstant && mechanism.form[r] != rateElectronTemperature)
+            continue;
+
+        fprintf(fp, "    k[%d] = ", r);
+        writeKernelNumber(fp, mechanism.A[r]);
+        if (mechanism.form[r] == rateElectronTemperature && mechanism.b[r] != 0.0)
+        {
+            fprintf(fp, "*pow(Te,");
+            writeKernelNumber(fp, mechanism.b[r]);
+            fprintf(fp, ")");
+        }
+        if (mechanism.form[r] == rateElectronTemperature && mechanism.C[r] != 0.0)
+        {
+            fprintf(fp, "*exp(-");
+            writeKernelNumber(fp, mechanism.C[r]);
+            fprintf(fp, "/Te)");
+        }
+        fprintf(fp, ";\t\t// R%d\n", mechanism.row[r]);
+    }
+    fprintf(fp, "}\n\n");
+
+    fprintf(fp, "// Rate coefficients that depend on the gas temperature and their derivatives with Tg\n");
+    fprintf(fp, "void kernelGasTemperatureRates (double *k, double *dkdTg)\n{\n");
+    for (r=0 ; r<NR ; r++)
+    {
+        if (mechanism.form[r] == rateGasTemperature)
+        {
+            fprintf(fp, "    k[%d] = ", r);
+            writeKernelNumber(fp, mechanism.A[r]);
+            if (mechanism.b[r] != 0.0)
+            {
+                fprintf(fp, "*pow(Tg");
+                if (mechanism.T0[r] != 1.0)
+                {
+                    fprintf(fp, "/");
+                    writeKernelNumber(fp, mechanism.T0[r]);
+                }
+                fprintf(fp, ",");
+                writeKernelNumber(fp, mechanism.b[r]);
+                fprintf(fp, ")");
+            }
+            if (mechanism.C[r] != 0.0)
+            {
+                fprintf(fp, "*exp(-");
+                writeKernelNumber(fp, mechanism.C[r]);
+                fprintf(fp, "/Tg)");
+            }
+            fprintf(fp, ";\t\t// R%d\n", mechanism.row[r]);
+
+            fprintf(fp, "    dkdTg[%d] = k[%d]*(", r, r);
+            writeKernelNumber(fp, mechanism.b[r]);
+            fprintf(fp, "/Tg");
+            if (mechanism.C[r] != 0.0)
+            {
+                fprintf(fp, " + ");
+                writeKernelNumber(fp, mechanism.C[r]);
+                fprintf(fp, "/(Tg*Tg)");
+            }
+            fprintf(fp, ");\n");
+        }
+        else if (mechanism.form[r] == rateWall)
+        {
+            fprintf(fp, "    k[%d] = 0.5*(", r);
+            writeKernelNumber(fp, mechanism.A[r]);
+            fprintf(fp, "*exp(-");
+            writeKernelNumber(fp, mechanism.b[r]);
+            fprintf(fp, "/Tg)/(2*R))*sqrt(8*kB*Tg/(pi*");
+            writeKernelNumber(fp, mechanism.mass[mechanism.reactant[3*r]]);
+            fprintf(fp, "));\t\t// R%d\n", mechanism.row[r]);
+
+            fprintf(fp, "    dkdTg[%d] = k[%d]*(", r, r);
+            writeKernelNumber(fp, mechanism.b[r]);
+            fprintf(fp, "/(Tg*Tg) + 0.5/Tg);\n");
+        }
+    }
+    fprintf(fp, "}\n\n");
+
+
+    // ----------------------------------------------------------------------------------
+    // Source terms
+    // ----------------------------------------------------------------------------------
+    fprintf(fp, "// Source terms of the unknowns x = {");
+    for (l=0 ; l<N ; l++)
+        fprintf(fp, (l == 0) ? "n%s" : ", n%s", mechanism.name[mechanism.unknown[l]]);
+    fprintf(fp, "}\n");
+    fprintf(fp, "void kernelSources (const double *k, const double *x, double *f)\n{\n");
+    writeKernelDensities(fp);
+    for (r=0 ; r<NR ; r++)
+    {
+        if (!active[r])
+            continue;
+        kernelProduct(product, r, -1);
+        fprintf(fp, "    const double w%d = k[%d]%s;\t\t// R%d\n", r, r, product, mechanism.row[r]);
+    }
+    for (l=0 ; l<N ; l++)
+    {
+        fprintf(fp, "    f[%d] = ", l);
+        first = true;
+        for (r=0 ; r<NR ; r++)
+        {
+            if (mechanism.nu[l*NR+r] == 0.0)
+                continue;
+            snprintf(term, sizeof(term), "w%d", r);
+            writeKernelTerm(fp, &first, mechanism.nu[l*NR+r], term);
+        }
+        fprintf(fp, first ? "0.0;\n" : ";\n");
+    }
+    fprintf(fp, "}\n\n");
+
+
+    // ----------------------------------------------------------------------------------
+    // Jacobian of the source terms: derivatives with the densities of all the species
+    // (g), and then the chain rule for the electron and closure densities
+    // ----------------------------------------------------------------------------------
+    fprintf(fp, "// Jacobian of the source terms, stored in the sparse pattern of the mechanism (the values of J)\n");
+    fprintf(fp, "void kernelSourceJacobian (const double *k, const double *x, double *J)\n{\n");
+    writeKernelDensities(fp);
+    for (l=0 ; l<N ; l++)
+        for (s=0 ; s<mechanism.NoSpecies ; s++)
+        {
+            used[l][s] = false;
+            first = true;
+            for (r=0 ; r<NR ; r++)
+            {
+                // A reactant that fills several slots gives the same term once per slot
+                nu = 0.0;
+                for (slot=2 ; slot>=0 ; slot--)
+                    if (mechanism.reactant[3*r+slot] == s)
+                    {
+                        nu += mechanism.nu[l*NR+r];
+                        kernelProduct(product, r, slot);
+                    }
+                if (nu == 0.0)
+                    continue;
+
+                if (first)
+                    fprintf(fp, "    const double g%d_%d = ", l, s);
+                snprintf(term, sizeof(term), "k[%d]%s", r, product);
+                writeKernelTerm(fp, &first, nu, term);
+                used[l][s] = true;
+            }
+            if (used[l][s])
+                fprintf(fp, ";\n");
+        }
+    for (l=0 ; l<N ; l++)
+        for (p=mechanism.jacobian.rowStart[l] ; p<mechanism.jacobian.rowStart[l+1] ; p++)
+        {
+            m = mechanism.jacobian.column[p];
+            fprintf(fp, "    J[%d] = ", p);
+            first = true;
+            if (used[l][mechanism.unknown[m]])
+            {
+                snprintf(term, sizeof(term), "g%d_%d", l, mechanism.unknown[m]);
+                writeKernelTerm(fp, &first, 1.0, term);
+            }
+            if (used[l][mechanism.electron] && mechanism.charge[mechanism.unknown[m]] != 0.0)
+            {
+                snprintf(term, sizeof(term), "g%d_%d", l, mechanism.electron);
+                writeKernelTerm(fp, &first, mechanism.charge[mechanism.unknown[m]], term);
+            }
+            if (used[l][mechanism.family[mechanism.unknown[m]]])
+            {
+                snprintf(term, sizeof(term), "g%d_%d", l, mechanism.family[mechanism.unknown[m]]);
+                writeKernelTerm(fp, &first, -1.0, term);
+            }
+            fprintf(fp, first ? "0.0;\n" : ";\n");
+        }
+    fprintf(fp, "}\n\n");
+
+
+    // ----------------------------------------------------------------------------------
+    // Derivatives of the source terms with the gas temperature
+    // ----------------------------------------------------------------------------------
+    fprintf(fp, "// Derivatives of the source terms with the gas temperature, at constant densities\n");
+    fprintf(fp, "void kernelSourceTemperature (const double *dkdTg, const double *x, double *dfdTg)\n{\n");
+    writeKernelDensities(fp);
+    for (l=0 ; l<N ; l++)
+    {
+        fprintf(fp, "    dfdTg[%d] = ", l);
+        first = true;
+        for (r=0 ; r<NR ; r++)
+        {
+            if (mechanism.nu[l*NR+r] == 0.0 || (mechanism.form[r] != rateGasTemperature && mechanism.form[r] != rateWall))
+                continue;
+            kernelProduct(product, r, -1);
+            snprintf(term, sizeof(term), "dkdTg[%d]%s", r, product);
+            writeKernelTerm(fp, &first, mechanism.nu[l*NR+r], term);
+        }
+        fprintf(fp, first ? "0.0;\n" : ";\n");
+    }
+    fprintf(fp, "}\n");
+
+    fclose(fp);
+    free(used);
+}
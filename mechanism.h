@@ -0,0 +1,1273 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          mechanism.h
+    Type:               header file
+    Short Description:  This file contains the reaction mechanism, which is read from the mechanism
+                        file (see mechanism.txt), and the source terms and powers that follow from it.
+
+Description
+===========
+The mechanism file gives the species, the reactions with their rate coefficients and the power
+term of each reaction. It is compiled once into flat tables: the positions of the rate coefficients
+in the K and Ethr arrays, the parameters of the rate coefficient fits, three reactant slots per
+reaction (the unused slots point to a species with unit density) and the net stoichiometric
+coefficients of the unknowns of the balance equations. The rates of all the reactions, the source
+terms of the species and the powers are then evaluated with single loops over these tables.
+
+The rate coefficients are stored in the K array at the position of the label of each reaction, as
+the Boltzmann solvers do, so the rates of the Boltzmann solvers (BOLSIG) are used directly. The
+solvers work on a flat copy of them (k), which is gathered from K once per solution of the balance
+equations.
+
+The net stoichiometric coefficients are also stored as a sparse matrix (see sparse.h), with a row
+per unknown and a column per reaction, so the source terms f = S*w only visit the nonzero entries.
+The analytic Jacobian of the source terms is built in the same way: its pattern is found once from
+the reactants of each reaction and the closures of the densities, together with a list of contributions
+(reaction, reactant slot, entry of the Jacobian, coefficient). A Jacobian evaluation is then one loop
+over the contributions, for reactions of any order, including the three-body reactions, and the
+Newton solver factorizes it with the LU pattern that is also found once.
+
+For a production mechanism, straight-line kernels of the rate coefficients, the source terms and
+their Jacobian can be generated from the mechanism file and compiled into the code (make kernels,
+see kernelGenerator.h). They are used only if they were generated from the same mechanism (same
+hash of the tables), otherwise the table-driven functions below are used.
+
+The unknowns of the balance equations are the densities of the hydrogen model, {nH, nH+, nH2+, nH3+},
+followed by the densities of the other species of the mechanism in the order of the file (e.g. the
+argon species of an Ar-diluted discharge, see mechanismAr.txt). The electron density follows from
+quasi-neutrality. The densities of the background gas (H2) and of the diluents follow from the total
+density n: each diluent is a fixed fraction of n, the background gas the rest, and each species is
+assigned to the family of one of them (Ar+ and ArH+ to Ar, the hydrogen species to H2), whose density
+it reduces. The stoichiometric coefficients of these closure species are not used. The densities of
+all the species are kept in the speciesDensity array, in the order of the mechanism, and the hydrogen
+densities also in the variables nH, nH2, etc. of the model.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- findSpecies                   int         Find a species of the mechanism by name.
+- isClosureSpecies              bool        Check if the density of a species follows from the total density.
+- mechanismHash                 uint64_t    Calculate a hash of the tables of the mechanism, which identifies the kernels.
+- buildStoichiometry            void        Build the sparse stoichiometric matrix and the reaction orders.
+- densityDerivative             double      Derivative of the density of a species with an unknown.
+- buildJacobianPattern          void        Find the pattern of the Jacobian and its contributions, once.
+- readMechanism                 void        Read the mechanism file and compile it into flat tables.
+- freeMechanism                 void        Release the memory of the mechanism.
+- initializeMechanismRates      void        Set the initial guesses of the rate coefficients of the Boltzmann solver.
+- calculateElectronTemperatureRates void    Calculate the rate coefficients that depend on the electron temperature.
+- calculateGasTemperatureRates  void        Calculate the rate coefficients that depend on the gas temperature.
+- gatherMechanismRates          void        Copy the rate coefficients of the mechanism from the K array.
+- mechanismDensities            void        Calculate the densities of all the species from the unknowns.
+- getUnknowns                   void        Gather the unknowns of the balance equations from the densities of the model.
+- updateClosureDensities        void        Update the densities of all the species from the unknowns of the model.
+- setUnknowns                   void        Set the densities of the model from the unknowns of the balance equations.
+- otherUnknownsError            double      Relative change of the unknowns that are not hydrogen species.
+- copyOtherUnknowns             void        Copy the unknowns that are not hydrogen species to the previous iteration.
+- mechanismRates                void        Calculate the rates of all the reactions.
+- speciesSources                void        Calculate the source terms of the unknowns.
+- speciesLossFrequencies        void        Calculate the first-order loss frequencies of the unknowns.
+- speciesCollisionLosses        void        Add the collisional loss frequencies of the unknowns that are not hydrogen species.
+- speciesJacobianSparse         void        Calculate the Jacobian of the source terms in the sparse pattern.
+- speciesSourceJacobian         void        Calculate the Jacobian of the source terms of the unknowns (dense).
+- speciesSourceTemperature      void        Calculate the derivatives of the source terms with the gas temperature.
+- calculatePowers               void        Calculate the power terms of the energy equation.
+- printOtherSpecies             void        Print the densities of the species that are not hydrogen species.
+
+---------------------------------------------------------------------------------------------  */
+
+// Forms of the rate coefficients
+#define rateConstant 0
+#define rateElectronTemperature 1
+#define rateGasTemperature 2
+#define rateWall 3
+#define rateBoltzmann 4
+
+// Power terms and forms of the energy of the reactions
+#define NoPowerTerms 7
+#define energyValue 0
+#define energyThreshold 1
+#define energyElastic 2
+
+// Unknowns of the hydrogen model, which are the first unknowns of the balance equations
+#define NoHydrogenUnknowns 4
+const char *hydrogenUnknowns[NoHydrogenUnknowns] = {"H", "H+", "H2+", "H3+"};
+const char *powerTerms[NoPowerTerms] = {"ion", "dis", "ele", "vib", "rot", "ela", "chem"};
+
+typedef struct
+{
+    // Species. The species NoSpecies has unit density and fills the unused reactant slots.
+    int NoSpecies, electron, background;
+    char (*name)[MAXCHAR];
+    double *mass, *charge;
+    int *family;                    // Closure species (background gas or diluent) of the family of each species
+    double *fraction;               // Fraction of the total density n in the family of each closure species
+    int NoUnknowns, *unknown;       // Species of the unknowns of the balance equations
+    int *neutral;                   // Species of each entry of the neutralSpecies array
+
+    // Reactions
+    int NoReactions;
+    int *row, *col;                 // Position of the rate coefficient in the K and Ethr arrays
+    int *form;                      // Form of the rate coefficient
+    bool *initial;                  // Initial guess of a rate coefficient of the Boltzmann solver
+    double *A, *b, *C, *T0;         // Parameters of the rate coefficient
+    int *reactant;                  // Three reactant slots per reaction
+    int *order;                     // Number of reactants (order) of each reaction
+    double *nu;                     // Net stoichiometric coefficients of the unknowns, [NoUnknowns][NoReactions]
+    sparseMatrix stoichiometry;     // The same coefficients in sparse form
+    int *power, *energyForm;        // Power term (-1 = none) and form of the energy
+    double *energy;                 // Energy of the reaction (J), if it is a value
+    double *k, *dkdTg, *w;          // Rate coefficients, their derivatives with Tg and rates
+
+    // Jacobian of the source terms: pattern, LU factors and contributions. Each contribution adds
+    // coefficient*k[r]*(densities of the other reactant slots) to an entry of the Jacobian.
+    sparseMatrix jacobian;
+    sparseLU jacobianLU;
+    int NoContributions;
+    int *contributionReaction, *contributionSlot, *contributionEntry;
+    double *contributionCoefficient;
+
+    // Use the code-generated kernels
+    bool kernels;
+} reactionMechanism;
+
+THREAD_LOCAL reactionMechanism mechanism;
+
+// Code-generated kernels of the mechanism (make kernels)
+#ifdef MECHANISM_KERNELS
+    #include "mechanismKernels.h"
+#endif
+
+
+// --------------------------------------------------------------------------------------------------------
+// Find a species of the mechanism by name. Returns -1 if it does not exist.
+// --------------------------------------------------------------------------------------------------------
+int findSpecies (const char *name)
+{
+    // Local variables
+    int l;
+
+    for (l=0 ; l<mechanism.NoSpecies ; l++)
+        if (strcmp(mechanism.name[l], name) == 0)
+            return l;
+
+    return -1;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Check if the density of the species s follows from the total density, as the background gas or a diluent
+// --------------------------------------------------------------------------------------------------------
+bool isClosureSpecies (int s)
+{
+    return (s == mechanism.background || mechanism.fraction[s] > 0.0);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate a hash (64-bit FNV-1a) of the tables of the mechanism that the kernels depend on, written as text
+// with all the digits of the parameters
+// --------------------------------------------------------------------------------------------------------
+uint64_t mechanismHash ()
+{
+    // Local variables
+    int l, r, length;
+    char entry[4*MAXCHAR];
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (r=-1 ; r<mechanism.NoReactions ; r++)
+    {
+        if (r < 0)
+            length = snprintf(entry, sizeof(entry), "%d %d %d %d", mechanism.NoSpecies, mechanism.electron, mechanism.background, mechanism.NoUnknowns);
+        else
+            length = snprintf(entry, sizeof(entry), "|%d %d %d %.17g %.17g %.17g %.17g %d %d %d %.17g", mechanism.row[r], mechanism.col[r], mechanism.form[r], mechanism.A[r], mechanism.b[r], mechanism.C[r], mechanism.T0[r], mechanism.reactant[3*r], mechanism.reactant[3*r+1], mechanism.reactant[3*r+2], mechanism.mass[mechanism.reactant[3*r]]);
+        for (l=0 ; l<length ; l++)
+            hash = (hash ^ (unsigned char) entry[l])*1099511628211ULL;
+    }
+
+    for (l=0 ; l<mechanism.NoUnknowns*mechanism.NoReactions ; l++)
+    {
+        length = snprintf(entry, sizeof(entry), "|%.17g", mechanism.nu[l]);
+        for (r=0 ; r<length ; r++)
+            hash = (hash ^ (unsigned char) entry[r])*1099511628211ULL;
+    }
+    for (l=0 ; l<mechanism.NoUnknowns ; l++)
+    {
+        length = snprintf(entry, sizeof(entry), "|%d", mechanism.unknown[l]);
+        for (r=0 ; r<length ; r++)
+            hash = (hash ^ (unsigned char) entry[r])*1099511628211ULL;
+    }
+    for (l=0 ; l<mechanism.NoSpecies ; l++)
+    {
+        length = snprintf(entry, sizeof(entry), "|%.17g %d %.17g", mechanism.charge[l], mechanism.family[l], mechanism.fraction[l]);
+        for (r=0 ; r<length ; r++)
+            hash = (hash ^ (unsigned char) entry[r])*1099511628211ULL;
+    }
+
+    return hash;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Build the sparse stoichiometric matrix of the unknowns and the order of each reaction
+// --------------------------------------------------------------------------------------------------------
+void buildStoichiometry ()
+{
+    // Local variables
+    int l, r, slot, NR = mechanism.NoReactions, N = mechanism.NoUnknowns;
+    bool *pattern = (bool*) malloc((N*NR > 0 ? N*NR : 1)*sizeof(bool));
+
+    for (l=0 ; l<N*NR ; l++)
+        pattern[l] = (mechanism.nu[l] != 0.0);
+    allocateSparse(&mechanism.stoichiometry, N, NR, pattern);
+    sparseFromDense(&mechanism.stoichiometry, mechanism.nu);
+    free(pattern);
+
+    mechanism.order = (int*) calloc(NR, sizeof(int));
+    for (r=0 ; r<NR ; r++)
+        for (slot=0 ; slot<3 ; slot++)
+            if (mechanism.reactant[3*r+slot] != mechanism.NoSpecies)
+                mechanism.order[r]++;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Derivative of the density of the species s with the unknown m: 1 for the unknown itself, its charge for
+// the electrons (quasi-neutrality) and -1 for the closure species of its family (total density)
+// --------------------------------------------------------------------------------------------------------
+double densityDerivative (int s, int m)
+{
+    if (s == mechanism.unknown[m])
+        return 1.0;
+    else if (s == mechanism.electron)
+        return mechanism.charge[mechanism.unknown[m]];
+    else if (s == mechanism.family[mechanism.unknown[m]])
+        return -1.0;
+
+    return 0.0;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Find the pattern of the Jacobian of the source terms, and the list of its contributions. The rate of the
+// reaction r depends on the unknown m through each reactant slot, with the derivative k*(other slots)*dd/dx_m,
+// and it enters the equation l with the coefficient nu[l][r]. This is done once, after the mechanism is read.
+// --------------------------------------------------------------------------------------------------------
+void buildJacobianPattern ()
+{
+    // Local variables
+    int l, m, p, r, slot, pass, count, N = mechanism.NoUnknowns;
+    bool *pattern = (bool*) calloc(N*N, sizeof(bool));
+    double derivative;
+    const sparseMatrix *S = &mechanism.stoichiometry;
+
+    // The first pass counts the contributions and finds the pattern, the second stores the contributions
+    for (pass=0 ; pass<2 ; pass++)
+    {
+        count = 0;
+        for (l=0 ; l<N ; l++)
+            for (p=S->rowStart[l] ; p<S->rowStart[l+1] ; p++)
+            {
+                r = S->column[p];
+                for (slot=0 ; slot<mechanism.order[r] ; slot++)
+                    for (m=0 ; m<N ; m++)
+                    {
+                        derivative = densityDerivative(mechanism.reactant[3*r+slot], m);
+                        if (derivative == 0.0)
+                            continue;
+
+                        if (pass == 0)
+                            pattern[l*N+m] = true;
+                        else
+                        {
+                            mechanism.contributionReaction[count] = r;
+                            mechanism.contributionSlot[count] = slot;
+                            mechanism.contributionEntry[count] = sparsePosition(&mechanism.jacobian, l, m);
+                            mechanism.contributionCoefficient[count] = S->value[p]*derivative;
+                        }
+                        count++;
+                    }
+            }
+
+        if (pass == 0)
+        {
+            mechanism.NoContributions = count;
+            mechanism.contributionReaction = (int*) malloc((count+1)*sizeof(int));
+            mechanism.contributionSlot = (int*) malloc((count+1)*sizeof(int));
+            mechanism.contributionEntry = (int*) malloc((count+1)*sizeof(int));
+            mechanism.contributionCoefficient = (double*) malloc((count+1)*sizeof(double));
+            allocateSparse(&mechanism.jacobian, N, N, pattern);
+        }
+    }
+    free(pattern);
+
+    // Pattern of the LU factors of the Newton matrix
+    sparseLUSymbolic(&mechanism.jacobian, &mechanism.jacobianLU);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Read the mechanism file and compile it into the flat tables of the mechanism. Each statement ends with a
+// semicolon, and the text after it and the comments (// and /* */) are ignored.
+// --------------------------------------------------------------------------------------------------------
+void readMechanism ()
+{
+    // Local variables
+    int l, r, s, slot, capacity_species=8, capacity_reactions=32, line_number=0;
+    char line[4*MAXCHAR], *token, *end;
+    double coefficient, *nu_species, diluents=0.0;
+    bool comment=false, products;
+    FILE *fp;
+
+    fp = fopen(mechanismFile,"r");
+    if (fp == NULL)
+    {
+        printf("Error: The file %s was not found!\n",mechanismFile);
+        exit(EXIT_FAILURE);
+    }
+
+    mechanism.NoSpecies = mechanism.NoReactions = 0;
+    mechanism.electron = mechanism.background = -1;
+    mechanism.name = malloc(capacity_species*sizeof(*mechanism.name));
+    mechanism.mass = (double*) malloc(capacity_species*sizeof(double));
+    mechanism.charge = (double*) malloc(capacity_species*sizeof(double));
+    mechanism.family = (int*) malloc(capacity_species*sizeof(int));
+    mechanism.fraction = (double*) malloc(capacity_species*sizeof(double));
+    mechanism.row = (int*) malloc(capacity_reactions*sizeof(int));
+    mechanism.col = (int*) malloc(capacity_reactions*sizeof(int));
+    mechanism.form = (int*) malloc(capacity_reactions*sizeof(int));
+    mechanism.initial = (bool*) malloc(capacity_reactions*sizeof(bool));
+    mechanism.A = (double*) malloc(capacity_reactions*sizeof(double));
+    mechanism.b = (double*) malloc(capacity_reactions*sizeof(double));
+    mechanism.C = (double*) malloc(capacity_reactions*sizeof(double));
+    mechanism.T0 = (double*) malloc(capacity_reactions*sizeof(double));
+    mechanism.reactant = (int*) malloc(3*capacity_reactions*sizeof(int));
+    mechanism.power = (int*) malloc(capacity_reactions*sizeof(int));
+    mechanism.energyForm = (int*) malloc(capacity_reactions*sizeof(int));
+    mechanism.energy = (double*) malloc(capacity_reactions*sizeof(double));
+
+    // Stoichiometric coefficients of all the species, [NoReactions][NoSpecies], while the file is read
+    nu_species = NULL;
+
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        line_number++;
+
+        // Block comments
+        if (comment)
+        {
+            if (strstr(line, "*/") != NULL)
+                comment = false;
+            continue;
+        }
+        if (strncmp(line, "/*", 2) == 0)
+        {
+            comment = (strstr(line+2, "*/") == NULL);
+            continue;
+        }
+
+        // Line comments and the end of the statement
+        if ((end = strstr(line, "//")) != NULL)
+            *end = '\0';
+        end = strchr(line, ';');
+        token = strtok(line, " \t\r\n;");
+        if (token == NULL)
+            continue;
+        if (end == NULL)
+        {
+            printf("Error: Missing semicolon in the line %d of the file: %s\n",line_number,mechanismFile);
+            exit(EXIT_FAILURE);
+        }
+        *end = '\0';
+
+        // ----------------------------------------------------------------------------------
+        // Species
+        // ----------------------------------------------------------------------------------
+        if (strcmp(token,"species") == 0)
+        {
+            if (mechanism.NoReactions > 0)
+            {
+                printf("Error: The species must be given before the reactions in the file: %s\n",mechanismFile);
+                exit(EXIT_FAILURE);
+            }
+            if (mechanism.NoSpecies == capacity_species)
+            {
+                capacity_species *= 2;
+                mechanism.name = realloc(mechanism.name, capacity_species*sizeof(*mechanism.name));
+                mechanism.mass = (double*) realloc(mechanism.mass, capacity_species*sizeof(double));
+                mechanism.charge = (double*) realloc(mechanism.charge, capacity_species*sizeof(double));
+                mechanism.family = (int*) realloc(mechanism.family, capacity_species*sizeof(int));
+                mechanism.fraction = (double*) realloc(mechanism.fraction, capacity_species*sizeof(double));
+            }
+
+            s = mechanism.NoSpecies;
+            token = strtok(NULL, " \t\r\n;");
+            if (token == NULL || findSpecies(token) >= 0)
+            {
+                printf("Error: Missing or repeated species name in the line %d of the file: %s\n",line_number,mechanismFile);
+                exit(EXIT_FAILURE);
+            }
+            snprintf(mechanism.name[s], MAXCHAR, "%s", token);
+            token = strtok(NULL, " \t\r\n;");
+            mechanism.mass[s] = (token != NULL) ? atof(token)*mp : -1.0;
+            token = strtok(NULL, " \t\r\n;");
+            if (token == NULL || mechanism.mass[s] < 0.0)
+            {
+                printf("Error: The species %s needs a mass and a charge in the file: %s\n",mechanism.name[s],mechanismFile);
+                exit(EXIT_FAILURE);
+            }
+            mechanism.charge[s] = atof(token);
+            if (mechanism.charge[s] < 0.0)
+                mechanism.electron = s;
+
+            // Family of the species, which is the background gas if it is not given
+            mechanism.family[s] = -1;
+            mechanism.fraction[s] = 0.0;
+            if ((token = strtok(NULL, " \t\r\n;")) != NULL && (mechanism.family[s] = findSpecies(token)) < 0)
+            {
+                printf("Error: The family %s of the species %s must be a species given before it in the file: %s\n",token,mechanism.name[s],mechanismFile);
+                exit(EXIT_FAILURE);
+            }
+            mechanism.NoSpecies++;
+        }
+
+        // ----------------------------------------------------------------------------------
+        // Background gas
+        // ----------------------------------------------------------------------------------
+        else if (strcmp(token,"background") == 0)
+        {
+            token = strtok(NULL, " \t\r\n;");
+            mechanism.background = (token != NULL) ? findSpecies(token) : -1;
+            if (mechanism.background < 0)
+            {
+                printf("Error: Unknown background species in the line %d of the file: %s\n",line_number,mechanismFile);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        // ----------------------------------------------------------------------------------
+        // Diluents, which are fixed fractions of the total density
+        // ----------------------------------------------------------------------------------
+        else if (strcmp(token,"diluent") == 0)
+        {
+            token = strtok(NULL, " \t\r\n;");
+            s = (token != NULL) ? findSpecies(token) : -1;
+            token = strtok(NULL, " \t\r\n;");
+            if (s < 0 || token == NULL || atof(token) <= 0.0 || mechanism.charge[s] != 0.0)
+            {
+                printf("Error: A diluent needs a neutral species and its fraction of the total density in the line %d of the file: %s\n",line_number,mechanismFile);
+                exit(EXIT_FAILURE);
+            }
+            mechanism.fraction[s] = atof(token);
+            diluents += mechanism.fraction[s];
+        }
+
+        // ----------------------------------------------------------------------------------
+        // Reactions
+        // ----------------------------------------------------------------------------------
+        else if (strcmp(token,"reaction") == 0)
+        {
+            if (mechanism.NoReactions == capacity_reactions)
+            {
+                capacity_reactions *= 2;
+                mechanism.row = (int*) realloc(mechanism.row, capacity_reactions*sizeof(int));
+                mechanism.col = (int*) realloc(mechanism.col, capacity_reactions*sizeof(int));
+                mechanism.form = (int*) realloc(mechanism.form, capacity_reactions*sizeof(int));
+                mechanism.initial = (bool*) realloc(mechanism.initial, capacity_reactions*sizeof(bool));
+                mechanism.A = (double*) realloc(mechanism.A, capacity_reactions*sizeof(double));
+                mechanism.b = (double*) realloc(mechanism.b, capacity_reactions*sizeof(double));
+                mechanism.C = (double*) realloc(mechanism.C, capacity_reactions*sizeof(double));
+                mechanism.T0 = (double*) realloc(mechanism.T0, capacity_reactions*sizeof(double));
+                mechanism.reactant = (int*) realloc(mechanism.reactant, 3*capacity_reactions*sizeof(int));
+                mechanism.power = (int*) realloc(mechanism.power, capacity_reactions*sizeof(int));
+                mechanism.energyForm = (int*) realloc(mechanism.energyForm, capacity_reactions*sizeof(int));
+                mechanism.energy = (double*) realloc(mechanism.energy, capacity_reactions*sizeof(double));
+            }
+            r = mechanism.NoReactions;
+            nu_species = (double*) realloc(nu_species, (r+1)*mechanism.NoSpecies*sizeof(double));
+            for (s=0 ; s<mechanism.NoSpecies ; s++)
+                nu_species[r*mechanism.NoSpecies+s] = 0.0;
+
+            // Label, which gives the position in the K and Ethr arrays
+            token = strtok(NULL, " \t\r\n;");
+            if (token == NULL)
+            {
+                printf("Error: Missing reaction label in the line %d of the file: %s\n",line_number,mechanismFile);
+                exit(EXIT_FAILURE);
+            }
+            parseReactionLabel(token, &mechanism.row[r], &mechanism.col[r]);
+            if (mechanism.row[r] < 1 || mechanism.row[r] >= react_num || mechanism.col[r] >= subreact_num)
+            {
+                printf("Error: The reaction %s of the file %s exceeds the size of the rate coefficient arrays!\n",token,mechanismFile);
+                exit(EXIT_FAILURE);
+            }
+            for (l=0 ; l<r ; l++)
+                if (mechanism.row[l] == mechanism.row[r] && mechanism.col[l] == mechanism.col[r])
+                {
+                    printf("Error: The reaction %s is repeated in the file: %s\n",token,mechanismFile);
+                    exit(EXIT_FAILURE);
+                }
+
+            // Reactants and products with their coefficients, until the form of the rate coefficient
+            for (slot=0 ; slot<3 ; slot++)
+                mechanism.reactant[3*r+slot] = mechanism.NoSpecies;
+            slot = 0;
+            products = false;
+            coefficient = 1.0;
+            while ((token = strtok(NULL, " \t\r\n;")) != NULL)
+            {
+                if (strcmp(token,"+") == 0)
+                    continue;
+                if (strcmp(token,"->") == 0)
+                {
+                    products = true;
+                    continue;
+                }
+                if (isdigit((unsigned char) token[0]) || token[0] == '.')
+                {
+                    coefficient = atof(token);
+                    continue;
+                }
+                if ((s = findSpecies(token)) < 0)
+                    break;
+
+                if (products)
+                    nu_species[r*mechanism.NoSpecies+s] += coefficient;
+                else
+                {
+                    nu_species[r*mechanism.NoSpecies+s] -= coefficient;
+                    for (l=0 ; l<(int) coefficient ; l++)
+                    {
+                        if (slot == 3 || coefficient != (int) coefficient)
+                        {
+                            printf("Error: The reaction %d of the file %s must have up to three reactants with integer coefficients!\n",mechanism.row[r],mechanismFile);
+                            exit(EXIT_FAILURE);
+                        }
+                        mechanism.reactant[3*r+slot++] = s;
+                    }
+                }
+                coefficient = 1.0;
+            }
+            if (!products || slot == 0 || token == NULL)
+            {
+                printf("Error: The reaction in the line %d of the file %s needs reactants, an arrow and a rate coefficient!\n",line_number,mechanismFile);
+                exit(EXIT_FAILURE);
+            }
+
+            // Rate coefficient
+            mechanism.initial[r] = false;
+            mechanism.A[r] = mechanism.b[r] = mechanism.C[r] = 0.0;
+            mechanism.T0[r] = 1.0;
+            if (strcmp(token,"BOLSIG") == 0)
+            {
+                mechanism.form[r] = rateBoltzmann;
+                token = strtok(NULL, " \t\r\n;");
+                mechanism.initial[r] = (token != NULL && strcmp(token,"Te") == 0);
+            }
+            else if (strcmp(token,"const") == 0)
+                mechanism.form[r] = rateConstant;
+            else if (strcmp(token,"Te") == 0)
+                mechanism.form[r] = rateElectronTemperature;
+            else if (strcmp(token,"Tg") == 0)
+                mechanism.form[r] = rateGasTemperature;
+            else if (strcmp(token,"wall") == 0)
+                mechanism.form[r] = rateWall;
+            else
+            {
+                printf("Error: Unknown species or rate coefficient '%s' in the line %d of the file: %s. Availiable rate coefficients: const, Te, Tg, wall or BOLSIG.\n",token,line_number,mechanismFile);
+                exit(EXIT_FAILURE);
+            }
+
+            // Parameters of the rate coefficient, after which the next token is the power term
+            if (mechanism.form[r] != rateBoltzmann || mechanism.initial[r])
+            {
+                double *parameter[4] = {&mechanism.A[r], &mechanism.b[r], &mechanism.C[r], &mechanism.T0[r]};
+                const int NoParameters[5] = {1, 3, 4, 2, 3};
+
+                for (l=0 ; l<NoParameters[mechanism.form[r]] ; l++)
+                {
+                    if ((token = strtok(NULL, " \t\r\n;")) == NULL)
+                    {
+                        printf("Error: Missing parameters of the rate coefficient in the line %d of the file: %s\n",line_number,mechanismFile);
+                        exit(EXIT_FAILURE);
+                    }
+                    *parameter[l] = atof(token);
+                }
+                token = strtok(NULL, " \t\r\n;");
+            }
+
+            // The rates of the Boltzmann solver must be in the cross-section file
+            if (mechanism.form[r] == rateBoltzmann && collisionIndex[mechanism.row[r]][mechanism.col[r]] < 0)
+            {
+                printf("Error: The reaction %d of the file %s is not in the file: %s\n",mechanism.row[r],mechanismFile,BOLSIG_crossSections);
+                exit(EXIT_FAILURE);
+            }
+
+            // Power term
+            mechanism.power[r] = -1;
+            mechanism.energyForm[r] = energyValue;
+            mechanism.energy[r] = 0.0;
+            if (token != NULL)
+            {
+                for (l=0 ; l<NoPowerTerms ; l++)
+                    if (strcmp(token, powerTerms[l]) == 0)
+                        mechanism.power[r] = l;
+                token = strtok(NULL, " \t\r\n;");
+                if (mechanism.power[r] < 0 || token == NULL)
+                {
+                    printf("Error: Unknown power term in the line %d of the file: %s. Availiable power terms: ion, dis, ele, vib, rot, ela or chem, followed by the energy.\n",line_number,mechanismFile);
+                    exit(EXIT_FAILURE);
+                }
+
+                if (strcmp(token,"threshold") == 0)
+                    mechanism.energyForm[r] = energyThreshold;
+                else if (strcmp(token,"elastic") == 0)
+                    mechanism.energyForm[r] = energyElastic;
+                else
+                    mechanism.energy[r] = atof(token)*eVtoJ;
+
+                if (mechanism.energyForm[r] == energyThreshold && mechanism.form[r] != rateBoltzmann)
+                {
+                    printf("Error: The threshold energy of the reaction %d of the file %s is only known for the rates of the Boltzmann solver!\n",mechanism.row[r],mechanismFile);
+                    exit(EXIT_FAILURE);
+                }
+            }
+
+            mechanism.NoReactions++;
+        }
+        else
+        {
+            printf("Error: Unknown statement '%s' in the line %d of the file: %s\n",token,line_number,mechanismFile);
+            exit(EXIT_FAILURE);
+        }
+    }
+    fclose(fp);
+
+
+    // ----------------------------------------------------------------------------------
+    // Unknowns of the balance equations and closures
+    // ----------------------------------------------------------------------------------
+    if (mechanism.electron < 0 || mechanism.background < 0)
+    {
+        printf("Error: The file %s must contain the electrons and the background gas!\n",mechanismFile);
+        exit(EXIT_FAILURE);
+    }
+    if (diluents >= 1.0 || mechanism.fraction[mechanism.background] > 0.0)
+    {
+        printf("Error: The diluents of the file %s must be other species than the background gas, with a total fraction below one!\n",mechanismFile);
+        exit(EXIT_FAILURE);
+    }
+    mechanism.fraction[mechanism.background] = 1.0 - diluents;
+
+    // The hydrogen species come first, then the other species that are not closures in the order of the file
+    mechanism.unknown = (int*) malloc(mechanism.NoSpecies*sizeof(int));
+    mechanism.NoUnknowns = NoHydrogenUnknowns;
+    for (l=0 ; l<NoHydrogenUnknowns ; l++)
+    {
+        mechanism.unknown[l] = findSpecies(hydrogenUnknowns[l]);
+        if (mechanism.unknown[l] < 0 || mechanism.unknown[l] == mechanism.electron || isClosureSpecies(mechanism.unknown[l]))
+        {
+            printf("Error: The species %s of the hydrogen model is missing or is not a variable in the file: %s\n",hydrogenUnknowns[l],mechanismFile);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (s=0 ; s<mechanism.NoSpecies ; s++)
+    {
+        for (l=0 ; l<NoHydrogenUnknowns ; l++)
+            if (s == mechanism.unknown[l])
+                break;
+        if (l == NoHydrogenUnknowns && s != mechanism.electron && !isClosureSpecies(s))
+            mechanism.unknown[mechanism.NoUnknowns++] = s;
+    }
+
+    // Families of the species: the closure species are their own family, the electrons have none
+    for (s=0 ; s<mechanism.NoSpecies ; s++)
+    {
+        if (isClosureSpecies(s))
+            mechanism.family[s] = s;
+        else if (s == mechanism.electron)
+            mechanism.family[s] = -1;
+        else if (mechanism.family[s] < 0)
+            mechanism.family[s] = mechanism.background;
+        else if (!isClosureSpecies(mechanism.family[s]))
+        {
+            printf("Error: The family %s of the species %s is not the background gas or a diluent in the file: %s\n",mechanism.name[mechanism.family[s]],mechanism.name[s],mechanismFile);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Neutral species of the cross-section file, which the Boltzmann solvers see
+    mechanism.neutral = (int*) malloc((NoNeutralSpecies > 0 ? NoNeutralSpecies : 1)*sizeof(int));
+    for (l=0 ; l<NoNeutralSpecies ; l++)
+    {
+        mechanism.neutral[l] = findSpecies(neutralSpecies[l]);
+        if (mechanism.neutral[l] < 0 || mechanism.charge[mechanism.neutral[l]] != 0.0)
+        {
+            printf("Error: The neutral species %s of the input file is not a neutral species of the file: %s\n",neutralSpecies[l],mechanismFile);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Stoichiometric coefficients of the unknowns
+    mechanism.nu = (double*) calloc(mechanism.NoUnknowns*mechanism.NoReactions, sizeof(double));
+    for (l=0 ; l<mechanism.NoUnknowns ; l++)
+        for (r=0 ; r<mechanism.NoReactions ; r++)
+            mechanism.nu[l*mechanism.NoReactions+r] = nu_species[r*mechanism.NoSpecies+mechanism.unknown[l]];
+    free(nu_species);
+
+    mechanism.k = (double*) calloc(mechanism.NoReactions, sizeof(double));
+    mechanism.dkdTg = (double*) calloc(mechanism.NoReactions, sizeof(double));
+    mechanism.w = (double*) calloc(mechanism.NoReactions, sizeof(double));
+
+    // Sparse stoichiometry and the pattern of the Jacobian
+    buildStoichiometry();
+    buildJacobianPattern();
+
+    // The kernels must have been generated from the same mechanism
+    mechanism.kernels = false;
+    #ifdef MECHANISM_KERNELS
+        mechanism.kernels = (mechanismHash() == KERNEL_HASH);
+        if (!mechanism.kernels && printScreenOutput)
+            logMessage(LOG_WARNING, "Warning: The compiled kernels were generated from another mechanism than %s. The table-driven functions are used (run make kernels again).\n",mechanismFile);
+    #endif
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Release the memory of the mechanism
+// --------------------------------------------------------------------------------------------------------
+void freeMechanism ()
+{
+    free(mechanism.name);
+    free(mechanism.mass);
+    free(mechanism.charge);
+    free(mechanism.family);
+    free(mechanism.fraction);
+    free(mechanism.unknown);
+    free(mechanism.neutral);
+    free(mechanism.row);
+    free(mechanism.col);
+    free(mechanism.form);
+    free(mechanism.initial);
+    free(mechanism.A);
+    free(mechanism.b);
+    free(mechanism.C);
+    free(mechanism.T0);
+    free(mechanism.reactant);
+    free(mechanism.order);
+    free(mechanism.nu);
+    freeSparse(&mechanism.stoichiometry);
+    freeSparse(&mechanism.jacobian);
+    freeSparseLU(&mechanism.jacobianLU);
+    free(mechanism.contributionReaction);
+    free(mechanism.contributionSlot);
+    free(mechanism.contributionEntry);
+    free(mechanism.contributionCoefficient);
+    free(mechanism.power);
+    free(mechanism.energyForm);
+    free(mechanism.energy);
+    free(mechanism.k);
+    free(mechanism.dkdTg);
+    free(mechanism.w);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Set the initial guesses of the rate coefficients of the Boltzmann solver, which are used until its first
+// solution
+// --------------------------------------------------------------------------------------------------------
+void initializeMechanismRates ()
+{
+    // Local variables
+    int r;
+
+    for (r=0 ; r<mechanism.NoReactions ; r++)
+        if (mechanism.initial[r])
+            K[mechanism.row[r]][mechanism.col[r]] = mechanism.A[r]*pow(Te,mechanism.b[r])*exp(-mechanism.C[r]/Te);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the rate coefficients that are constant or depend on the electron temperature, and store them in
+// the K array
+// --------------------------------------------------------------------------------------------------------
+void calculateElectronTemperatureRates ()
+{
+    // Local variables
+    int r;
+    double *k = mechanism.k;
+
+    #ifdef MECHANISM_KERNELS
+        if (mechanism.kernels)
+            kernelElectronTemperatureRates(k);
+    #endif
+
+    for (r=0 ; r<mechanism.NoReactions ; r++)
+    {
+        if (mechanism.form[r] != rateConstant && mechanism.form[r] != rateElectronTemperature)
+            continue;
+
+        if (!mechanism.kernels)
+        {
+            if (mechanism.form[r] == rateConstant)
+                k[r] = mechanism.A[r];
+            else
+                k[r] = mechanism.A[r]*pow(Te,mechanism.b[r])*exp(-mechanism.C[r]/Te);
+        }
+        K[mechanism.row[r]][mechanism.col[r]] = k[r];
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the rate coefficients that depend on the gas temperature and their derivatives with Tg, and store
+// them in the K array. The wall recombination is 0.5*(g/(2R))*sqrt(8kB*Tg/(pi*m)), with the recombination
+// probability g=g0*exp(-Ta/Tg).
+// --------------------------------------------------------------------------------------------------------
+void calculateGasTemperatureRates ()
+{
+    // Local variables
+    int r;
+    double *k = mechanism.k;
+
+    #ifdef MECHANISM_KERNELS
+        if (mechanism.kernels)
+            kernelGasTemperatureRates(k, mechanism.dkdTg);
+    #endif
+
+    for (r=0 ; r<mechanism.NoReactions ; r++)
+    {
+        if (mechanism.form[r] != rateGasTemperature && mechanism.form[r] != rateWall)
+            continue;
+
+        if (!mechanism.kernels && mechanism.form[r] == rateGasTemperature)
+        {
+            k[r] = mechanism.A[r]*pow(Tg/mechanism.T0[r],mechanism.b[r])*exp(-mechanism.C[r]/Tg);
+            mechanism.dkdTg[r] = k[r]*(mechanism.b[r]/Tg + mechanism.C[r]/(Tg*Tg));
+        }
+        else if (!mechanism.kernels)
+        {
+            k[r] = 0.5*(mechanism.A[r]*exp(-mechanism.b[r]/Tg)/(2*R))*sqrt(8*kB*Tg/(pi*mechanism.mass[mechanism.reactant[3*r]]));
+            mechanism.dkdTg[r] = k[r]*(mechanism.b[r]/(Tg*Tg) + 0.5/Tg);
+        }
+        K[mechanism.row[r]][mechanism.col[r]] = k[r];
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Copy the rate coefficients of the mechanism from the K array, after the Boltzmann solver has updated it.
+// The functions below use the copy.
+// --------------------------------------------------------------------------------------------------------
+void gatherMechanismRates ()
+{
+    // Local variables
+    int r;
+
+    for (r=0 ; r<mechanism.NoReactions ; r++)
+        mechanism.k[r] = K[mechanism.row[r]][mechanism.col[r]];
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the densities of all the species from the unknowns x of the balance equations. The electron
+// density follows from quasi-neutrality, and the density of each closure species is its fraction of the
+// total density n minus the densities of its family. The last entry of d has unit density, for the unused
+// reactant slots.
+// --------------------------------------------------------------------------------------------------------
+void mechanismDensities (const double *x, double *d)
+{
+    // Local variables
+    int l, s;
+
+    for (l=0 ; l<mechanism.NoSpecies ; l++)
+        d[l] = mechanism.fraction[l]*n;
+    d[mechanism.NoSpecies] = 1.0;
+
+    for (l=0 ; l<mechanism.NoUnknowns ; l++)
+    {
+        s = mechanism.unknown[l];
+        d[s] = x[l];
+        d[mechanism.electron] += mechanism.charge[s]*x[l];
+        d[mechanism.family[s]] -= x[l];
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Gather the unknowns x of the balance equations from the densities of the model, or from the densities of
+// the previous inner iteration (*_0) if previous is true
+// --------------------------------------------------------------------------------------------------------
+void getUnknowns (double *x, bool previous)
+{
+    // Local variables
+    int l;
+    const double *density = previous ? speciesDensity_0 : speciesDensity;
+
+    x[0] = previous ? nH_0 : nH;
+    x[1] = previous ? nHplus_0 : nHplus;
+    x[2] = previous ? nH2plus_0 : nH2plus;
+    x[3] = previous ? nH3plus_0 : nH3plus;
+    for (l=NoHydrogenUnknowns ; l<mechanism.NoUnknowns ; l++)
+        x[l] = density[mechanism.unknown[l]];
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Update the densities of all the species from the unknowns of the model, after nH, nH+, nH2+, nH3+ or the
+// other unknowns have changed. The closures ne and nH2, the total density of the neutral species and the
+// composition of the neutral species of the cross-section file are updated too.
+// --------------------------------------------------------------------------------------------------------
+void updateClosureDensities ()
+{
+    // Local variables
+    int l;
+    double x[mechanism.NoUnknowns], total=0.0;
+
+    getUnknowns(x, false);
+    mechanismDensities(x, speciesDensity);
+    ne = speciesDensity[mechanism.electron];
+    nH2 = speciesDensity[mechanism.background];
+
+    nNeutral = 0.0;
+    for (l=0 ; l<mechanism.NoSpecies ; l++)
+        if (mechanism.charge[l] == 0.0)
+            nNeutral += speciesDensity[l];
+
+    for (l=0 ; l<NoNeutralSpecies ; l++)
+        total += speciesDensity[mechanism.neutral[l]];
+    for (l=0 ; l<NoNeutralSpecies ; l++)
+        neutralFraction[l] = speciesDensity[mechanism.neutral[l]]/total;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Set the densities of the model from the unknowns x of the balance equations, with their closures
+// --------------------------------------------------------------------------------------------------------
+void setUnknowns (const double *x)
+{
+    // Local variables
+    int l;
+
+    nH = x[0];
+    nHplus = x[1];
+    nH2plus = x[2];
+    nH3plus = x[3];
+    for (l=NoHydrogenUnknowns ; l<mechanism.NoUnknowns ; l++)
+        speciesDensity[mechanism.unknown[l]] = x[l];
+    updateClosureDensities();
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Relative change of the unknowns that are not hydrogen species from the densities of a previous iteration
+// (speciesDensity_0 or speciesDensity_old). It is zero for the hydrogen model.
+// --------------------------------------------------------------------------------------------------------
+double otherUnknownsError (const double *previous)
+{
+    // Local variables
+    int l, s;
+    double err=0.0;
+
+    for (l=NoHydrogenUnknowns ; l<mechanism.NoUnknowns ; l++)
+    {
+        s = mechanism.unknown[l];
+        err = fmax(err, relativeError(speciesDensity[s], previous[s]));
+    }
+
+    return err;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Copy the unknowns that are not hydrogen species to the densities of a previous iteration
+// --------------------------------------------------------------------------------------------------------
+void copyOtherUnknowns (double *previous)
+{
+    // Local variables
+    int l;
+
+    for (l=NoHydrogenUnknowns ; l<mechanism.NoUnknowns ; l++)
+        previous[mechanism.unknown[l]] = speciesDensity[mechanism.unknown[l]];
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the rates (m-3/s) of all the reactions for the densities d, with the gathered rate coefficients
+// --------------------------------------------------------------------------------------------------------
+void mechanismRates (const double *d)
+{
+    // Local variables
+    int r;
+    const int *a = mechanism.reactant;
+
+    for (r=0 ; r<mechanism.NoReactions ; r++)
+        mechanism.w[r] = mechanism.k[r]*d[a[3*r]]*d[a[3*r+1]]*d[a[3*r+2]];
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the source terms (m-3/s) of the unknowns x of the balance equations
+// --------------------------------------------------------------------------------------------------------
+void speciesSources (const double *x, double *f)
+{
+    // Local variables
+    int l, p;
+    double d[mechanism.NoSpecies+1];
+    const sparseMatrix *S = &mechanism.stoichiometry;
+
+    #ifdef MECHANISM_KERNELS
+        if (mechanism.kernels)
+        {
+            kernelSources(mechanism.k, x, f);
+            return;
+        }
+    #endif
+
+    mechanismDensities(x, d);
+    mechanismRates(d);
+
+    for (l=0 ; l<mechanism.NoUnknowns ; l++)
+    {
+        f[l] = 0.0;
+        for (p=S->rowStart[l] ; p<S->rowStart[l+1] ; p++)
+            f[l] += S->value[p]*mechanism.w[S->column[p]];
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the first-order loss frequencies (1/s) of the unknowns, which are the sums of the rate
+// coefficients of the reactions with the unknown as their only reactant (the wall losses)
+// --------------------------------------------------------------------------------------------------------
+void speciesLossFrequencies (double *Kloss)
+{
+    // Local variables
+    int l, r;
+    const int *a = mechanism.reactant;
+
+    for (l=0 ; l<mechanism.NoUnknowns ; l++)
+    {
+        Kloss[l] = 0.0;
+        for (r=0 ; r<mechanism.NoReactions ; r++)
+            if (mechanism.order[r] == 1 && a[3*r] == mechanism.unknown[l] && mechanism.nu[l*mechanism.NoReactions+r] < 0.0)
+                Kloss[l] += mechanism.k[r];
+
+        if (Kloss[l] <= 0.0)
+        {
+            printf("Error: The species %s has no first-order (wall) loss in the file: %s\n",mechanism.name[mechanism.unknown[l]],mechanismFile);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Add to the loss frequencies (1/s) of the unknowns that are not hydrogen species the losses by collisions
+// at the unknowns x, which are the rate coefficients times the densities of the other reactants. The ions of
+// a diluent are usually lost by charge exchange with the background gas much faster than at the wall, and
+// the SOR method diverges with the wall losses alone. The hydrogen unknowns keep the wall losses of the
+// original model.
+// --------------------------------------------------------------------------------------------------------
+void speciesCollisionLosses (const double *x, double *Kloss)
+{
+    // Local variables
+    int l, r, slot, other;
+    double d[mechanism.NoSpecies+1], frequency;
+    const int *a = mechanism.reactant;
+
+    mechanismDensities(x, d);
+
+    for (l=NoHydrogenUnknowns ; l<mechanism.NoUnknowns ; l++)
+        for (r=0 ; r<mechanism.NoReactions ; r++)
+        {
+            if (mechanism.order[r] < 2 || mechanism.nu[l*mechanism.NoReactions+r] >= 0.0)
+                continue;
+
+            for (slot=0 ; slot<3 ; slot++)
+                if (a[3*r+slot] == mechanism.unknown[l])
+                    break;
+            if (slot == 3)
+                continue;
+
+            frequency = -mechanism.nu[l*mechanism.NoReactions+r]*mechanism.k[r];
+            for (other=0 ; other<3 ; other++)
+                if (other != slot)
+                    frequency *= d[a[3*r+other]];
+            Kloss[l] += frequency;
+        }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the Jacobian of the source terms of the unknowns in the sparse pattern of buildJacobianPattern
+// --------------------------------------------------------------------------------------------------------
+void speciesJacobianSparse (const double *x, sparseMatrix *J)
+{
+    // Local variables
+    int c, r, slot;
+    double d[mechanism.NoSpecies+1];
+    const int *a = mechanism.reactant;
+
+    #ifdef MECHANISM_KERNELS
+        if (mechanism.kernels)
+        {
+            kernelSourceJacobian(mechanism.k, x, J->value);
+            return;
+        }
+    #endif
+
+    mechanismDensities(x, d);
+
+    for (c=0 ; c<J->nnz ; c++)
+        J->value[c] = 0.0;
+
+    for (c=0 ; c<mechanism.NoContributions ; c++)
+    {
+        r = mechanism.contributionReaction[c];
+        slot = mechanism.contributionSlot[c];
+        J->value[mechanism.contributionEntry[c]] += mechanism.contributionCoefficient[c]*mechanism.k[r]*d[a[3*r+(slot+1)%3]]*d[a[3*r+(slot+2)%3]];
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the Jacobian of the source terms of the unknowns, stored row by row in the dense matrix J
+// --------------------------------------------------------------------------------------------------------
+void speciesSourceJacobian (const double *x, double *J)
+{
+    speciesJacobianSparse(x, &mechanism.jacobian);
+    sparseToDense(&mechanism.jacobian, J);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the derivatives of the source terms of the unknowns with the gas temperature, at constant
+// densities (see calculateGasTemperatureRates)
+// --------------------------------------------------------------------------------------------------------
+void speciesSourceTemperature (const double *x, double *dfdTg)
+{
+    // Local variables
+    int l, p, r;
+    double d[mechanism.NoSpecies+1];
+    const int *a = mechanism.reactant;
+    const sparseMatrix *S = &mechanism.stoichiometry;
+
+    #ifdef MECHANISM_KERNELS
+        if (mechanism.kernels)
+        {
+            kernelSourceTemperature(mechanism.dkdTg, x, dfdTg);
+            return;
+        }
+    #endif
+
+    mechanismDensities(x, d);
+
+    for (l=0 ; l<mechanism.NoUnknowns ; l++)
+    {
+        dfdTg[l] = 0.0;
+        for (p=S->rowStart[l] ; p<S->rowStart[l+1] ; p++)
+        {
+            r = S->column[p];
+            if (mechanism.form[r] == rateGasTemperature || mechanism.form[r] == rateWall)
+                dfdTg[l] += S->value[p]*mechanism.dkdTg[r]*d[a[3*r]]*d[a[3*r+1]]*d[a[3*r+2]];
+        }
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the power terms of the energy equation and the quantities they depend on. The power terms of the
+// reactions are summed in one loop over the mechanism.
+// --------------------------------------------------------------------------------------------------------
+void calculatePowers ()
+{
+    // Local variables
+    int r, s;
+    double x[mechanism.NoUnknowns], d[mechanism.NoSpecies+1];
+    double P[NoPowerTerms] = {0.0}, energy, ions=0.0;
+    const int *a = mechanism.reactant;
+
+    getUnknowns(x, false);
+    mechanismDensities(x, d);
+
+    // Calculate additional parameters. The mean ion mass is taken over all the positive ions.
+    M = 0.0;
+    for (s=0 ; s<mechanism.NoSpecies ; s++)
+        if (mechanism.charge[s] > 0.0)
+        {
+            M += fabs(d[s])*mechanism.mass[s];
+            ions += fabs(d[s]);
+        }
+    M /= ions;
+    uB = sqrt(kB*fabs(Te*eVtoK)/M);
+    ns = ne;
+    rhoi = pin/(RH2*Tgi);
+    Q = (Tg/Tgi)*(2*n/(2*n-nH-nHplus+nH3plus))*Qi;
+    // rho = p/(RH2*Tg);
+
+    // Power terms of the reactions
+    gatherMechanismRates();
+    mechanismRates(d);
+    for (r=0 ; r<mechanism.NoReactions ; r++)
+    {
+        if (mechanism.power[r] < 0)
+            continue;
+
+        if (mechanism.energyForm[r] == energyThreshold)
+            energy = Ethr[mechanism.row[r]][mechanism.col[r]];
+        else if (mechanism.energyForm[r] == energyElastic)
+            energy = (3*me/mechanism.mass[(a[3*r] == mechanism.electron) ? a[3*r+1] : a[3*r]])*Te*eVtoJ;
+        else
+            energy = mechanism.energy[r];
+
+        P[mechanism.power[r]] += V*energy*mechanism.w[r];
+    }
+
+    // Calculate powers for energy equation
+    PinletHeat = rhoi*Qi*Cp*Tgi;
+    Pion = P[0];
+    Pdis = P[1];
+    Pele = P[2];
+    Pvib = P[3];
+    Prot = P[4];
+    Pela = P[5];
+    Pchem = P[6];
+    Piw  = (0.5+log(M/(2*pi*me)))*Te*eVtoJ*ns*uB*Ai;
+    Pew  = 2.0*Te*eVtoJ*ns*uB*Ai;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Print the densities of the species that are not variables of the hydrogen model (the diluents and their
+// ions), if there are any
+// --------------------------------------------------------------------------------------------------------
+void printOtherSpecies ()
+{
+    // Local variables
+    int l, s;
+    bool first=true;
+
+    for (s=0 ; s<mechanism.NoSpecies ; s++)
+    {
+        for (l=0 ; l<NoHydrogenUnknowns ; l++)
+            if (s == mechanism.unknown[l])
+                break;
+        if (s == mechanism.electron || s == mechanism.background || l < NoHydrogenUnknowns)
+            continue;
+
+        printf(first ? "Other species: n%s=%.4e" : " n%s=%.4e", mechanism.name[s], speciesDensity[s]);
+        first = false;
+    }
+    if (!first)
+        printf(" \n");
+}
@@ -0,0 +1,370 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          profiler.h
+    Type:               header file
+    Short Description:  This file contains the timers and the counters of the phases of the solution.
+
+Description
+===========
+When profileOutput is not none, every phase of the solution (the balance equations, the energy
+equation, the Boltzmann solvers and each step of a BOLSIG+ call) is timed with the monotonic clock
+around its call in simulation.h, and the calls and the inner iterations of the phase are counted,
+in total and per outer iteration. The summary is written as JSON to profileOutput when the
+simulation is finalized. When profileTrace is not none, every timed call is also stored as an
+event, and the timeline is written to profileTrace in the Chrome trace format (chrome://tracing or
+ui.perfetto.dev). The benchmark (see benchmark.h) and the convergence history (see
+convergenceHistory.h) turn the timers on without the files, to read the counters and the times of
+the iterations. The time steps of a transient simulation (see transient.h) are timed as one phase,
+with their Newton iterations as inner iterations.
+
+When the profiler is off, each timer is a function call that returns at once. The threads of a
+sweep and the contexts of the library write their own files, with the number of the sweep point
+or context appended to the file names.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- profileClock                  double      Read the monotonic clock in seconds.
+- initializeProfile             void        Reset the timers and counters, when the simulation is initialized.
+- profileStart                  void        Start the timer of a phase.
+- profileStop                   void        Stop the timer of a phase and add its time to the counters.
+- profileCount                  void        Add inner iterations to the counter of a phase.
+- workerFileName                void        Append the sweep point or library context to a file name.
+- writeProfileSummary           void        Write the JSON summary of the timers and counters.
+- writeProfileTrace             void        Write the timeline of the timed calls in the Chrome trace format.
+- finalizeProfile               void        Write the profile files and release the memory of the profiler.
+
+---------------------------------------------------------------------------------------------  */
+
+// Phases of the solution that are timed. A solution is one call of runSimulation, and an iteration is
+// one outer iteration of it.
+enum
+{
+    PROFILE_SETUP, PROFILE_SOLUTION, PROFILE_ITERATION, PROFILE_BALANCE, PROFILE_ANDERSON, PROFILE_TWOTERM,
+    PROFILE_TABLE, PROFILE_BOLSIG_INPUT, PROFILE_BOLSIG_SPECULATION, PROFILE_BOLSIG_CACHE, PROFILE_BOLSIG_RUN,
+    PROFILE_BOLSIG_OUTPUT, PROFILE_ENERGY, PROFILE_TRANSIENT, NoProfilePhases
+};
+
+const char *profilePhaseName[NoProfilePhases] =
+{
+    "setup", "solution", "iteration", "balanceEquations", "anderson", "twoTermBoltzmann",
+    "rateTable", "bolsigInput", "bolsigSpeculation", "bolsigCache", "bolsigRun",
+    "bolsigOutput", "energyEquation", "transientStep"
+};
+
+// Timer and counters of a phase (times in seconds)
+typedef struct
+{
+    double start;                   // Start of the current call
+    int calls;                      // Number of calls
+    long iterations;                // Inner iterations of all the calls
+    double total, min, max;         // Time of all the calls, and of the shortest and the longest one
+} profilePhase;
+
+// Time and inner iterations of each phase in one outer iteration
+typedef struct
+{
+    int solution, iteration;
+    double time[NoProfilePhases];
+    long iterations[NoProfilePhases];
+} profileIteration;
+
+// Timed call of the timeline
+typedef struct
+{
+    int phase, iteration;
+    double start, duration;
+} profileEvent;
+
+// The timers are also on when profileCounters is set, without the files (see benchmark.h)
+THREAD_LOCAL bool profiling=false, profilingTrace=false, profileInIteration=false, profileCounters=false;
+THREAD_LOCAL double profileOrigin;
+THREAD_LOCAL int profileSolutions;
+THREAD_LOCAL profilePhase profilePhases[NoProfilePhases];
+THREAD_LOCAL profileIteration *profileIterations=NULL;
+THREAD_LOCAL int NoProfileIterations=0, capacity_profileIterations=0;
+THREAD_LOCAL profileEvent *profileEvents=NULL;
+THREAD_LOCAL int NoProfileEvents=0, capacity_profileEvents=0;
+
+
+// --------------------------------------------------------------------------------------------------------
+// Read the monotonic clock in seconds. It is not affected by the changes of the system time.
+// --------------------------------------------------------------------------------------------------------
+double profileClock ()
+{
+    // Local variables
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + 1.0e-9*(double) now.tv_nsec;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Reset the timers and the counters, when the simulation is initialized after the input file is read
+// --------------------------------------------------------------------------------------------------------
+void initializeProfile ()
+{
+    // Local variables
+    int l;
+
+    profiling = (strcmp(profileOutput,"") != 0 && strcmp(profileOutput,"none") != 0);
+    profilingTrace = (strcmp(profileTrace,"") != 0 && strcmp(profileTrace,"none") != 0);
+    profiling = profiling || profilingTrace || profileCounters || (strcmp(historyOutput,"") != 0 && strcmp(historyOutput,"none") != 0);
+    if (!profiling)
+        return;
+
+    for (l=0 ; l<NoProfilePhases ; l++)
+    {
+        profilePhases[l].calls = 0;
+        profilePhases[l].iterations = 0;
+        profilePhases[l].total = profilePhases[l].max = 0.0;
+        profilePhases[l].min = INFINITY;
+    }
+    profileSolutions = 0;
+    profileInIteration = false;
+    NoProfileIterations = NoProfileEvents = 0;
+    profileOrigin = profileClock();
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Start the timer of a phase. The start of an outer iteration adds a new entry to the table of the iterations.
+// --------------------------------------------------------------------------------------------------------
+void profileStart (int phase)
+{
+    // Local variables
+    int l;
+    profileIteration *entry;
+
+    if (!profiling)
+        return;
+
+    if (phase == PROFILE_SOLUTION)
+        profileSolutions++;
+
+    if (phase == PROFILE_ITERATION)
+    {
+        if (NoProfileIterations == capacity_profileIterations)
+        {
+            capacity_profileIterations = (capacity_profileIterations > 0) ? 2*capacity_profileIterations : 64;
+            profileIterations = (profileIteration*) realloc(profileIterations, capacity_profileIterations*sizeof(profileIteration));
+        }
+        entry = &profileIterations[NoProfileIterations++];
+        entry->solution = profileSolutions;
+        entry->iteration = count;
+        for (l=0 ; l<NoProfilePhases ; l++)
+        {
+            entry->time[l] = 0.0;
+            entry->iterations[l] = 0;
+        }
+        profileInIteration = true;
+    }
+
+    profilePhases[phase].start = profileClock();
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Stop the timer of a phase, and add its time to the totals, to the current outer iteration and to the
+// timeline
+// --------------------------------------------------------------------------------------------------------
+void profileStop (int phase)
+{
+    // Local variables
+    double stop, duration;
+    profilePhase *timer = &profilePhases[phase];
+
+    if (!profiling)
+        return;
+
+    stop = profileClock();
+    duration = stop - timer->start;
+
+    timer->calls++;
+    timer->total += duration;
+    timer->min = fmin(timer->min, duration);
+    timer->max = fmax(timer->max, duration);
+
+    if (profileInIteration)
+        profileIterations[NoProfileIterations-1].time[phase] += duration;
+    if (phase == PROFILE_ITERATION)
+        profileInIteration = false;
+
+    if (profilingTrace)
+    {
+        if (NoProfileEvents == capacity_profileEvents)
+        {
+            capacity_profileEvents = (capacity_profileEvents > 0) ? 2*capacity_profileEvents : 256;
+            profileEvents = (profileEvent*) realloc(profileEvents, capacity_profileEvents*sizeof(profileEvent));
+        }
+        profileEvents[NoProfileEvents].phase = phase;
+        profileEvents[NoProfileEvents].iteration = count;
+        profileEvents[NoProfileEvents].start = timer->start - profileOrigin;
+        profileEvents[NoProfileEvents].duration = duration;
+        NoProfileEvents++;
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Add the inner iterations of a call (e.g. count_SB of the balance equations) to the counters of a phase
+// --------------------------------------------------------------------------------------------------------
+void profileCount (int phase, int iterations)
+{
+    if (!profiling)
+        return;
+
+    profilePhases[phase].iterations += iterations;
+    if (profileInIteration)
+        profileIterations[NoProfileIterations-1].iterations[phase] += iterations;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Append the sweep point or the library context (workerId) to a file name, before its extension, so that
+// the threads do not write the same file
+// --------------------------------------------------------------------------------------------------------
+void workerFileName (const char *name, char *filename)
+{
+    // Local variables
+    const char *extension = strrchr(name, '.');
+
+    if (workerId == 0)
+        snprintf(filename, MAXCHAR, "%s", name);
+    else if (extension == NULL || strchr(extension, '/') != NULL)
+        snprintf(filename, MAXCHAR, "%s_%d", name, workerId);
+    else
+        snprintf(filename, MAXCHAR, "%.*s_%d%s", (int)(extension-name), name, workerId, extension);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write the JSON summary of the timers and the counters: the totals of every phase, the statistics of the
+// BOLSIG+ runs and the times and inner iterations of every outer iteration
+// --------------------------------------------------------------------------------------------------------
+void writeProfileSummary ()
+{
+    // Local variables
+    int l, m;
+    bool first;
+    char filename[MAXCHAR];
+    FILE *fp;
+    const profilePhase *timer;
+
+    workerFileName(profileOutput, filename);
+    fp = fopen(filename, "w");
+    if (fp == NULL)
+    {
+        printf("Error: Could not open the file: %s\n",filename);
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"wallTime\": %.9g,\n", profileClock() - profileOrigin);
+    fprintf(fp, "  \"solutions\": %d,\n", profileSolutions);
+    fprintf(fp, "  \"outerIterations\": %d,\n", NoProfileIterations);
+    fprintf(fp, "  \"speciesSolver\": \"%s\",\n", speciesSolver);
+    fprintf(fp, "  \"energySolver\": \"%s\",\n", energySolver);
+    fprintf(fp, "  \"boltzmannSolver\": \"%s\",\n", boltzmannSolver);
+
+    // Totals of the phases that were called
+    fprintf(fp, "  \"phases\": {");
+    first = true;
+    for (l=0 ; l<NoProfilePhases ; l++)
+    {
+        timer = &profilePhases[l];
+        if (timer->calls == 0)
+            continue;
+        fprintf(fp, "%s\n    \"%s\": {\"calls\": %d, \"iterations\": %ld, \"total\": %.9g, \"mean\": %.9g, \"min\": %.9g, \"max\": %.9g}",
+                first ? "" : ",", profilePhaseName[l], timer->calls, timer->iterations, timer->total, timer->total/timer->calls, timer->min, timer->max);
+        first = false;
+    }
+    fprintf(fp, "\n  },\n");
+
+    // Counters of the BOLSIG+ calls
+    fprintf(fp, "  \"counters\": {\"bolsigRuns\": %d, \"cacheHits\": %d, \"cacheMisses\": %d, \"speculativeRuns\": %d, \"speculativeHits\": %d},\n",
+            profilePhases[PROFILE_BOLSIG_RUN].calls, count_cacheHits, count_cacheMisses, count_speculationRuns, count_speculationHits);
+
+    // Outer iterations, with the phases that were called in each one
+    fprintf(fp, "  \"iterations\": [");
+    for (m=0 ; m<NoProfileIterations ; m++)
+    {
+        fprintf(fp, "%s\n    {\"solution\": %d, \"iteration\": %d, \"time\": {", m > 0 ? "," : "", profileIterations[m].solution, profileIterations[m].iteration);
+        first = true;
+        for (l=PROFILE_ITERATION ; l<NoProfilePhases ; l++)
+            if (profileIterations[m].time[l] > 0.0)
+            {
+                fprintf(fp, "%s\"%s\": %.9g", first ? "" : ", ", profilePhaseName[l], profileIterations[m].time[l]);
+                first = false;
+            }
+        fprintf(fp, "}, \"innerIterations\": {\"%s\": %ld, \"%s\": %ld}}",
+                profilePhaseName[PROFILE_BALANCE], profileIterations[m].iterations[PROFILE_BALANCE],
+                profilePhaseName[PROFILE_ENERGY], profileIterations[m].iterations[PROFILE_ENERGY]);
+    }
+    fprintf(fp, "\n  ]\n}\n");
+
+    fclose(fp);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write the timeline of the timed calls as complete events ("ph": "X") of the Chrome trace format, with the
+// times in microseconds. The sweep point or library context is the thread of the events.
+// --------------------------------------------------------------------------------------------------------
+void writeProfileTrace ()
+{
+    // Local variables
+    int l;
+    char filename[MAXCHAR];
+    FILE *fp;
+
+    workerFileName(profileTrace, filename);
+    fp = fopen(filename, "w");
+    if (fp == NULL)
+    {
+        printf("Error: Could not open the file: %s\n",filename);
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    for (l=0 ; l<NoProfileEvents ; l++)
+        fprintf(fp, "%s\n{\"name\": \"%s\", \"cat\": \"chempaig\", \"ph\": \"X\", \"pid\": %ld, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"iteration\": %d}}",
+                l > 0 ? "," : "", profilePhaseName[profileEvents[l].phase], (long) getpid(), workerId,
+                1.0e6*profileEvents[l].start, 1.0e6*profileEvents[l].duration, profileEvents[l].iteration);
+    fprintf(fp, "\n]}\n");
+
+    fclose(fp);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write the profile files and release the memory of the profiler, when the simulation is finalized
+// --------------------------------------------------------------------------------------------------------
+void finalizeProfile ()
+{
+    if (!profiling)
+        return;
+
+    if (strcmp(profileOutput,"") != 0 && strcmp(profileOutput,"none") != 0)
+        writeProfileSummary();
+    if (profilingTrace)
+        writeProfileTrace();
+
+    free(profileIterations);
+    free(profileEvents);
+    profileIterations = NULL;
+    profileEvents = NULL;
+    capacity_profileIterations = capacity_profileEvents = 0;
+    profiling = profilingTrace = false;
+}
@@ -0,0 +1,218 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          pulse.h
+    Type:               header file
+    Short Description:  This file contains the periodic steady state of a pulsed or modulated
+                        microwave power.
+
+Description
+===========
+The line "pulseWaveform Square;" of the input file drives the plasma with a pulsed power: the field E
+(pulseVariable E) or the power absorbed by the electrons (pulseVariable Pmw, in W) is at the value
+of the input file for pulseDutyCycle of the period 1/pulseFrequency, and at 1-pulseDepth times this
+value for the rest of the period. The Sine waveform modulates the value between the same levels,
+with the high level at the start of the period. With Pmw, E is solved at every state, so that the
+electrons absorb the power of the waveform (see transient.h).
+
+After many periods, the plasma repeats the same cycle, the periodic steady state. The gas heats up
+and cools down in milliseconds, so it takes hundreds of pulses to reach it by integrating in time,
+and it is instead solved with the shooting method: the state y0 at the start of the period is the
+solution of F(y0) = y(T; y0) - y0 = 0, where y(T; y0) is the state after the integration of one
+period from y0 (see integratePulses of transient.h). Every shooting iteration integrates one period
+together with the sensitivities S = dy(T)/dy0 (the monodromy matrix), and takes the Newton step
+(I - S)*dy0 = y(T) - y0, which is limited so that the densities drop at most to a tenth of their
+values. The iterations start from the steady state of the input values, and converge in a few
+periods, when the change of every unknown over the period is below pulseTolerance times its value
+plus absoluteTolerance (zero for Tg), or stop after pulseIterations periods.
+
+The state of the period is written at pulseSamples times, at the middle of equal intervals, to the
+file pulseOutput, and its averages over the samples are the cycle averages of the plasma, which are
+printed at the end with the state at the start of the period.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- checkPulseInput               void        Check the parameters of the pulsed power.
+- runPulse                      void        Solve the periodic steady state of the pulsed power with the shooting method.
+
+---------------------------------------------------------------------------------------------  */
+
+
+// --------------------------------------------------------------------------------------------------------
+// Check the parameters of the pulsed power of the input file
+// --------------------------------------------------------------------------------------------------------
+void checkPulseInput ()
+{
+    if (strcmp(pulseWaveform,"Square") != 0 && strcmp(pulseWaveform,"Sine") != 0)
+    {
+        printf("Error: The pulse waveform %s is not one of: none, Square, Sine\n",pulseWaveform);
+        exit(EXIT_FAILURE);
+    }
+    if (strcmp(pulseVariable,"E") != 0 && strcmp(pulseVariable,"Pmw") != 0)
+    {
+        printf("Error: The pulsed variable %s is not one of: E, Pmw\n",pulseVariable);
+        exit(EXIT_FAILURE);
+    }
+    if (strcmp(pulseVariable,"Pmw") == 0 && Pmw <= 0.0)
+    {
+        printf("Error: The absorbed power Pmw must be positive for a pulsed power!\n");
+        exit(EXIT_FAILURE);
+    }
+    if (pulseFrequency <= 0.0 || pulseDutyCycle <= 0.0 || pulseDutyCycle > 1.0 || pulseDepth < 0.0 || pulseDepth >= 1.0)
+    {
+        printf("Error: Wrong pulsed power in the file: input.txt. The frequency must be positive, the duty cycle in (0, 1] and the depth in [0, 1)\n");
+        exit(EXIT_FAILURE);
+    }
+    if (pulseSamples < 1 || pulseIterations < 1)
+    {
+        printf("Error: The samples and the iterations of the pulsed power must be at least 1!\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the periodic steady state of the pulsed power with the shooting method, from the steady state of the
+// input values, and write the last period to the results file
+// --------------------------------------------------------------------------------------------------------
+void runPulse ()
+{
+    // Local variables
+    int N, M, i, j, l, iteration, failed=0;
+    double t, period, norm=INFINITY, lambda, average[TransientColumns]={0.0};
+
+    checkPulseInput();
+    period = 1.0/pulseFrequency;
+
+    printf("Periodic steady state of the %s waveform of %s at %g Hz\n\n", pulseWaveform, pulseVariable, pulseFrequency);
+
+    // Steady state of the input values
+    printScreenOutput = false;
+    initializeSimulation();
+    runSimulation();
+    printScreenOutput = true;
+    if (convergenceStatus != SOLUTION_CONVERGED)
+    {
+        printf("Error: The steady state of the input values did not converge, the solution %s!\n",convergenceStatusName(convergenceStatus));
+        exit(EXIT_FAILURE);
+    }
+
+    profileStart(PROFILE_SOLUTION);
+    N = mechanism.NoUnknowns;
+    M = N+1;
+
+    double y0[M], y[M], S[M*M], A[M][M], dy0[M], sampleTime[pulseSamples];
+    transientSampling out = {0};
+
+    getUnknowns(y0, false);
+    y0[N] = Tg;
+    for (l=0 ; l<pulseSamples ; l++)
+        sampleTime[l] = (l + 0.5)*period/pulseSamples;
+
+    transientHeatCapacity = rho*V*Cp;
+    transientSteps = transientRejected = transientJacobians = transientEvaluations = 0;
+    pulseBase = (strcmp(pulseVariable,"Pmw") == 0) ? Pmw : E;
+    EEDFfixedGrid = true;
+
+    for (iteration=1 ; iteration<=pulseIterations ; iteration++)
+    {
+        // One period from y0, with the sensitivities from the identity, and its samples
+        memset(&out, 0, sizeof(out));
+        out.time = sampleTime;
+        out.NoTimes = pulseSamples;
+        out.level = LOG_DEBUG;
+        out.fp = openTransientResults(pulseOutput);
+
+        memcpy(y, y0, sizeof(y));
+        for (l=0 ; l<M*M ; l++)
+            S[l] = (l/M == l%M);
+        t = 0.0;
+        failed = integratePulses(M, y, S, &t, period, &out);
+        fclose(out.fp);
+        if (failed)
+            break;
+
+        // Averages of the samples of this period, which is complete
+        for (l=0 ; l<TransientColumns ; l++)
+            average[l] = (out.samples > 0) ? out.sum[l]/out.samples : 0.0;
+
+        // Change of the state over the period
+        norm = 0.0;
+        for (l=0 ; l<M ; l++)
+        {
+            dy0[l] = y[l] - y0[l];
+            norm = fmax(norm, fabs(dy0[l])/(pulseTolerance*fabs(y0[l]) + ((l < N) ? absoluteTolerance : 0.0)));
+        }
+        if (!isfinite(norm))
+        {
+            failed = 1;
+            break;
+        }
+
+        logMessage(LOG_ITERATION, "Shooting iteration %d: Norm=%.2e Steps=%d nH=%.4e Tg=%.2f (cycle averages ne=%.4e Tg=%.2f)\n", iteration, norm,
+                   transientSteps, y0[0], y0[N], average[1], average[7]);
+        if (norm <= 1.0)
+            break;
+
+        // Newton step of the shooting, (I - S)*dy0 = y(T) - y0, limited so that the unknowns remain positive
+        for (i=0 ; i<M ; i++)
+            for (j=0 ; j<M ; j++)
+                A[i][j] = (i == j) - S[i*M+j];
+        if (solveLinearSystem(M, A, dy0) != 0)
+        {
+            logMessage(LOG_WARNING, "Warning: The monodromy matrix of the shooting method is singular\n");
+            failed = 1;
+            break;
+        }
+        lambda = 1.0;
+        for (l=0 ; l<M ; l++)
+            if (y0[l] + dy0[l] < 0.1*y0[l])
+                lambda = fmin(lambda, 0.9*y0[l]/(-dy0[l]));
+        for (l=0 ; l<M ; l++)
+            y0[l] += lambda*dy0[l];
+    }
+    profileStop(PROFILE_SOLUTION);
+
+    count = (iteration > pulseIterations) ? pulseIterations : iteration;
+    if (solverFailed)
+        convergenceStatus = SOLUTION_FAILED;
+    else if (failed)
+        convergenceStatus = SOLUTION_DIVERGED;
+    else if (norm > 1.0)
+        convergenceStatus = SOLUTION_MAXITERATIONS;
+    else
+        convergenceStatus = SOLUTION_CONVERGED;
+    if (convergenceStatus != SOLUTION_CONVERGED)
+        logMessage(LOG_WARNING, "Warning: The shooting iterations stopped at iteration %d, the periodic steady state %s (norm=%.2e)\n", count,
+                   convergenceStatusName(convergenceStatus), norm);
+
+    // State at the start of the period. The cycle averages are those of the last complete period (zero if the
+    // first period failed).
+    updateTransientElectrons(0.0, y0);
+    calculatePowers();
+
+    if (logEnabled(LOG_SUMMARY))
+    {
+        printf("\nPeriodic steady state: %d periods, %d steps (%d rejected), %d evaluations and %d Jacobians of the equations\n", count, transientSteps,
+               transientRejected, transientEvaluations, transientJacobians);
+        printf("Cycle averages: n=%.4e ne=%.4e nH=%.4e nH2=%.4e nH+=%.4e nH2+=%.4e nH3+=%.4e Tg=%.2f Te=%.2f E=%.4e Pabs=%.4e\n", average[0],
+               average[1], average[2], average[3], average[4], average[5], average[6], average[7], average[8], average[9], average[10]);
+        printf("The last period was written to the file: %s\n\n", pulseOutput);
+        printScreen_K_Ethr();
+        printf("State at the start of the period:\n");
+        printScreen_finalResults();
+        printOtherSpecies();
+    }
+
+    finalizeSimulation();
+}
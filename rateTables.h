@@ -0,0 +1,303 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          rateTables.h
+    Type:               header file
+    Short Description:  This file contains the pre-tabulated rate coefficients of the electron
+                        collisions and their interpolation.
+
+Description
+===========
+Instead of solving the Boltzmann equation at every outer iteration, the rate coefficients and
+the electron temperature are tabulated over a grid of reduced electric fields E/N and atomic
+hydrogen fractions nH/(nH+nH2). The table is filled with the in-process two-term Boltzmann solver,
+sweeping the grid so that every point starts from the EEDF of its neighbour. The rest of the
+conditions (gas temperature, ionization degree, field frequency) are kept at the values the table
+was built with, and the table is built again around the current state when the gas temperature or
+the ionization degree drift past a relative tolerance, or when E/N leaves its range. At runtime the
+logarithms of the rate coefficients are interpolated with monotone (Fritsch-Carlson) cubic Hermite
+splines, first along log(E/N) and then along the hydrogen fraction, so that no spurious extrema are
+introduced between the points of the table.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- monotoneSlopes                void        Calculate the slopes of the monotone cubic Hermite spline.
+- hermiteSpline                 double      Evaluate a cubic Hermite spline in an interval.
+- findTableInterval             int         Find the interval of a table axis that contains a value.
+- buildRateTable                void        Tabulate the rate coefficients over the E/N and hydrogen fraction grid.
+- interpolateRateTable          double      Interpolate the rate coefficients and the electron temperature from the table.
+- freeRateTable                 void        Release the memory of the table.
+- solveRateTable                double      Interpolate the rate coefficients for the current plasma state.
+
+---------------------------------------------------------------------------------------------  */
+
+// Number of points of the table in E/N and in the hydrogen fraction
+#define RateTableFieldPoints 17
+#define RateTableFractionPoints 11
+
+// The table covers E/N from 1/RateTableFieldRange to RateTableFieldRange times the E/N of the first iteration
+#define RateTableFieldRange 2.0
+
+// Relative drift of the gas temperature and of the ionization degree after which the table is built again
+#define RateTableTemperatureDrift 0.01
+#define RateTableIonizationDrift 0.05
+
+// Axes of the table (log of E/N and nH/(nH+nH2)), values and slopes along E/N. The values are stored as
+// tableValues[process][fraction point][field point], the last "process" being the electron temperature.
+THREAD_LOCAL double tableField[RateTableFieldPoints], tableFraction[RateTableFractionPoints];
+THREAD_LOCAL double ***tableValues=NULL, ***tableSlopes=NULL;
+
+// Gas temperature and ionization degree the table was built with
+THREAD_LOCAL double tableTemperature, tableIonDegree;
+
+
+// --------------------------------------------------------------------------------------------------------
+// Slopes of the monotone cubic Hermite spline through the points (x,y), according to Fritsch and Carlson.
+// The slope is zero at local extrema and it is limited so that the spline is monotone in every interval.
+// --------------------------------------------------------------------------------------------------------
+void monotoneSlopes (int N, const double *x, const double *y, double *d)
+{
+    // Local variables
+    int i;
+    double delta_left, delta_right, h_left, h_right, w1, w2;
+
+    if (N < 2)
+    {
+        d[0] = 0.0;
+        return;
+    }
+
+    for (i=1 ; i<N-1 ; i++)
+    {
+        h_left = x[i]-x[i-1];
+        h_right = x[i+1]-x[i];
+        delta_left = (y[i]-y[i-1])/h_left;
+        delta_right = (y[i+1]-y[i])/h_right;
+
+        // Weighted harmonic mean of the secant slopes, or zero at an extremum
+        if (delta_left*delta_right <= 0.0)
+            d[i] = 0.0;
+        else
+        {
+            w1 = 2.0*h_right + h_left;
+            w2 = h_right + 2.0*h_left;
+            d[i] = (w1+w2)/(w1/delta_left + w2/delta_right);
+        }
+    }
+
+    // One-sided slopes at the ends
+    d[0] = (y[1]-y[0])/(x[1]-x[0]);
+    d[N-1] = (y[N-1]-y[N-2])/(x[N-1]-x[N-2]);
+    if (N > 2)
+    {
+        if (d[0]*d[1] <= 0.0)
+            d[0] = 0.0;
+        if (d[N-1]*d[N-2] <= 0.0)
+            d[N-1] = 0.0;
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Cubic Hermite spline in the interval [x0,x1] with values y0, y1 and slopes d0, d1
+// --------------------------------------------------------------------------------------------------------
+double hermiteSpline (double x0, double x1, double y0, double y1, double d0, double d1, double x)
+{
+    // Local variables
+    double h = x1-x0, t = (x-x0)/(x1-x0);
+
+    return (2.0*t*t*t - 3.0*t*t + 1.0)*y0 + (t*t*t - 2.0*t*t + t)*h*d0 + (-2.0*t*t*t + 3.0*t*t)*y1 + (t*t*t - t*t)*h*d1;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Index of the interval [x[l],x[l+1]] of the axis x that contains the value. Values outside the table are
+// clamped to its first or last interval.
+// --------------------------------------------------------------------------------------------------------
+int findTableInterval (int N, const double *x, double value)
+{
+    // Local variables
+    int lo=0, hi=N-1, mid;
+
+    while (hi-lo > 1)
+    {
+        mid = (lo+hi)/2;
+        if (value < x[mid])
+            hi = mid;
+        else
+            lo = mid;
+    }
+
+    return lo;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Tabulate the logarithms of the rate coefficients and the electron temperature with the two-term Boltzmann
+// solver, around the reduced field EN_ref (V m2) and for the given frequency, gas temperature, ionization
+// degree and electron density
+// --------------------------------------------------------------------------------------------------------
+void buildRateTable (double EN_ref, double WN, double Tgas, double ionDegree, double ne_local)
+{
+    // Local variables
+    int l, ix, ie, step, NP = NoCollisions+1;
+    double fractions[2], **K_local, **Ethr_local, Te_local;
+
+    allocate(&K_local, react_num, subreact_num);
+    allocate(&Ethr_local, react_num, subreact_num);
+
+    tableTemperature = Tgas;
+    tableIonDegree = ionDegree;
+
+    tableValues = (double***) calloc(NP, sizeof(double**));
+    tableSlopes = (double***) calloc(NP, sizeof(double**));
+    for (l=0 ; l<NP ; l++)
+    {
+        allocate(&tableValues[l], RateTableFractionPoints, RateTableFieldPoints);
+        allocate(&tableSlopes[l], RateTableFractionPoints, RateTableFieldPoints);
+    }
+
+    for (ie=0 ; ie<RateTableFieldPoints ; ie++)
+        tableField[ie] = log(EN_ref) + log(RateTableFieldRange)*(2.0*ie/(RateTableFieldPoints-1) - 1.0);
+    for (ix=0 ; ix<RateTableFractionPoints ; ix++)
+        tableFraction[ix] = (double)ix/(RateTableFractionPoints-1);
+
+    // Sweep E/N back and forth, so that each solution starts from the EEDF of the previous point
+    for (ix=0 ; ix<RateTableFractionPoints ; ix++)
+    {
+        fractions[0] = 1.0 - tableFraction[ix];
+        fractions[1] = tableFraction[ix];
+
+        for (step=0 ; step<RateTableFieldPoints ; step++)
+        {
+            ie = (ix%2 == 0) ? step : RateTableFieldPoints-1-step;
+            Te_local = twoTermBoltzmann(exp(tableField[ie]), WN, Tgas, ionDegree, ne_local, fractions, K_local, Ethr_local);
+
+            for (l=0 ; l<NoCollisions ; l++)
+                tableValues[l][ix][ie] = log(fmax(K_local[collisions[l].reaction][collisions[l].subreaction], 1.0e-300));
+            tableValues[NoCollisions][ix][ie] = log(Te_local);
+        }
+    }
+
+    // Slopes along E/N
+    for (l=0 ; l<NP ; l++)
+        for (ix=0 ; ix<RateTableFractionPoints ; ix++)
+            monotoneSlopes(RateTableFieldPoints, tableField, tableValues[l][ix], tableSlopes[l][ix]);
+
+    for (l=0 ; l<react_num ; l++)
+    {
+        free(K_local[l]);
+        free(Ethr_local[l]);
+    }
+    free(K_local);
+    free(Ethr_local);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Interpolate the rate coefficients, threshold energies and electron temperature from the table, for the
+// reduced field EN (V m2) and the hydrogen fraction xH. The spline along the hydrogen fraction only needs
+// the four points around xH, so only these are interpolated along E/N.
+// --------------------------------------------------------------------------------------------------------
+double interpolateRateTable (double EN, double xH, double **K_local, double **Ethr_local)
+{
+    // Local variables
+    int l, m, ie, ix, first, last;
+    double logEN, y[4], x[4], d[4], value;
+
+    logEN = fmin(fmax(log(EN), tableField[0]), tableField[RateTableFieldPoints-1]);
+    xH = fmin(fmax(xH, tableFraction[0]), tableFraction[RateTableFractionPoints-1]);
+
+    ie = findTableInterval(RateTableFieldPoints, tableField, logEN);
+    ix = findTableInterval(RateTableFractionPoints, tableFraction, xH);
+    first = (ix > 0) ? ix-1 : ix;
+    last = (ix+2 < RateTableFractionPoints) ? ix+2 : RateTableFractionPoints-1;
+
+    for (l=0 ; l<=NoCollisions ; l++)
+    {
+        // Interpolate along E/N at the fraction points around xH
+        for (m=first ; m<=last ; m++)
+        {
+            x[m-first] = tableFraction[m];
+            y[m-first] = hermiteSpline(tableField[ie], tableField[ie+1], tableValues[l][m][ie], tableValues[l][m][ie+1], tableSlopes[l][m][ie], tableSlopes[l][m][ie+1], logEN);
+        }
+
+        // Interpolate along the hydrogen fraction
+        monotoneSlopes(last-first+1, x, y, d);
+        value = exp(hermiteSpline(x[ix-first], x[ix-first+1], y[ix-first], y[ix-first+1], d[ix-first], d[ix-first+1], xH));
+
+        if (l == NoCollisions)
+            return value;
+
+        K_local[collisions[l].reaction][collisions[l].subreaction] = (value > 1.0e-290) ? value : 0.0;
+        if (strcmp(collisions[l].type,"EXCITATION") == 0 || strcmp(collisions[l].type,"IONIZATION") == 0)
+            Ethr_local[collisions[l].reaction][collisions[l].subreaction] = collisions[l].param*eVtoJ;
+        else
+            Ethr_local[collisions[l].reaction][collisions[l].subreaction] = 0.0;
+    }
+
+    return 0.0;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Release the memory of the table
+// --------------------------------------------------------------------------------------------------------
+void freeRateTable ()
+{
+    // Local variables
+    int l, ix;
+
+    if (tableValues == NULL)
+        return;
+
+    for (l=0 ; l<=NoCollisions ; l++)
+    {
+        for (ix=0 ; ix<RateTableFractionPoints ; ix++)
+        {
+            free(tableValues[l][ix]);
+            free(tableSlopes[l][ix]);
+        }
+        free(tableValues[l]);
+        free(tableSlopes[l]);
+    }
+    free(tableValues);
+    free(tableSlopes);
+    tableValues = NULL;
+    tableSlopes = NULL;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Interpolate the rate coefficients for the current plasma state and return the electron temperature. The
+// table is built at the first call, with the conditions of that iteration. It is built again around the
+// current state if E/N leaves its range (e.g. when the model is solved again for other conditions in the
+// same thread), or if the gas temperature or the ionization degree drift away from the values of the table,
+// so that the converged solution does not depend on the conditions of the first iteration.
+// --------------------------------------------------------------------------------------------------------
+double solveRateTable (double **K_local, double **Ethr_local)
+{
+    // Local variables
+    double logEN = log(E/nNeutral), ionDegree = fabs(ne/nNeutral);
+
+    if (tableValues != NULL && (logEN < tableField[0] || logEN > tableField[RateTableFieldPoints-1]
+        || fabs(Tg-tableTemperature) > RateTableTemperatureDrift*tableTemperature
+        || fabs(ionDegree-tableIonDegree) > RateTableIonizationDrift*tableIonDegree))
+        freeRateTable();
+
+    if (tableValues == NULL)
+        buildRateTable(E/nNeutral, freq/nNeutral, Tg, ionDegree, ne);
+
+    return interpolateRateTable(E/nNeutral, nH/(nH+nH2), K_local, Ethr_local);
+}
+
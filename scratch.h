@@ -0,0 +1,432 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          scratch.h
+    Type:               header file
+    Short Description:  This file contains the private scratch directories of the BOLSIG+ runs and
+                        the launch of BOLSIG+.
+
+Description
+===========
+Every solver instance (a single run, a sweep point or a context of the library) that runs BOLSIG+
+gets its own scratch directory, which is created with mkdtemp under /dev/shm (a tmpfs, so the
+files of every iteration stay in memory), or under $TMPDIR or /tmp if /dev/shm is not available.
+The BOLSIG+ input and output files are written in this directory, with the names of the input
+file, and the cross-section file is linked into it. BOLSIG+ is started with posix_spawn, with an
+explicit argv and with the scratch directory as its working directory, so no shell is involved
+and its log file bolsiglog.txt is private as well. A file name cannot be given with a directory
+in the BOLSIG+ input file, since "/" starts a comment there, so BOLSIG+ only sees the file names.
+
+The scratch directories are removed by finalizeSimulation, and at exit if the program stops with
+an error. On Windows the scratch directory is created in the working directory and BOLSIG+ is
+started through the shell.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- removeDirectory               void        Remove a directory and the files in it.
+- removeAllScratchDirectories   void        Remove the scratch directories of all the threads, at exit.
+- registerScratchCleanup        void        Register the removal of the scratch directories at exit.
+- scratchBase                   const char* Directory in which the scratch directories and files are created.
+- makeScratchFile               void        Create a new scratch file with a unique name.
+- makeScratchDirectory          void        Create a new scratch directory with the cross-section file.
+- deleteScratchDirectory        void        Remove a scratch directory.
+- moveToScratchDirectory        void        Change the path of a BOLSIG+ file to the scratch directory of this thread.
+- createScratchDirectory        void        Create the scratch directory of the BOLSIG+ runs of this thread.
+- removeScratchDirectory        void        Remove the scratch directory of this thread.
+- startBOLSIG                   pid_t       Start BOLSIG+ in a scratch directory, without waiting for it.
+- waitBOLSIG                    bool        Wait for a BOLSIG+ process.
+- stopBOLSIG                    void        Stop a BOLSIG+ process whose results are not needed.
+- runBOLSIG                     bool        Run BOLSIG+ in the scratch directory and wait for it.
+
+---------------------------------------------------------------------------------------------  */
+
+// Scratch directory of the BOLSIG+ runs of this thread and absolute path of the BOLSIG+ executable
+THREAD_LOCAL char scratchDirectory[MAXCHAR]="";
+THREAD_LOCAL char bolsigExecutable[4*MAXCHAR];
+
+// Scratch directories of all the threads, which are removed at exit if the program stops with an error. The
+// registry grows by ScratchRegistryBlock directories when it is full.
+#define ScratchRegistryBlock 64
+char (*scratchRegistry)[MAXCHAR]=NULL;
+int scratchRegistrySize=0;
+pthread_mutex_t scratchLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_once_t scratchOnce = PTHREAD_ONCE_INIT;
+
+#ifndef _WIN32
+    extern char **environ;
+#endif
+
+
+// --------------------------------------------------------------------------------------------------------
+// Remove a directory and the files in it
+// --------------------------------------------------------------------------------------------------------
+void removeDirectory (const char *path)
+{
+    // Local variables
+    char file[4*MAXCHAR];
+    struct dirent *entry;
+    DIR *dir;
+
+    dir = opendir(path);
+    if (dir == NULL)
+        return;
+
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strcmp(entry->d_name,".") == 0 || strcmp(entry->d_name,"..") == 0)
+            continue;
+        snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+        remove(file);
+    }
+    closedir(dir);
+
+    rmdir(path);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Remove the scratch directories of all the threads. This is called at exit, so that the memory of /dev/shm
+// is released even if the program stops with an error.
+// --------------------------------------------------------------------------------------------------------
+void removeAllScratchDirectories (void)
+{
+    // Local variables
+    int l;
+
+    pthread_mutex_lock(&scratchLock);
+    for (l=0 ; l<scratchRegistrySize ; l++)
+        if (scratchRegistry[l][0] != '\0')
+        {
+            removeDirectory(scratchRegistry[l]);
+            scratchRegistry[l][0] = '\0';
+        }
+    pthread_mutex_unlock(&scratchLock);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Register the removal of the scratch directories at exit, once for the whole program
+// --------------------------------------------------------------------------------------------------------
+void registerScratchCleanup (void)
+{
+    atexit(removeAllScratchDirectories);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Directory in which the scratch directories and files are created: /dev/shm if it is available, otherwise
+// $TMPDIR or /tmp (the working directory on Windows)
+// --------------------------------------------------------------------------------------------------------
+const char *scratchBase ()
+{
+    #ifdef _WIN32
+        return ".";
+    #else
+    {
+        const char *base = "/dev/shm";
+        struct stat info;
+
+        if (stat(base, &info) != 0 || !S_ISDIR(info.st_mode) || access(base, W_OK) != 0)
+            base = (getenv("TMPDIR") != NULL) ? getenv("TMPDIR") : "/tmp";
+
+        return base;
+    }
+    #endif
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Create a new empty scratch file, with a unique name that starts with prefix, for a file that a thread
+// writes and reads back (e.g. the input file of a sweep point), so that the runs in the same directory
+// never share it. The caller removes the file.
+// --------------------------------------------------------------------------------------------------------
+void makeScratchFile (char *path, size_t size, const char *prefix)
+{
+    #ifdef _WIN32
+    {
+        static int count_files=0;
+        int l;
+
+        pthread_mutex_lock(&scratchLock);
+        l = ++count_files;
+        pthread_mutex_unlock(&scratchLock);
+        snprintf(path, size, "%s/%s.%ld.%d", scratchBase(), prefix, (long) getpid(), l);
+    }
+    #else
+    {
+        int fd;
+
+        snprintf(path, size, "%s/%s.XXXXXX", scratchBase(), prefix);
+        fd = mkstemp(path);
+        if (fd < 0)
+        {
+            printf("Error: The scratch file %s cannot be created!\n",path);
+            exit(EXIT_FAILURE);
+        }
+        close(fd);
+    }
+    #endif
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Create a new scratch directory, link the cross-section file into it and register it for the removal at exit
+// --------------------------------------------------------------------------------------------------------
+void makeScratchDirectory (char directory[MAXCHAR])
+{
+    // Local variables
+    int l;
+    char path[4*MAXCHAR], crossSections[4*MAXCHAR], (*registry)[MAXCHAR];
+    static int count_scratch=0;
+
+    #ifdef _WIN32
+    {
+        // Unique name in the working directory
+        pthread_mutex_lock(&scratchLock);
+        l = ++count_scratch;
+        pthread_mutex_unlock(&scratchLock);
+        snprintf(directory, MAXCHAR, "chempaig.%ld.%d", (long) getpid(), l);
+        if (mkdir(directory) != 0)
+        {
+            printf("Error: The scratch directory %s cannot be created!\n",directory);
+            exit(EXIT_FAILURE);
+        }
+
+        snprintf(path, sizeof(path), "%s/%s", directory, fileName(BOLSIG_crossSections));
+        if (copyFile(BOLSIG_crossSections, path) != 0)
+        {
+            printf("Error: The file %s cannot be copied to the scratch directory %s!\n",BOLSIG_crossSections,directory);
+            exit(EXIT_FAILURE);
+        }
+    }
+    #else
+    {
+        // Unique directory in memory, if possible
+        (void) count_scratch;
+        (void) crossSections;
+
+        snprintf(directory, MAXCHAR, "%s/chempaig.XXXXXX", scratchBase());
+        if (mkdtemp(directory) == NULL)
+        {
+            printf("Error: The scratch directory %s cannot be created!\n",directory);
+            exit(EXIT_FAILURE);
+        }
+
+        snprintf(path, sizeof(path), "%s/%s", directory, fileName(BOLSIG_crossSections));
+        if (realpath(BOLSIG_crossSections, crossSections) == NULL || symlink(crossSections, path) != 0)
+        {
+            printf("Error: The file %s cannot be linked to the scratch directory %s!\n",BOLSIG_crossSections,directory);
+            rmdir(directory);
+            exit(EXIT_FAILURE);
+        }
+    }
+    #endif
+
+    // Register the directory in a free place of the registry, which grows if it is full
+    pthread_once(&scratchOnce, registerScratchCleanup);
+    pthread_mutex_lock(&scratchLock);
+    for (l=0 ; l<scratchRegistrySize ; l++)
+        if (scratchRegistry[l][0] == '\0')
+            break;
+    if (l == scratchRegistrySize)
+    {
+        registry = realloc(scratchRegistry, (scratchRegistrySize + ScratchRegistryBlock)*sizeof(*scratchRegistry));
+        if (registry == NULL)
+        {
+            pthread_mutex_unlock(&scratchLock);
+            printf("Error: The scratch directory %s cannot be registered for its removal!\n",directory);
+            removeDirectory(directory);
+            exit(EXIT_FAILURE);
+        }
+        memset(registry[scratchRegistrySize], 0, ScratchRegistryBlock*sizeof(*registry));
+        scratchRegistry = registry;
+        scratchRegistrySize += ScratchRegistryBlock;
+    }
+    strcpy(scratchRegistry[l], directory);
+    pthread_mutex_unlock(&scratchLock);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Remove a scratch directory, if it exists, and its registration
+// --------------------------------------------------------------------------------------------------------
+void deleteScratchDirectory (char directory[MAXCHAR])
+{
+    // Local variables
+    int l;
+
+    if (directory[0] == '\0')
+        return;
+
+    pthread_mutex_lock(&scratchLock);
+    for (l=0 ; l<scratchRegistrySize ; l++)
+        if (strcmp(scratchRegistry[l], directory) == 0)
+            scratchRegistry[l][0] = '\0';
+    pthread_mutex_unlock(&scratchLock);
+
+    removeDirectory(directory);
+    directory[0] = '\0';
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Change the path of a BOLSIG+ file to its file name in the scratch directory of this thread
+// --------------------------------------------------------------------------------------------------------
+void moveToScratchDirectory (char file[MAXCHAR])
+{
+    // Local variables
+    char path[MAXCHAR];
+
+    if (snprintf(path, sizeof(path), "%s/%s", scratchDirectory, fileName(file)) >= (int) sizeof(path))
+    {
+        printf("Error: The path of the file %s in the scratch directory %s is too long!\n",fileName(file),scratchDirectory);
+        exit(EXIT_FAILURE);
+    }
+    strcpy(file, path);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Create the scratch directory of the BOLSIG+ runs of this thread and move the BOLSIG+ input and output
+// files into it
+// --------------------------------------------------------------------------------------------------------
+void createScratchDirectory ()
+{
+
+    #ifdef _WIN32
+        snprintf(bolsigExecutable, sizeof(bolsigExecutable), "..\\bolsigminus_win");
+    #else
+        if (realpath("bolsigminus_unix", bolsigExecutable) == NULL)
+        {
+            printf("Error: The BOLSIG+ executable bolsigminus_unix was not found in the working directory!\n");
+            exit(EXIT_FAILURE);
+        }
+    #endif
+
+    makeScratchDirectory(scratchDirectory);
+
+    // The BOLSIG+ files are written in the scratch directory
+    moveToScratchDirectory(BOLSIG_input);
+    moveToScratchDirectory(BOLSIG_output);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Remove the scratch directory of this thread
+// --------------------------------------------------------------------------------------------------------
+void removeScratchDirectory ()
+{
+    deleteScratchDirectory(scratchDirectory);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Start BOLSIG+ in a scratch directory, with the name of the input file as its only argument and with its
+// output discarded, and return its process id without waiting for it, or -1 with errno set if it cannot be
+// started. On Windows BOLSIG+ runs through the shell and has finished when this function returns.
+// --------------------------------------------------------------------------------------------------------
+pid_t startBOLSIG (const char *directory, const char *input)
+{
+    #ifdef _WIN32
+    {
+        char command[8*MAXCHAR];
+        sprintf(command, "cd /d %s && %s %s > NUL 2>&1", directory, bolsigExecutable, fileName(input));
+        system(command);
+        return 0;
+    }
+    #else
+    {
+        char *argv[3];
+        int status;
+        pid_t pid;
+        posix_spawn_file_actions_t actions;
+
+        argv[0] = bolsigExecutable;
+        argv[1] = (char*) fileName(input);
+        argv[2] = NULL;
+
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+        posix_spawn_file_actions_addchdir_np(&actions, directory);
+
+        status = posix_spawn(&pid, bolsigExecutable, &actions, NULL, argv, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (status != 0)
+        {
+            errno = status;
+            return -1;
+        }
+
+        return pid;
+    }
+    #endif
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Wait for a BOLSIG+ process that was started with startBOLSIG, and return true if it exited normally
+// --------------------------------------------------------------------------------------------------------
+bool waitBOLSIG (pid_t pid)
+{
+    #ifdef _WIN32
+        return (pid == 0);
+    #else
+    {
+        int status;
+
+        while (waitpid(pid, &status, 0) < 0)
+            if (errno != EINTR)
+                return false;
+
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    #endif
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Stop a BOLSIG+ process that was started with startBOLSIG and whose results are not needed
+// --------------------------------------------------------------------------------------------------------
+void stopBOLSIG (pid_t pid)
+{
+    #ifndef _WIN32
+        if (pid > 0)
+        {
+            kill(pid, SIGKILL);
+            waitBOLSIG(pid);
+        }
+    #endif
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Run BOLSIG+ in the scratch directory and wait for it. Returns false if BOLSIG+ cannot be started, which is
+// a solver error (see solverError). A failed run is detected when its output file is read.
+// --------------------------------------------------------------------------------------------------------
+bool runBOLSIG ()
+{
+    // Local variables
+    pid_t pid;
+
+    pid = startBOLSIG(scratchDirectory, BOLSIG_input);
+    if (pid < 0)
+    {
+        solverError("Error: BOLSIG+ cannot be started: %s\n", strerror(errno));
+        return false;
+    }
+    waitBOLSIG(pid);
+
+    return true;
+}
@@ -0,0 +1,536 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          simulation.h
+    Type:               header file
+    Short Description:  This file contains the solution of the model for one operating point:
+                        the initialization of the arrays and the initial values, the outer
+                        iterations between the balance equations, the Boltzmann equation and
+                        the energy equation, and the release of the memory.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- initializeSolution            void        Set the initial values of a new solution with the current conditions.
+- initializeSimulation          void        Allocate the arrays and set the initial values, after the input file is read.
+- solveBalanceEquations         void        Update the rate coefficients and solve the balance equations of the species.
+- solveElectronKinetics         void        Solve the Boltzmann equation for the electrons.
+- solveEnergyEquation           void        Solve the energy equation for the gas temperature.
+- runSimulation                 void        Solve the model with the outer iterations until convergence.
+- finalizeSimulation            void        Release the memory of the arrays of the simulation.
+
+---------------------------------------------------------------------------------------------  */
+
+
+// --------------------------------------------------------------------------------------------------------
+// Set the initial values of a new solution, with the current conditions and the initial temperatures Te and
+// Tg. The arrays are allocated once by initializeSimulation, so the model can be solved many times in the
+// same thread (see chempaig.c). If initialRates is false, the rate coefficients of the previous solution
+// are kept, since they are a better initial guess than the fits of the literature.
+// --------------------------------------------------------------------------------------------------------
+void initializeSolution (bool initialRates)
+{
+    // Local variables
+    int l;
+
+    // The outer iterations and their acceleration start again
+    count = 0;
+    count_AA = 0;
+    resetConvergence();
+    cancelSpeculativeBOLSIG();
+    err_e = err_H = err_H2 = err_Hplus = err_H2plus = err_H3plus = err_other = err_Tg = err_Te = 0.0;
+    ne = nH = nH2 = nHplus = nH2plus = nH3plus = 0.0;
+    ne_0 = 0.0;
+    ne_old = nH_old = nH2_old = nHplus_old = nH2plus_old = nH3plus_old = Tg_old = Te_old = 0.0;
+    for (l=0 ; l<=mechanism.NoSpecies ; l++)
+        speciesDensity[l] = speciesDensity_0[l] = speciesDensity_old[l] = 0.0;
+
+
+    // ----------------------------------------------------------------------------------
+    // Initial values
+    // ----------------------------------------------------------------------------------
+    // Rate coefficients
+    if (initialRates)
+        initializeMechanismRates();
+    calculateElectronTemperatureRates();
+    calculateGasTemperatureRates();
+
+    // Initial values for species densities and temperature
+    nH_0 = 1.0e15;
+    nH2_0 = 1.0e15;
+    nHplus_0 = 1.0e15;
+    nH2plus_0 = 1.0e15;
+    nH3plus_0 = 1.0e15;
+    for (l=NoHydrogenUnknowns ; l<mechanism.NoUnknowns ; l++)
+        speciesDensity_0[mechanism.unknown[l]] = 1.0e15;
+    Tg_0 = Tg;
+
+
+    // ----------------------------------------------------------------------------------
+    // Calculate general quantities
+    // ----------------------------------------------------------------------------------
+    // Total number of species
+    n = p/(kB*Tg);
+    rho = p/(RH2*Tg);
+    V = (pi*R*R)*L;
+    Ai = 2*pi*R*L;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Allocate the arrays and set the initial values of the simulation, after the input file is read
+// --------------------------------------------------------------------------------------------------------
+void initializeSimulation ()
+{
+    // Timers of the phases of the solution, which include the reading of the cross sections and the mechanism
+    initializeProfile();
+    profileStart(PROFILE_SETUP);
+
+    // Read the reactions of the BOLSIG+ cross-section file and count them
+    readCrossSections();
+
+    // Allocate arrays according to input parameters
+    allocate(&K, react_num, subreact_num);
+    allocate(&Ethr, react_num, subreact_num);
+    allocate(&map_reactions, count_BOLSIG, 2);
+    mapRateCoeffs(map_reactions);
+    bolsig.rate = (double*) calloc(count_BOLSIG, sizeof(double));
+    bolsig.threshold = (double*) calloc(count_BOLSIG, sizeof(double));
+
+    // Read the reaction mechanism, which refers to the reactions of the cross-section file
+    readMechanism();
+    speciesDensity = (double*) calloc(mechanism.NoSpecies+1, sizeof(double));
+    speciesDensity_0 = (double*) calloc(mechanism.NoSpecies+1, sizeof(double));
+    speciesDensity_old = (double*) calloc(mechanism.NoSpecies+1, sizeof(double));
+    neutralFraction = (double*) calloc(NoNeutralSpecies+1, sizeof(double));
+
+    // Tolerances of the unknowns and relaxation factors of the SOR solvers
+    initializeConvergence();
+
+    // The outer iterations are accelerated with the unknowns of the balance equations and Tg
+    if (andersonDepth > 0)
+    {
+        allocate(&andersonU, andersonDepth+1, mechanism.NoUnknowns+1);
+        allocate(&andersonG, andersonDepth+1, mechanism.NoUnknowns+1);
+        andersonU_last = (double*) calloc(mechanism.NoUnknowns+1, sizeof(double));
+    }
+
+    // Use the cache of the BOLSIG+ results, unless it is disabled
+    useCache = (strcmp(BOLSIG_cache,"") != 0 && strcmp(BOLSIG_cache,"none") != 0);
+
+    // Private scratch directory of the BOLSIG+ runs
+    if (strcmp(boltzmannSolver,"TwoTerm") != 0 && strcmp(boltzmannSolver,"Table") != 0)
+    {
+        createScratchDirectory();
+        initializeSpeculativeBOLSIG();
+    }
+
+    // Initial values
+    initializeSolution(true);
+    profileStop(PROFILE_SETUP);
+
+    // Convergence history of the outer iterations
+    initializeHistory();
+
+    // Print screen initial info
+    if (logEnabled(LOG_SUMMARY))
+        printScreen_beginning();
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Update the rate coefficients that are not calculated by the Boltzmann solver and solve the balance
+// equations of the species
+// --------------------------------------------------------------------------------------------------------
+void solveBalanceEquations ()
+{
+    // Local variables
+    int l, N = mechanism.NoUnknowns;
+    double x[N], x_0[N], S[N], Kloss[N], norm=0.0;
+
+    profileStart(PROFILE_BALANCE);
+
+    // Rate coefficients of the mechanism that are not calculated by the Boltzmann solver
+    calculateElectronTemperatureRates();
+    calculateGasTemperatureRates();
+    gatherMechanismRates();
+
+
+    // ----------------------------------------------------------------------------------
+    // Solve the balance equations
+    // ----------------------------------------------------------------------------------
+    // The coupled solver needs the BOLSIG+ rates, so it starts after the first BOLSIG+ run
+    if (strcmp(speciesSolver,"Coupled") == 0 && count > 1)
+        count_SB = solveCoupledNewton(innerTolerance, 200);
+    else if (strcmp(speciesSolver,"Newton") == 0 || strcmp(speciesSolver,"Coupled") == 0)
+        count_SB = solveSpeciesNewton(innerTolerance, 200);
+    else
+    {
+        count_SB = 0;
+        while ( (norm > 1.0 && isfinite(norm) && count_SB < maxInnerIterations) || count_SB<1 )
+        {
+            // Loop counter
+            count_SB++;
+        
+            // Solve the equations with SOR method. Each density is the balance of its sources and its first-order
+            // (wall) loss, which is the diagonal term. The other species include their collisional losses too.
+            // The relaxation factors are adjusted by relaxUnknown (see convergence.h).
+            getUnknowns(x_0, true);
+            speciesSources(x_0, S);
+            speciesLossFrequencies(Kloss);
+            speciesCollisionLosses(x_0, Kloss);
+            norm = 0.0;
+            for (l=0 ; l<N ; l++)
+                x[l] = relaxUnknown(l, x_0[l], (S[l] + Kloss[l]*x_0[l])/Kloss[l], count_SB == 1, &norm);
+
+            // Set the densities, with the e, H2 and diluent densities
+            setUnknowns(x);
+
+            // Calculate errors for this loop
+            err_e = relativeError(ne,ne_0);
+            err_H = relativeError(nH,nH_0);
+            err_H2 = relativeError(nH2,nH2_0);
+            err_Hplus = relativeError(nHplus,nHplus_0);
+            err_H2plus = relativeError(nH2plus,nH2plus_0);
+            err_H3plus = relativeError(nH3plus,nH3plus_0);
+            err_other = otherUnknownsError(speciesDensity_0);
+
+            // Prepare for next iteration
+            ne_0 = ne;
+            nH_0 = nH;
+            nH2_0 = nH2;
+            nHplus_0 = nHplus;
+            nH2plus_0 = nH2plus;
+            nH3plus_0 = nH3plus;
+            copyOtherUnknowns(speciesDensity_0);
+        }
+
+        if (count_SB == maxInnerIterations && norm > 1.0)
+            logMessage(LOG_WARNING, "Warning: The SOR solution of the balance equations did not converge in %d iterations (norm=%.2e)\n", maxInnerIterations, norm);
+    }
+
+    profileCount(PROFILE_BALANCE, count_SB);
+    profileStop(PROFILE_BALANCE);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the Boltzmann equation for the electrons for the current plasma state, and update the electron
+// temperature and the rate coefficients of the electron collisions
+// --------------------------------------------------------------------------------------------------------
+void solveElectronKinetics ()
+{
+    // Local variables
+    bool speculationHit, valid;
+
+    if (strcmp(boltzmannSolver,"TwoTerm") == 0)
+    {
+        // Solve the Boltzmann equation in-process
+        profileStart(PROFILE_TWOTERM);
+        Te = solveBoltzmann(K, Ethr);
+        profileStop(PROFILE_TWOTERM);
+    }
+    else if (strcmp(boltzmannSolver,"Table") == 0)
+    {
+        // Interpolate the pre-tabulated rate coefficients
+        profileStart(PROFILE_TABLE);
+        Te = solveRateTable(K, Ethr);
+        profileStop(PROFILE_TABLE);
+    }
+    else
+    {
+        // Write the BOLSIG+ input file
+        profileStart(PROFILE_BOLSIG_INPUT);
+        writeBOLSIGinput();
+        profileStop(PROFILE_BOLSIG_INPUT);
+
+        // Take the results from a speculative run or from the cache, otherwise run the BOLSIG+ code. The
+        // speculative runs of the next iterations are started before, so they run at the same time.
+        speculationHit = false;
+        if (BOLSIG_speculation > 0.0)
+        {
+            profileStart(PROFILE_BOLSIG_SPECULATION);
+            speculationHit = acceptSpeculativeBOLSIG(&bolsig);
+            launchSpeculativeBOLSIG();
+            profileStop(PROFILE_BOLSIG_SPECULATION);
+        }
+
+        cacheMiss = false;
+        valid = true;
+        if (!speculationHit)
+        {
+            if (useCache)
+            {
+                profileStart(PROFILE_BOLSIG_CACHE);
+                cacheMiss = !bolsigCacheLoad();
+                profileStop(PROFILE_BOLSIG_CACHE);
+            }
+            if (!useCache || cacheMiss)
+            {
+                profileStart(PROFILE_BOLSIG_RUN);
+                remove(BOLSIG_output);
+                valid = runBOLSIG();
+                profileStop(PROFILE_BOLSIG_RUN);
+            }
+
+            // Read information from the BOLSIG+ output file
+            profileStart(PROFILE_BOLSIG_OUTPUT);
+            valid = valid && readBOLSIGoutput(BOLSIG_output, &bolsig, true);
+            profileStop(PROFILE_BOLSIG_OUTPUT);
+        }
+
+        // After a failed run, the rate coefficients and Te of the previous run are kept (see solverError)
+        if (!valid)
+            return;
+        Te = storeBOLSIGresults(&bolsig, K, Ethr);
+
+        // Store the new results in the cache, once they are known to be complete
+        if (cacheMiss)
+        {
+            profileStart(PROFILE_BOLSIG_CACHE);
+            bolsigCacheStore();
+            profileStop(PROFILE_BOLSIG_CACHE);
+        }
+
+        // Validate the two-term Boltzmann solver against BOLSIG+
+        if (strcmp(boltzmannSolver,"Compare") == 0)
+            compareBoltzmann(Te);
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Calculate the power terms and solve the energy equation for the gas temperature
+// --------------------------------------------------------------------------------------------------------
+void solveEnergyEquation ()
+{
+    // Local variables
+    double norm=0.0;
+
+    profileStart(PROFILE_ENERGY);
+
+    // Calculate powers for energy equation
+    calculatePowers();
+
+    // Solve the energy equation
+    if (strcmp(speciesSolver,"Coupled") == 0 && count > 1)
+        count_Tg = 0;
+    else if (strcmp(energySolver,"Newton") == 0)
+        count_Tg = solveGasTemperature(PinletHeat + Pela + Piw + Pew + Pvib + Prot - Pchem, 1.0e-12, 100);
+    else
+    {
+        count_Tg = 0;
+        while ( (norm > 1.0 && isfinite(norm) && count_Tg < maxInnerIterations) || count_Tg<1 )
+        {
+            count_Tg++;
+            norm = 0.0;
+            Tg = relaxUnknown(mechanism.NoUnknowns, Tg_0, (PinletHeat + Pela + Piw + Pew + Pvib + Prot - Pchem + h*Ai*Tatm + epsilon*sigma*Ai*(pow(Tatm,4)-pow(Tg_0,4)))/(rho*Q*Cp+h*Ai), count_Tg == 1, &norm);
+            // Tg = (1.0-r3)*Tg_0 + r3*(PinletHeat + Pela + Piw + Pew + Pvib + Prot - Pchem + h*Ai*(Tatm-Tg_0) + epsilon*sigma*Ai*(pow(Tatm,4)-pow(Tg_0,4)))/(rho*Q*Cp);
+            err_Tg = relativeError(Tg,Tg_0);
+            Tg_0 = Tg;
+        }
+
+        if (count_Tg == maxInnerIterations && norm > 1.0)
+            logMessage(LOG_WARNING, "Warning: The SOR solution of the energy equation did not converge in %d iterations (norm=%.2e)\n", maxInnerIterations, norm);
+    }
+
+    profileCount(PROFILE_ENERGY, count_Tg);
+    profileStop(PROFILE_ENERGY);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the model with the outer iterations, until the densities and the gas temperature converge, or until
+// checkConvergence stops them (see convergence.h)
+// --------------------------------------------------------------------------------------------------------
+void runSimulation ()
+{
+    // Local variables
+    bool running=true;
+
+    profileStart(PROFILE_SOLUTION);
+
+    // Main while loop
+    while (running)
+    {
+        // Iteration counter
+        count++;
+        profileStart(PROFILE_ITERATION);
+
+        // Print to screen the iteration counter
+        logMessage(LOG_ITERATION, "Iteration %d\n", count);
+
+        // Solve the balance equations
+        solveBalanceEquations();
+
+        // Print species balance results
+        logMessage(LOG_ITERATION, "Densities: n=%.4e ne=%.4e nH=%.4e nH2=%.4e nH+=%.4e nH2+=%.4e nH3+=%.4e SB_count=%d\n",n,ne,nH,nH2,nHplus,nH2plus,nH3plus,count_SB);
+
+
+        // ----------------------------------------------------------------------------------
+        // Accelerate the outer iterations
+        // ----------------------------------------------------------------------------------
+        // The first iteration starts from the initial guesses, so it is not used in the mixing
+        if (andersonDepth > 0 && count > 1)
+        {
+            double x_AA[mechanism.NoUnknowns+1];
+            profileStart(PROFILE_ANDERSON);
+            getUnknowns(x_AA, false);
+            x_AA[mechanism.NoUnknowns] = Tg;
+            andersonMixing(mechanism.NoUnknowns+1, x_AA);
+
+            setUnknowns(x_AA);
+            Tg = Tg_0 = x_AA[mechanism.NoUnknowns];
+            ne_0 = ne;
+            nH_0 = nH;
+            nH2_0 = nH2;
+            nHplus_0 = nHplus;
+            nH2plus_0 = nH2plus;
+            nH3plus_0 = nH3plus;
+            copyOtherUnknowns(speciesDensity_0);
+            calculateGasTemperatureRates();
+            profileStop(PROFILE_ANDERSON);
+        }
+
+
+        // Solve the Boltzmann equation for the electrons (BOLSIG+ or in-process)
+        solveElectronKinetics();
+
+        // Solve the energy equation
+        solveEnergyEquation();
+
+        // Print temperature results
+        logMessage(LOG_ITERATION, "Temperatures: Tg=%.2f Te=%.2f Tg_count=%d\n", Tg, Te, count_Tg);
+
+        // Calculate relative errors
+        err_e = relativeError(ne,ne_old);
+        err_H = relativeError(nH,nH_old);
+        err_H2 = relativeError(nH2,nH2_old);
+        err_Hplus = relativeError(nHplus,nHplus_old);
+        err_H2plus = relativeError(nH2plus,nH2plus_old);
+        err_H3plus = relativeError(nH3plus,nH3plus_old);
+        err_other = otherUnknownsError(speciesDensity_old);
+        err_Tg = relativeError(Tg,Tg_old);
+        err_Te = relativeError(Te,Te_old);
+        running = checkConvergence(convergenceNorm());
+
+        logMessage(LOG_ITERATION, "Errors: H2=%.2e H=%.2e H+=%.2e H2+=%.2e H3+=%.2e Norm=%.2e\n\n",err_H2, err_H, err_Hplus, err_H2plus, err_H3plus, outerNorm);
+
+        // Convergence history of the iteration, before the densities are stored
+        recordHistory();
+
+        // Store solution for the next iteration
+        ne_0 = ne;
+        nH_0 = nH;
+        nH2_0 = nH2;
+        nHplus_0 = nHplus;
+        nH2plus_0 = nH2plus;
+        nH3plus_0 = nH3plus;
+        Tg_0 = Tg;
+        ne_old = ne;
+        nH_old = nH;
+        nH2_old = nH2;
+        nHplus_old = nHplus;
+        nH2plus_old = nH2plus;
+        nH3plus_old = nH3plus;
+        copyOtherUnknowns(speciesDensity_0);
+        copyOtherUnknowns(speciesDensity_old);
+        Tg_old = Tg;
+        Te_old = Te;
+        profileStop(PROFILE_ITERATION);
+    }
+    profileStop(PROFILE_SOLUTION);
+
+    if (logEnabled(LOG_SUMMARY))
+    {
+        // Print screen of rate constants or threshold energies
+        printScreen_K_Ethr();
+
+        // Print final results, and the densities of the species beyond the hydrogen model
+        printScreen_finalResults();
+        printOtherSpecies();
+
+        // Print the statistics of the BOLSIG+ cache
+        if (useCache && count_cacheHits+count_cacheMisses > 0)
+            printf("BOLSIG+ cache: %d hits, %d misses\n", count_cacheHits, count_cacheMisses);
+
+        // Print the statistics of the speculative BOLSIG+ runs
+        if (BOLSIG_speculation > 0.0 && count_speculationRuns > 0)
+            printf("Speculative BOLSIG+ runs: %d used of %d started\n", count_speculationHits, count_speculationRuns);
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Release the memory of the arrays of the simulation
+// --------------------------------------------------------------------------------------------------------
+void finalizeSimulation ()
+{
+    // Local variables
+    int l;
+
+    // Write the convergence history and the timers of the phases of the solution
+    finalizeHistory();
+    finalizeProfile();
+    finalizeConvergence();
+
+    for (l=0 ; l<react_num ; l++)
+    {
+        free(K[l]);
+        free(Ethr[l]);
+        free(collisionIndex[l]);
+    }
+    free(K);
+    free(Ethr);
+    free(collisionIndex);
+
+    for (l=0 ; l<count_BOLSIG ; l++)
+        free(map_reactions[l]);
+    free(map_reactions);
+    free(bolsig.rate);
+    free(bolsig.threshold);
+
+    for (l=0 ; l<NoCollisions ; l++)
+    {
+        free(collisions[l].energy);
+        free(collisions[l].crossSec);
+    }
+    free(collisions);
+    freeMechanism();
+    free(speciesDensity);
+    free(speciesDensity_0);
+    free(speciesDensity_old);
+    free(neutralFraction);
+    free(neutralSpecies);
+    neutralSpecies = NULL;
+
+    if (andersonDepth > 0)
+    {
+        for (l=0 ; l<=andersonDepth ; l++)
+        {
+            free(andersonU[l]);
+            free(andersonG[l]);
+        }
+        free(andersonU);
+        free(andersonG);
+        free(andersonU_last);
+    }
+
+    // Solutions of the in-process Boltzmann solver and rate coefficient tables
+    free(EEDF_previous);
+    EEDF_previous = NULL;
+    freeRateTable();
+
+    // BOLSIG+ scratch directories
+    finalizeSpeculativeBOLSIG();
+    removeScratchDirectory();
+}
@@ -0,0 +1,636 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          solvers.h
+    Type:               header file
+    Short Description:  This file contains the numerical solvers of the balance equations.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- solveLinearSystem             int         Solve a dense linear system with Gaussian elimination and partial pivoting.
+- solveHessenbergSystem         int         Solve a linear system with an upper Hessenberg matrix in O(N^2) operations.
+- speciesResidual               void        Calculate the residuals of the species balance equations.
+- speciesJacobian               void        Calculate the analytic Jacobian of the species balance residuals.
+- coupledResidual               void        Calculate the residuals of the coupled species balance and energy equations.
+- coupledJacobian               void        Calculate the Jacobian of the coupled species balance and energy equations.
+- speciesDirection              int         Calculate the Newton direction of the species balance with the sparse LU factors.
+- coupledDirection              int         Calculate the Newton direction of the coupled equations with the dense solver.
+- newtonSolve                   int         Solve a nonlinear system with a damped, pseudo-transient Newton-Raphson method.
+- storeSpeciesSolution          void        Store the species densities of the Newton solution in the global variables.
+- solveSpeciesNewton            int         Solve the species balance equations with the Newton method.
+- solveCoupledNewton            int         Solve the species balance and energy equations together with the Newton method.
+- solveGasTemperature           int         Solve the energy equation for the gas temperature with safeguarded Newton.
+- andersonMixing                void        Accelerate the outer BOLSIG+ iterations with Anderson mixing.
+
+---------------------------------------------------------------------------------------------  */
+
+// Largest change of the log of an unknown in a Newton step with the log variables (a factor of 100)
+#define MAXLOGSTEP 4.6
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the dense linear system A*x=b. The solution is returned in b and the matrix A is destroyed.
+// Returns 0 on success and 1 if the matrix is singular.
+// --------------------------------------------------------------------------------------------------------
+int solveLinearSystem (int N, double A[N][N], double b[N])
+{
+    // Local variables
+    int i, j, k, pivot;
+    double factor, temp;
+
+    // Forward elimination with partial pivoting
+    for (k=0 ; k<N ; k++)
+    {
+        pivot = k;
+        for (i=k+1 ; i<N ; i++)
+            if (fabs(A[i][k]) > fabs(A[pivot][k]))
+                pivot = i;
+
+        if (A[pivot][k] == 0.0)
+            return 1;
+
+        if (pivot != k)
+        {
+            for (j=0 ; j<N ; j++)
+            {
+                temp = A[k][j];
+                A[k][j] = A[pivot][j];
+                A[pivot][j] = temp;
+            }
+            temp = b[k];
+            b[k] = b[pivot];
+            b[pivot] = temp;
+        }
+
+        for (i=k+1 ; i<N ; i++)
+        {
+            factor = A[i][k]/A[k][k];
+            for (j=k ; j<N ; j++)
+                A[i][j] -= factor*A[k][j];
+            b[i] -= factor*b[k];
+        }
+    }
+
+    // Back substitution
+    for (i=N-1 ; i>=0 ; i--)
+    {
+        for (j=i+1 ; j<N ; j++)
+            b[i] -= A[i][j]*b[j];
+        b[i] /= A[i][i];
+    }
+
+    return 0;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the linear system A*x=b for an upper Hessenberg matrix (zero below the first subdiagonal), such as
+// the matrix of the two-term Boltzmann equation. Only the subdiagonal is eliminated, so the cost is O(N^2).
+// The solution is returned in b and the matrix A is destroyed. Returns 0 on success and 1 if singular.
+// --------------------------------------------------------------------------------------------------------
+int solveHessenbergSystem (int N, double A[N][N], double b[N])
+{
+    // Local variables
+    int i, j, k;
+    double factor, temp;
+
+    // Forward elimination, with partial pivoting between the rows k and k+1
+    for (k=0 ; k<N-1 ; k++)
+    {
+        if (fabs(A[k+1][k]) > fabs(A[k][k]))
+        {
+            for (j=k ; j<N ; j++)
+            {
+                temp = A[k][j];
+                A[k][j] = A[k+1][j];
+                A[k+1][j] = temp;
+            }
+            temp = b[k];
+            b[k] = b[k+1];
+            b[k+1] = temp;
+        }
+
+        if (A[k][k] == 0.0)
+            return 1;
+
+        factor = A[k+1][k]/A[k][k];
+        for (j=k ; j<N ; j++)
+            A[k+1][j] -= factor*A[k][j];
+        b[k+1] -= factor*b[k];
+    }
+
+    if (A[N-1][N-1] == 0.0)
+        return 1;
+
+    // Back substitution
+    for (i=N-1 ; i>=0 ; i--)
+    {
+        for (j=i+1 ; j<N ; j++)
+            b[i] -= A[i][j]*b[j];
+        b[i] /= A[i][i];
+    }
+
+    return 0;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Residuals of the species balance equations. The unknowns are x = {nH, nH+, nH2+, nH3+, ...} of the
+// mechanism, while the electron, H2 and diluent densities follow from quasi-neutrality and the total density
+// n. The residuals are the source terms of the reaction mechanism (see mechanism.h), which include the wall
+// losses.
+// --------------------------------------------------------------------------------------------------------
+void speciesResidual (const double *x, double *f)
+{
+    speciesSources(x, f);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Analytic Jacobian of the species residuals, stored row by row in J. The partial derivatives are taken
+// with respect to the densities of all the species of the mechanism, and then the chain rule is applied
+// for the closure densities.
+// --------------------------------------------------------------------------------------------------------
+void speciesJacobian (const double *x, double *J_flat)
+{
+    speciesSourceJacobian(x, J_flat);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Residuals of the coupled species and energy equations. The unknowns are the species unknowns followed by
+// the gas temperature, x = {nH, nH+, nH2+, nH3+, ..., Tg}. The rate coefficients and powers that depend on
+// the gas temperature or the densities are recalculated, while the BOLSIG+ rates and Te are held fixed. The
+// global densities and Tg are overwritten with x.
+// --------------------------------------------------------------------------------------------------------
+void coupledResidual (const double *x, double *f)
+{
+    // Local variables
+    int N = mechanism.NoUnknowns;
+
+    // Set the state of the evaluation
+    setUnknowns(x);
+    Tg = x[N];
+    calculateGasTemperatureRates();
+    calculatePowers();
+
+    // Species balance equations
+    speciesResidual(x, f);
+
+    // Energy equation
+    f[N] = PinletHeat + Pela + Piw + Pew + Pvib + Prot - Pchem + h*Ai*(Tatm-Tg) + epsilon*sigma*Ai*(pow(Tatm,4)-pow(Tg,4)) - rho*Q*Cp*Tg;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Jacobian of the coupled species and energy equations, stored row by row in J. The species block is the
+// analytic species Jacobian, and the gas temperature column follows from the analytic derivatives of
+// the rate coefficients that depend on Tg. The energy equation row is calculated with forward differences, since
+// the wall and ion powers depend on the densities through the mean ion mass and the Bohm velocity.
+// --------------------------------------------------------------------------------------------------------
+void coupledJacobian (const double *x, double *J_flat)
+{
+    // Local variables
+    int i, j, N = mechanism.NoUnknowns;
+    double (*J)[N+1] = (double (*)[N+1]) J_flat;
+    double *J_species = (double*) malloc(N*N*sizeof(double));
+    double x_pert[N+1], f[N+1], f_pert[N+1], dx, dfdTg[N];
+
+    // Energy equation row
+    coupledResidual(x, f);
+    for (j=0 ; j<=N ; j++)
+    {
+        for (i=0 ; i<=N ; i++)
+            x_pert[i] = x[i];
+        dx = 1.0e-7*fabs(x[j]);
+        x_pert[j] += dx;
+        coupledResidual(x_pert, f_pert);
+        J[N][j] = (f_pert[N] - f[N])/dx;
+    }
+
+    // Species block, with the rate coefficients at the unperturbed gas temperature
+    coupledResidual(x, f);
+    speciesJacobian(x, J_species);
+    for (i=0 ; i<N ; i++)
+        for (j=0 ; j<N ; j++)
+            J[i][j] = J_species[N*i+j];
+    free(J_species);
+
+    // Gas temperature column
+    speciesSourceTemperature(x, dfdTg);
+    for (i=0 ; i<N ; i++)
+        J[i][N] = dfdTg[i];
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Newton direction (J - diag(shift))*dx = -f of the species balance. The sparse Jacobian is factorized with
+// the LU pattern that was found once with the mechanism (see mechanism.h). On a zero pivot, the dense solver
+// with partial pivoting is used. Returns 0 on success and 1 if the matrix is singular.
+// --------------------------------------------------------------------------------------------------------
+int speciesDirection (const double *x, const double *f, const double *shift, double *dx)
+{
+    // Local variables
+    int i, singular, N = mechanism.NoUnknowns;
+    double (*J)[N];
+
+    for (i=0 ; i<N ; i++)
+        dx[i] = -f[i];
+
+    speciesJacobianSparse(x, &mechanism.jacobian);
+    if (sparseLUFactor(&mechanism.jacobianLU, &mechanism.jacobian, shift) == 0)
+    {
+        sparseLUSolve(&mechanism.jacobianLU, dx);
+        return 0;
+    }
+
+    J = malloc(N*sizeof(*J));
+    sparseToDense(&mechanism.jacobian, &J[0][0]);
+    for (i=0 ; i<N ; i++)
+        J[i][i] -= shift[i];
+    singular = solveLinearSystem(N, J, dx);
+    free(J);
+
+    return singular;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Newton direction (J - diag(shift))*dx = -f of the coupled species and energy equations, with the dense
+// Jacobian. Returns 0 on success and 1 if the matrix is singular.
+// --------------------------------------------------------------------------------------------------------
+int coupledDirection (const double *x, const double *f, const double *shift, double *dx)
+{
+    // Local variables
+    int i, singular, N = mechanism.NoUnknowns+1;
+    double (*J)[N] = malloc(N*sizeof(*J));
+
+    coupledJacobian(x, &J[0][0]);
+    for (i=0 ; i<N ; i++)
+    {
+        J[i][i] -= shift[i];
+        dx[i] = -f[i];
+    }
+    singular = solveLinearSystem(N, J, dx);
+    free(J);
+
+    return singular;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the nonlinear system f(x)=0 with a damped Newton-Raphson method. Far from the solution of the
+// species balance the trivial state ne=0 also satisfies the equations, so the Newton matrix is augmented
+// with a pseudo-transient term Kloss/tau, where Kloss is the loss coefficient of each equation (the SOR
+// update is this step with tau=r1 and without the Jacobian). The pseudo time step tau starts from r1 and
+// grows as the relative change of the unknowns decreases, so the method turns into the pure Newton method
+// close to the solution. A backtracking line search on the residuals scaled with Kloss*x damps the step,
+// which is also limited so that the unknowns remain positive. The Newton direction is calculated by the
+// function direction, which factorizes the Jacobian in the form that suits the system. The solution is
+// returned in x together with the number of iterations. A singular Jacobian is a solver error (see
+// solverError), and the last iterate is returned.
+//
+// With densityVariables Log the unknowns are y = log(x) and the residuals are scaled as f/x, i.e. the
+// balance of the production and loss frequencies of every unknown, so that the trace ions converge like
+// the neutrals. The Newton matrix of the scaled residuals in y, multiplied by x row by row and column by
+// column, is the Jacobian shifted by f/x, so the same direction functions are used with dx = x*dy. The
+// update x*exp(lambda*dy) keeps the unknowns positive for any step, which is only limited to a change of
+// the unknowns by a factor of exp(MAXLOGSTEP).
+// --------------------------------------------------------------------------------------------------------
+int newtonSolve (int N, double x[N], void (*residual)(const double*, double*), int (*direction)(const double*, const double*, const double*, double*), const double Kloss[N], double tol, int maxIter)
+{
+    // Local variables
+    int i, iter, count_LS;
+    double x_new[N], f[N], f_new[N], dx[N], shift[N], w[N];
+    double lambda, lambda_max, merit, merit_new, err, res, tau;
+    bool logVariables = (strcmp(densityVariables,"Log") == 0);
+
+    residual(x, f);
+    tau = r1;
+
+    err = 1.0;
+    res = 1.0;
+    for (iter=1 ; iter<=maxIter ; iter++)
+    {
+        // Newton direction (J - Kloss/tau)*dx = -f, and (J - Kloss/tau - f/x)*dx = -f in the log variables
+        for (i=0 ; i<N ; i++)
+            shift[i] = Kloss[i]/tau + (logVariables ? f[i]/x[i] : 0.0);
+        if (direction(x, f, shift, dx) != 0)
+        {
+            solverError("Error: Singular Jacobian in the Newton solution of the balance equations!\n");
+            return iter;
+        }
+
+        // Scaling weights and merit function of the current iterate
+        merit = 0.0;
+        for (i=0 ; i<N ; i++)
+        {
+            w[i] = 1.0/(Kloss[i]*fabs(x[i]));
+            merit += (w[i]*f[i])*(w[i]*f[i]);
+        }
+
+        // Limit the step so that no unknown drops below a tenth of its current value, or in the log variables
+        // so that no unknown changes by more than a factor of exp(MAXLOGSTEP)
+        lambda_max = 1.0;
+        for (i=0 ; i<N ; i++)
+        {
+            if (logVariables)
+            {
+                dx[i] /= x[i];
+                if (lambda_max*fabs(dx[i]) > MAXLOGSTEP)
+                    lambda_max = MAXLOGSTEP/fabs(dx[i]);
+            }
+            else if (x[i] + lambda_max*dx[i] < 0.1*x[i])
+                lambda_max = -0.9*x[i]/dx[i];
+        }
+
+        // Backtracking line search on the scaled residuals. During the pseudo-transient phase the residuals
+        // may grow on the way to the solution, so if no decrease is found the limited step is kept.
+        lambda = lambda_max;
+        for (count_LS=0 ; count_LS<=10 ; count_LS++)
+        {
+            if (count_LS == 10)
+                lambda = lambda_max;
+
+            for (i=0 ; i<N ; i++)
+                x_new[i] = logVariables ? x[i]*exp(lambda*dx[i]) : x[i] + lambda*dx[i];
+            residual(x_new, f_new);
+
+            merit_new = 0.0;
+            for (i=0 ; i<N ; i++)
+                merit_new += (w[i]*f_new[i])*(w[i]*f_new[i]);
+
+            if (merit_new <= (1.0-1.0e-4*lambda)*merit || count_LS == 10)
+                break;
+            lambda *= 0.5;
+        }
+
+        // Accept the step, calculate the relative change and the scaled residual of the new iterate
+        err = 0.0;
+        res = 0.0;
+        for (i=0 ; i<N ; i++)
+        {
+            err = fmax(err, relativeError(x_new[i], x[i]));
+            x[i] = x_new[i];
+            f[i] = f_new[i];
+            res = fmax(res, fabs(f[i])/(Kloss[i]*fabs(x[i])));
+        }
+
+        if (err < tol && res < tol)
+            break;
+
+        // Adapt the pseudo time step, aiming at a relative change of about 30% per iteration
+        tau *= fmin(10.0, fmax(0.1, 0.3/fmax(err, 1.0e-30)));
+    }
+
+    if (iter > maxIter)
+        logMessage(LOG_WARNING, "Warning: The Newton solution of the balance equations did not converge in %d iterations (error=%.2e)\n", maxIter, fmax(err, res));
+
+    return (iter > maxIter) ? maxIter : iter;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Store the species densities of the unknowns x in the global densities and update the errors and the values
+// of the previous iteration
+// --------------------------------------------------------------------------------------------------------
+void storeSpeciesSolution (const double *x)
+{
+    setUnknowns(x);
+
+    err_e = relativeError(ne,ne_0);
+    err_H = relativeError(nH,nH_0);
+    err_H2 = relativeError(nH2,nH2_0);
+    err_Hplus = relativeError(nHplus,nHplus_0);
+    err_H2plus = relativeError(nH2plus,nH2plus_0);
+    err_H3plus = relativeError(nH3plus,nH3plus_0);
+    err_other = otherUnknownsError(speciesDensity_0);
+
+    ne_0 = ne;
+    nH_0 = nH;
+    nH2_0 = nH2;
+    nHplus_0 = nHplus;
+    nH2plus_0 = nH2plus;
+    nH3plus_0 = nH3plus;
+    copyOtherUnknowns(speciesDensity_0);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the species balance equations with the Newton method, starting from the *_0 densities. The loss
+// coefficients of the equations are the first-order (wall) losses of the mechanism, and for the unknowns that
+// are not hydrogen species the collisional losses at the initial state too, as in the SOR method (see
+// speciesCollisionLosses). The ions of a diluent are lost mainly by charge exchange, so with their wall
+// losses alone the pseudo-transient term would not damp their equations and the iterations would fall to the
+// trivial state ne=0.
+// --------------------------------------------------------------------------------------------------------
+int solveSpeciesNewton (double tol, int maxIter)
+{
+    // Local variables
+    int iter, N = mechanism.NoUnknowns;
+    double x[N], Kloss[N];
+
+    getUnknowns(x, true);
+    speciesLossFrequencies(Kloss);
+    speciesCollisionLosses(x, Kloss);
+
+    iter = newtonSolve(N, x, speciesResidual, speciesDirection, Kloss, tol, maxIter);
+    storeSpeciesSolution(x);
+
+    return iter;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the species balance and energy equations together with the Newton method, with the BOLSIG+ rate
+// coefficients and Te held fixed. The loss coefficient of the energy equation is the convective and
+// conductive heat loss rho*Q*Cp+h*Ai.
+// --------------------------------------------------------------------------------------------------------
+int solveCoupledNewton (double tol, int maxIter)
+{
+    // Local variables
+    int iter, N = mechanism.NoUnknowns;
+    double x[N+1], f[N+1], Kloss[N+1];
+
+    // Loss coefficients at the initial state
+    getUnknowns(x, true);
+    x[N] = Tg_0;
+    coupledResidual(x, f);
+    speciesLossFrequencies(Kloss);
+    speciesCollisionLosses(x, Kloss);
+    Kloss[N] = rho*Q*Cp + h*Ai;
+
+    iter = newtonSolve(N+1, x, coupledResidual, coupledDirection, Kloss, tol, maxIter);
+
+    // Evaluate the rates and powers at the solution and store it
+    coupledResidual(x, f);
+    storeSpeciesSolution(x);
+    err_Tg = relativeError(Tg, Tg_0);
+    Tg_0 = Tg;
+
+    return iter;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the energy equation for the gas temperature. With the powers held fixed, the balance
+//     epsilon*sigma*Ai*Tg^4 + (rho*Q*Cp + h*Ai)*Tg = Psource + h*Ai*Tatm + epsilon*sigma*Ai*Tatm^4
+// is a quartic with a single positive root, since its left side increases monotonically with Tg. The root
+// is found with Newton-Raphson steps that fall back to bisection whenever they leave the bracket. Psource
+// is the sum of the heating and cooling powers, the solution is stored in Tg and the number of iterations
+// is returned. Without a positive root Tg is kept, as a solver error (see solverError).
+// --------------------------------------------------------------------------------------------------------
+int solveGasTemperature (double Psource, double tol, int maxIter)
+{
+    // Local variables
+    int iter;
+    double a4, a1, a0, T, T_new, g, dg, T_low, T_high;
+
+    // Coefficients of the quartic a4*T^4 + a1*T - a0 = 0
+    a4 = epsilon*sigma*Ai;
+    a1 = rho*Q*Cp + h*Ai;
+    a0 = Psource + h*Ai*Tatm + epsilon*sigma*Ai*pow(Tatm,4);
+
+    if (a0 <= 0.0)
+    {
+        solverError("Error: The energy equation has no positive solution for the gas temperature!\n");
+        return 0;
+    }
+
+    // Bracket of the root. Each term of the left side alone can not exceed a0.
+    T_low = 0.0;
+    T_high = (a4 > 0.0) ? fmin(a0/a1, pow(a0/a4, 0.25)) : a0/a1;
+
+    // Start from the previous gas temperature if it lies inside the bracket
+    T = (Tg_0 > T_low && Tg_0 < T_high) ? Tg_0 : 0.5*(T_low + T_high);
+
+    for (iter=1 ; iter<=maxIter ; iter++)
+    {
+        g = a4*T*T*T*T + a1*T - a0;
+        dg = 4.0*a4*T*T*T + a1;
+
+        // Update the bracket
+        if (g > 0.0)
+            T_high = T;
+        else
+            T_low = T;
+
+        // Newton step, or bisection if the step leaves the bracket
+        T_new = T - g/dg;
+        if (relativeError(T_new, T) < tol)
+        {
+            T = T_new;
+            break;
+        }
+        if (T_new < T_low || T_new > T_high)
+            T_new = 0.5*(T_low + T_high);
+        T = T_new;
+    }
+
+    if (iter > maxIter)
+        logMessage(LOG_WARNING, "Warning: The gas temperature did not converge in %d iterations\n", maxIter);
+
+    // Store the solution
+    err_Tg = relativeError(T, Tg_0);
+    Tg = T;
+    Tg_0 = Tg;
+
+    return (iter > maxIter) ? maxIter : iter;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Anderson mixing of the outer iterations. One outer iteration maps the state x = {nH, nH+, nH2+, nH3+, Tg}
+// that is passed to BOLSIG+ to the state of the next iteration, x_new = G(x). Instead of the plain Picard
+// update x_new, the new state is the combination of the last andersonDepth iterates that minimizes the
+// residual G(x)-x in the least squares sense. The mixing is done with the logarithms of the state, so that
+// the densities remain positive. On input x is G(x) of the current iteration and on output the mixed state.
+// The first call only stores the state, so the Picard update is used until two iterates are available.
+// --------------------------------------------------------------------------------------------------------
+void andersonMixing (int N, double *x)
+{
+    // Local variables
+    int i, j, l, m;
+    double u[N], F[N];
+
+    // The state that was passed to the current iteration is the output of the previous call
+    if (count_AA > 0)
+    {
+        // Shift the history and store the newest pair (u, G(u)) in the first row
+        for (l=andersonDepth ; l>0 ; l--)
+            for (i=0 ; i<N ; i++)
+            {
+                andersonU[l][i] = andersonU[l-1][i];
+                andersonG[l][i] = andersonG[l-1][i];
+            }
+        for (i=0 ; i<N ; i++)
+        {
+            andersonU[0][i] = andersonU_last[i];
+            andersonG[0][i] = log(x[i]);
+        }
+    }
+    count_AA++;
+
+    // Number of differences available
+    m = (count_AA-2 < andersonDepth) ? count_AA-2 : andersonDepth;
+
+    for (i=0 ; i<N ; i++)
+        u[i] = log(x[i]);
+
+    if (m > 0)
+    {
+        double A[m][m], b[m], dF[m][N], trace;
+
+        // Differences of the residuals F = G(u)-u between consecutive iterates
+        for (i=0 ; i<N ; i++)
+            F[i] = andersonG[0][i] - andersonU[0][i];
+        for (l=0 ; l<m ; l++)
+            for (i=0 ; i<N ; i++)
+                dF[l][i] = F[i] - (andersonG[l+1][i] - andersonU[l+1][i]);
+
+        // Normal equations of the least squares problem min|F - dF*gamma|, with a small regularization
+        trace = 0.0;
+        for (l=0 ; l<m ; l++)
+        {
+            b[l] = 0.0;
+            for (i=0 ; i<N ; i++)
+                b[l] += dF[l][i]*F[i];
+            for (j=0 ; j<m ; j++)
+            {
+                A[l][j] = 0.0;
+                for (i=0 ; i<N ; i++)
+                    A[l][j] += dF[l][i]*dF[j][i];
+            }
+            trace += A[l][l];
+        }
+        for (l=0 ; l<m ; l++)
+            A[l][l] += 1.0e-10*trace;
+
+        // Combine the iterates. If the history is degenerate, restart it with the Picard update.
+        if (trace > 0.0 && solveLinearSystem(m, A, b) == 0)
+        {
+            for (i=0 ; i<N ; i++)
+                for (l=0 ; l<m ; l++)
+                    u[i] -= b[l]*(andersonG[0][i] - andersonG[l+1][i]);
+        }
+        else
+            count_AA = 1;
+    }
+
+    // Return the mixed state and keep it for the next call
+    for (i=0 ; i<N ; i++)
+    {
+        andersonU_last[i] = u[i];
+        x[i] = exp(u[i]);
+    }
+}
@@ -0,0 +1,270 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          sparse.h
+    Type:               header file
+    Short Description:  This file contains the sparse matrices (CSR) and their LU factorization.
+
+Description
+===========
+The matrices are stored in compressed sparse row (CSR) form: the entries of the row i are at the
+positions rowStart[i] .. rowStart[i+1]-1 of column and value, with increasing columns. The pattern
+of a matrix is built once, and then only the values change.
+
+The LU factorization is split in the same way. sparseLUSymbolic finds once the pattern of L+U with
+the fill-in of the elimination and the position of every entry of the matrix in it. sparseLUFactor
+then factorizes new values of the same pattern, with a shift of the diagonal (the pseudo-transient
+term of the Newton method), and sparseLUSolve solves with the factors. There is no pivoting, so the
+factorization returns 1 on a zero pivot and the caller falls back to the dense solver with partial
+pivoting (see solvers.h).
+
+Function name                   Type        Description
+=============                   ====        ===========
+- allocateSparse                void        Allocate a sparse matrix with the given pattern.
+- freeSparse                    void        Release the memory of a sparse matrix.
+- sparsePosition                int         Find the position of an entry of a sparse matrix.
+- sparseToDense                 void        Expand a sparse matrix to a dense matrix.
+- sparseFromDense               void        Gather the values of the pattern of a sparse matrix from a dense matrix.
+- sparseLUSymbolic              void        Find the pattern of the LU factors of a sparse matrix, once.
+- sparseLUFactor                int         Factorize the values of a sparse matrix with a shifted diagonal.
+- sparseLUSolve                 void        Solve a linear system with the LU factors.
+- freeSparseLU                  void        Release the memory of the LU factors.
+
+---------------------------------------------------------------------------------------------  */
+
+// Sparse matrix in CSR form
+typedef struct
+{
+    int rows, cols, nnz;
+    int *rowStart;                  // First entry of each row, [rows+1]
+    int *column;                    // Column of each entry, [nnz]
+    double *value;                  // Value of each entry, [nnz]
+} sparseMatrix;
+
+// LU factors of a sparse matrix, with the unit diagonal of L implied
+typedef struct
+{
+    sparseMatrix LU;                // Pattern and values of L+U
+    int *diagonal;                  // Position of the diagonal of each row in LU
+    int *map;                       // Position in LU of each entry of the factorized matrix
+    int *work;                      // Position of each column in the current row
+} sparseLU;
+
+
+// --------------------------------------------------------------------------------------------------------
+// Allocate the sparse matrix A with the pattern of the dense boolean matrix pattern[rows][cols]. The values
+// are set to zero.
+// --------------------------------------------------------------------------------------------------------
+void allocateSparse (sparseMatrix *A, int rows, int cols, const bool *pattern)
+{
+    // Local variables
+    int i, j, p=0;
+
+    A->rows = rows;
+    A->cols = cols;
+    A->nnz = 0;
+    for (i=0 ; i<rows*cols ; i++)
+        if (pattern[i])
+            A->nnz++;
+
+    A->rowStart = (int*) malloc((rows+1)*sizeof(int));
+    A->column = (int*) malloc((A->nnz > 0 ? A->nnz : 1)*sizeof(int));
+    A->value = (double*) calloc((A->nnz > 0 ? A->nnz : 1), sizeof(double));
+
+    for (i=0 ; i<rows ; i++)
+    {
+        A->rowStart[i] = p;
+        for (j=0 ; j<cols ; j++)
+            if (pattern[i*cols+j])
+                A->column[p++] = j;
+    }
+    A->rowStart[rows] = p;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Release the memory of a sparse matrix
+// --------------------------------------------------------------------------------------------------------
+void freeSparse (sparseMatrix *A)
+{
+    free(A->rowStart);
+    free(A->column);
+    free(A->value);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Find the position of the entry (i,j) of a sparse matrix. Returns -1 if the entry is not in the pattern.
+// --------------------------------------------------------------------------------------------------------
+int sparsePosition (const sparseMatrix *A, int i, int j)
+{
+    // Local variables
+    int p;
+
+    for (p=A->rowStart[i] ; p<A->rowStart[i+1] ; p++)
+        if (A->column[p] == j)
+            return p;
+
+    return -1;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Expand a sparse matrix to the dense matrix dense[rows][cols], stored row by row
+// --------------------------------------------------------------------------------------------------------
+void sparseToDense (const sparseMatrix *A, double *dense)
+{
+    // Local variables
+    int i, p;
+
+    for (i=0 ; i<A->rows*A->cols ; i++)
+        dense[i] = 0.0;
+
+    for (i=0 ; i<A->rows ; i++)
+        for (p=A->rowStart[i] ; p<A->rowStart[i+1] ; p++)
+            dense[i*A->cols+A->column[p]] = A->value[p];
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Gather the values of the pattern of a sparse matrix from the dense matrix dense[rows][cols]
+// --------------------------------------------------------------------------------------------------------
+void sparseFromDense (sparseMatrix *A, const double *dense)
+{
+    // Local variables
+    int i, p;
+
+    for (i=0 ; i<A->rows ; i++)
+        for (p=A->rowStart[i] ; p<A->rowStart[i+1] ; p++)
+            A->value[p] = dense[i*A->cols+A->column[p]];
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Find the pattern of the LU factors of the square sparse matrix A, with the fill-in of the elimination
+// without pivoting and the full diagonal, and the position of every entry of A in the factors
+// --------------------------------------------------------------------------------------------------------
+void sparseLUSymbolic (const sparseMatrix *A, sparseLU *lu)
+{
+    // Local variables
+    int i, j, k, p, N = A->rows;
+    bool *pattern = (bool*) calloc(N*N, sizeof(bool));
+
+    // Pattern of A and the diagonal
+    for (i=0 ; i<N ; i++)
+    {
+        pattern[i*N+i] = true;
+        for (p=A->rowStart[i] ; p<A->rowStart[i+1] ; p++)
+            pattern[i*N+A->column[p]] = true;
+    }
+
+    // Fill-in of the elimination
+    for (k=0 ; k<N ; k++)
+        for (i=k+1 ; i<N ; i++)
+            if (pattern[i*N+k])
+                for (j=k+1 ; j<N ; j++)
+                    if (pattern[k*N+j])
+                        pattern[i*N+j] = true;
+
+    allocateSparse(&lu->LU, N, N, pattern);
+    free(pattern);
+
+    lu->diagonal = (int*) malloc(N*sizeof(int));
+    lu->map = (int*) malloc((A->nnz > 0 ? A->nnz : 1)*sizeof(int));
+    lu->work = (int*) malloc(N*sizeof(int));
+    for (i=0 ; i<N ; i++)
+    {
+        lu->diagonal[i] = sparsePosition(&lu->LU, i, i);
+        for (p=A->rowStart[i] ; p<A->rowStart[i+1] ; p++)
+            lu->map[p] = sparsePosition(&lu->LU, i, A->column[p]);
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Factorize the values of the sparse matrix A - diag(shift), with the pattern of sparseLUSymbolic. The shift
+// may be NULL. The rows are eliminated one at a time (IKJ order). Returns 0 on success and 1 on a zero pivot.
+// --------------------------------------------------------------------------------------------------------
+int sparseLUFactor (sparseLU *lu, const sparseMatrix *A, const double *shift)
+{
+    // Local variables
+    int i, k, p, q, N = A->rows;
+    double *LU = lu->LU.value, factor;
+    const int *rowStart = lu->LU.rowStart, *column = lu->LU.column;
+
+    for (p=0 ; p<lu->LU.nnz ; p++)
+        LU[p] = 0.0;
+    for (p=0 ; p<A->nnz ; p++)
+        LU[lu->map[p]] = A->value[p];
+    if (shift != NULL)
+        for (i=0 ; i<N ; i++)
+            LU[lu->diagonal[i]] -= shift[i];
+
+    for (i=0 ; i<N ; i++)
+    {
+        for (p=rowStart[i] ; p<rowStart[i+1] ; p++)
+            lu->work[column[p]] = p;
+
+        // Eliminate the entries of the row i below the diagonal, with the rows above it
+        for (p=rowStart[i] ; p<lu->diagonal[i] ; p++)
+        {
+            k = column[p];
+            factor = LU[p]/LU[lu->diagonal[k]];
+            LU[p] = factor;
+            for (q=lu->diagonal[k]+1 ; q<rowStart[k+1] ; q++)
+                LU[lu->work[column[q]]] -= factor*LU[q];
+        }
+
+        if (LU[lu->diagonal[i]] == 0.0 || !isfinite(LU[lu->diagonal[i]]))
+            return 1;
+    }
+
+    return 0;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the linear system (L*U)*x=b with the factors of sparseLUFactor. The solution is returned in b.
+// --------------------------------------------------------------------------------------------------------
+void sparseLUSolve (const sparseLU *lu, double *b)
+{
+    // Local variables
+    int i, p, N = lu->LU.rows;
+    const double *LU = lu->LU.value;
+    const int *rowStart = lu->LU.rowStart, *column = lu->LU.column;
+
+    // Forward substitution with the unit lower triangle
+    for (i=0 ; i<N ; i++)
+        for (p=rowStart[i] ; p<lu->diagonal[i] ; p++)
+            b[i] -= LU[p]*b[column[p]];
+
+    // Back substitution with the upper triangle
+    for (i=N-1 ; i>=0 ; i--)
+    {
+        for (p=lu->diagonal[i]+1 ; p<rowStart[i+1] ; p++)
+            b[i] -= LU[p]*b[column[p]];
+        b[i] /= LU[lu->diagonal[i]];
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Release the memory of the LU factors
+// --------------------------------------------------------------------------------------------------------
+void freeSparseLU (sparseLU *lu)
+{
+    freeSparse(&lu->LU);
+    free(lu->diagonal);
+    free(lu->map);
+    free(lu->work);
+}
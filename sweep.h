@@ -0,0 +1,271 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          sweep.h
+    Type:               header file
+    Short Description:  This file contains the parameter sweep over the input variables.
+
+Description
+===========
+Every "sweep" line of the input file gives a list of values of an input variable, e.g.
+
+    sweep p 5.0 10.0 20.0;
+    sweep Qi range 50.0 200.0 4;
+
+and the sweep solves every combination of the values. The points are solved in parallel, each one
+in its own thread, with at most sweepThreads threads at the same time (all the cores if it is zero).
+The solver state is thread-local (see variables.h), so a thread starts from a clean state: it reads
+a copy of the input file with the values of its point, which is a scratch file with a unique name
+(see scratch.h), solves it like a single simulation with its own BOLSIG+ scratch files, and stores
+the converged state in the table of the results, which is written to the file sweepOutput at the
+end. The table has a density column for every species of the mechanism, named after the species
+(ne, nH, ..., nAr+ for the argon mechanism). The last column of the table is the status of the
+solution (see convergence.h), which is 0 for a converged point, and the sweep fails if any of its
+points did not converge.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- writeSweepInput               void        Write the input file of a sweep point.
+- sweepWorker                   void*       Solve a sweep point in its own thread.
+- runSweep                      void        Solve all the sweep points in parallel and write the results table.
+
+---------------------------------------------------------------------------------------------  */
+
+// Converged state of a sweep point, with the names and the densities of all the species of its mechanism
+typedef struct
+{
+    int iterations, status, NoSpecies;
+    double n, Tg, Te;
+    char (*name)[MAXCHAR];
+    double *density;
+} sweepResult;
+
+// Results of all the points, shared by the threads (each one writes only its own point), and the number
+// of free threads
+sweepResult *sweepResults;
+sem_t sweepSlots;
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write the input file of a sweep point: a copy of input.txt where the lines of the sweep variables are
+// replaced by their values for this point, and the lines of the sweep are removed. The point number is
+// decomposed into one value index for every sweep variable, with the last variable changing fastest.
+// --------------------------------------------------------------------------------------------------------
+void writeSweepInput (int point, const char *filename)
+{
+    // Local variables
+    char line[4*MAXCHAR], name[4*MAXCHAR];
+    int l, index[MAXSWEEPS];
+    bool found[MAXSWEEPS]={false};
+    FILE *fp_in, *fp_out;
+
+    for (l=NoSweeps-1 ; l>=0 ; l--)
+    {
+        index[l] = point%NoSweepValues[l];
+        point /= NoSweepValues[l];
+    }
+
+    fp_in = fopen("input.txt","r");
+    fp_out = fopen(filename,"w");
+    if (fp_in == NULL || fp_out == NULL)
+    {
+        printf("Error: The input file of the sweep point %s cannot be written!\n",filename);
+        exit(EXIT_FAILURE);
+    }
+
+    while (fgets(line, sizeof(line), fp_in) != NULL)
+    {
+        if (sscanf(line, "%s", name) != 1 || strncmp(name,"//",2) == 0)
+        {
+            fputs(line, fp_out);
+            continue;
+        }
+
+        // The variable name may be followed directly by the semicolon
+        name[strcspn(name, ";")] = 0;
+        if (strncmp(name,"sweep",5) == 0)
+            continue;
+
+        for (l=0 ; l<NoSweeps ; l++)
+            if (strcmp(name,sweepVariable[l]) == 0)
+                break;
+        if (l < NoSweeps)
+        {
+            fprintf(fp_out, "%s %s;\n", sweepVariable[l], sweepValues[l][index[l]]);
+            found[l] = true;
+        }
+        else
+            fputs(line, fp_out);
+    }
+
+    // Sweep variables that are not in the input file
+    for (l=0 ; l<NoSweeps ; l++)
+        if (!found[l])
+            fprintf(fp_out, "%s %s;\n", sweepVariable[l], sweepValues[l][index[l]]);
+
+    fclose(fp_in);
+    fclose(fp_out);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve a sweep point in its own thread. The thread-local state of a new thread is clean, so the point
+// is solved exactly like a single simulation.
+// --------------------------------------------------------------------------------------------------------
+void *sweepWorker (void *arg)
+{
+    // Local variables
+    int l, point = *(int*) arg;
+    char filename[4*MAXCHAR], prefix[MAXCHAR];
+
+    workerId = point+1;
+    printScreenOutput = false;
+
+    // Read the input file of the point, which is a scratch file, so that the sweeps in the same directory do not
+    // overwrite the inputs of each other
+    snprintf(prefix, sizeof(prefix), "chempaig.sweep%d", point);
+    makeScratchFile(filename, sizeof(filename), prefix);
+    writeSweepInput(point, filename);
+    readfile(filename);
+    remove(filename);
+
+    initializeSimulation();
+    runSimulation();
+
+    sweepResults[point].iterations = count;
+    sweepResults[point].status = convergenceStatus;
+    sweepResults[point].n = n;
+    sweepResults[point].Tg = Tg;
+    sweepResults[point].Te = Te;
+    sweepResults[point].NoSpecies = mechanism.NoSpecies;
+    sweepResults[point].name = (char(*)[MAXCHAR]) malloc(mechanism.NoSpecies*sizeof(*sweepResults[point].name));
+    sweepResults[point].density = (double*) malloc(mechanism.NoSpecies*sizeof(double));
+    for (l=0 ; l<mechanism.NoSpecies ; l++)
+    {
+        strcpy(sweepResults[point].name[l], mechanism.name[l]);
+        sweepResults[point].density[l] = speciesDensity[l];
+    }
+
+    finalizeSimulation();
+
+    printf("Sweep point %d finished: Iterations=%d ne=%.4e nH=%.4e Tg=%.2f Te=%.2f", point, count, ne, nH, Tg, Te);
+    if (convergenceStatus != SOLUTION_CONVERGED)
+        printf(" (the solution %s)", convergenceStatusName(convergenceStatus));
+    printf("\n");
+
+    // Free the thread for the next point
+    sem_post(&sweepSlots);
+
+    return NULL;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve all the sweep points in parallel and write the results table. The convergence status of the sweep
+// is converged only if all its points converged.
+// --------------------------------------------------------------------------------------------------------
+void runSweep ()
+{
+    // Local variables
+    int l, point, NoPoints=1, NoFailed=0, threads, *points, index[MAXSWEEPS];
+    pthread_t *thread_id;
+
+    for (l=0 ; l<NoSweeps ; l++)
+        NoPoints *= NoSweepValues[l];
+
+    threads = (sweepThreads > 0) ? sweepThreads : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1)
+        threads = 1;
+
+    printf("Parameter sweep: %d points on %d threads\n\n", NoPoints, threads);
+
+    sweepResults = (sweepResult*) calloc(NoPoints, sizeof(sweepResult));
+    points = (int*) calloc(NoPoints, sizeof(int));
+    thread_id = (pthread_t*) calloc(NoPoints, sizeof(pthread_t));
+
+    // Start a new thread for every point, as soon as one of the threads is free
+    sem_init(&sweepSlots, 0, threads);
+    for (point=0 ; point<NoPoints ; point++)
+    {
+        sem_wait(&sweepSlots);
+        points[point] = point;
+        if (pthread_create(&thread_id[point], NULL, sweepWorker, &points[point]) != 0)
+        {
+            printf("Error: The thread of the sweep point %d cannot be created!\n",point);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (point=0 ; point<NoPoints ; point++)
+        pthread_join(thread_id[point], NULL);
+    sem_destroy(&sweepSlots);
+
+    // Write the results table
+    FILE * fp;
+    fp = fopen(sweepOutput,"w");
+    if (fp == NULL)
+    {
+        printf("Error: The file %s cannot be written!\n",sweepOutput);
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(fp, "# point");
+    for (l=0 ; l<NoSweeps ; l++)
+        fprintf(fp, "\t%s", sweepVariable[l]);
+    fprintf(fp, "\tIterations\tn");
+    for (l=0 ; l<sweepResults[0].NoSpecies ; l++)
+        fprintf(fp, "\tn%s", sweepResults[0].name[l]);
+    fprintf(fp, "\tTg\tTe\tStatus\n");
+
+    for (point=0 ; point<NoPoints ; point++)
+    {
+        fprintf(fp, "%d", point);
+        l = point;
+        for (i=NoSweeps-1 ; i>=0 ; i--)
+        {
+            index[i] = l%NoSweepValues[i];
+            l /= NoSweepValues[i];
+        }
+        for (l=0 ; l<NoSweeps ; l++)
+            fprintf(fp, "\t%s", sweepValues[l][index[l]]);
+        fprintf(fp, "\t%d\t%.4e", sweepResults[point].iterations, sweepResults[point].n);
+        for (l=0 ; l<sweepResults[point].NoSpecies ; l++)
+            fprintf(fp, "\t%.4e", sweepResults[point].density[l]);
+        fprintf(fp, "\t%.2f\t%.2f\t%d\n", sweepResults[point].Tg, sweepResults[point].Te, sweepResults[point].status);
+    }
+
+    fclose(fp);
+
+    printf("\nThe results of the sweep were written to the file: %s\n", sweepOutput);
+
+    // The sweep converged only if all its points converged, otherwise its status is the status of the first
+    // point that did not converge
+    convergenceStatus = SOLUTION_CONVERGED;
+    for (point=0 ; point<NoPoints ; point++)
+        if (sweepResults[point].status != SOLUTION_CONVERGED)
+        {
+            if (NoFailed == 0)
+                convergenceStatus = sweepResults[point].status;
+            NoFailed++;
+        }
+    if (NoFailed > 0)
+        logMessage(LOG_WARNING, "Warning: %d of the %d sweep points did not converge!\n", NoFailed, NoPoints);
+
+    for (point=0 ; point<NoPoints ; point++)
+    {
+        free(sweepResults[point].name);
+        free(sweepResults[point].density);
+    }
+    free(points);
+    free(thread_id);
+    free(sweepResults);
+}
@@ -0,0 +1,888 @@
+/*  ---------------------------------------------------------------------------------------------
+                                                             |
+  ____                          _____               ____     | Version: 1.0
+ //   \ ||                      ||  \\   /\    ||  //  \\    | Developers: CFD Lab,
+||      ||___   ___  _ __  ___  ||__//  // \   || ||         | High-Voltage Lab
+||      ||  \\ //__\ |/ \\// \\ ||     //===\  || ||  ====   |
+ \\___/ ||  || \\__  ||  ||  || ||    //     \ ||  \\__//    | Developed in
+                                                             |     University of Patras, Greece
+                                                             |
+-------------------------------------------------------------------------------------------------
+
+File info
+=========
+    File name:          transient.h
+    Type:               header file
+    Short Description:  This file contains the time integration of the species balance and energy
+                        equations for transient simulations (startup, flow and power steps).
+
+Description
+===========
+The line "transientTimes log 1.0e-9 0.1 81;" of the input file integrates the model in time from the
+initial values of the input file (the densities of 1e15 m-3 and Tg) up to 0.1 s, and writes the
+state at 81 times between 1e-9 s and 0.1 s to the file transientOutput. The times can also be
+given as a list, or as "linear start end points". The unknowns of the integration are those of the
+coupled Newton solver, y = {nH, nH+, nH2+, nH3+, ..., Tg}, and the equations are the same source
+terms and power terms as in the steady state:
+
+    dx/dt = S(x, Tg),   rho*V*Cp*dTg/dt = P(x, Tg)
+
+where the total density n and the gas density rho are fixed by the pressure and the initial Tg, as
+in the outer iterations. The ions react in 1e-9 to 1e-6 s while the gas heats up in milliseconds,
+so the equations are very stiff, and they are integrated with the variable-order (1 to 5) and
+variable-step BDF method of SciPy (the "BDF" method of solve_ivp, after Shampine and Reichelt,
+"The MATLAB ODE suite"). The solution is stored as the backward differences D of its interpolating
+polynomial, which are rescaled when the step changes. Every step solves the implicit BDF equations
+with simplified Newton iterations, with the Jacobian of the coupled solver (see solvers.h), which is
+only calculated again when the Newton iterations do not converge. The local error is estimated
+from the difference of the corrected and the predicted solution, and the step is rejected when its
+RMS norm, with the weights absoluteTolerance + transientTolerance*|y| (no absolute tolerance for
+Tg), is above 1. After order+1 steps of the same size, the order and the step that give the
+largest step for the error of the orders k-1, k and k+1 are chosen. The output times are
+interpolated with the polynomial of the last step (dense output), so they do not limit the step.
+
+The electrons follow the plasma state in about a nanosecond, so they are taken as quasi-steady:
+the Boltzmann equation is solved for the state of every evaluation of the derivatives, and the
+electron rate coefficients and Te are functions of the state. If they were held fixed within a
+step, they would jump from step to step, and the fast ions (H2+ in about 1e-9 s) would follow
+every jump, so the error of every step would be the jump of the rates over the tolerance. The
+Jacobian is calculated with the electron rate coefficients fixed, which only slows the simplified
+Newton iterations. The TwoTerm and Table Boltzmann solvers are best suited, since BOLSIG+ would be
+run at every evaluation, and the energy grid of the two-term solver is kept fixed as long as
+possible, so that its rate coefficients are smooth (see continuation.h).
+
+The line "transientEvent 0.05 Qi 200.0;" changes an operating condition (pin, Tgi, Qi or E, in the
+units of the input file) at the given time. The integration stops at the time of the event, the
+condition is changed and the electrons are solved again, and the integration starts again from
+the first order and a new initial step.
+
+With a pulsed power (pulseWaveform, see pulse.h), E or the absorbed power Pmw follow their waveform in
+time, and the integration starts again at the edges of a square waveform. With Pmw, every solution
+of the electrons solves for the field E at which the electrons absorb Pmw (the power of the
+electron collisions and of the ions and electrons lost to the wall), with secant iterations on
+log(E). The field then depends strongly on ne, so the Jacobian is calculated by finite differences
+of the derivatives, with the electrons of every perturbed state. integrateTransient can integrate
+the sensitivities S = dy/dy0 of the state to the initial state as well, with the same steps, which
+the shooting method of the periodic steady state needs: they are appended to the unknowns, and
+their BDF equations (I - c*J)*S = S_predict - psi are linear, so they are solved with the Jacobian
+of the end of every step, without changing the steps.
+
+Function name                   Type        Description
+=============                   ====        ===========
+- setTransientParameter         void        Set an operating condition at a transient event.
+- setTransientDrive             void        Set E or Pmw from the waveform of a pulsed power.
+- setTransientState             void        Set the plasma state from the unknowns of the integration.
+- absorbedPower                 double      Power absorbed by the electrons.
+- solvePowerField               void        Solve the Boltzmann equation for the field of the absorbed power Pmw.
+- updateTransientElectrons      void        Solve the Boltzmann equation for a state of the integration.
+- transientDerivatives          void        Calculate the time derivatives of the unknowns.
+- transientJacobian             void        Calculate the Jacobian of the time derivatives.
+- transientNorm                 double      RMS norm of a vector divided by the weights of the error.
+- initialTransientStep          double      Estimate the size of the first step.
+- transientStepMatrix           void        Calculate the matrix of the differences for a change of the step.
+- changeTransientStep           void        Rescale the backward differences for a change of the step.
+- solveTransientStep            bool        Solve the BDF equations of a step with simplified Newton iterations.
+- interpolateTransient          void        Evaluate the interpolating polynomial of the last step.
+- openTransientResults          FILE*       Open a results file of an integration and write its header.
+- writeTransientPoint           void        Write the state at an output time to the screen and to the results file.
+- integrateTransient            int         Integrate the equations between two times, with the output times between them.
+- integratePulses               int         Integrate the equations between two times, between the edges of a square waveform.
+- runTransient                  void        Integrate the model from the initial values to the last output time.
+
+---------------------------------------------------------------------------------------------  */
+
+// Largest order, simplified Newton iterations of a step, limits of the change of the step, and largest number
+// of steps of the integration
+#define TransientMaxOrder 5
+#define TransientNewtonIterations 4
+#define TransientMinFactor 0.2
+#define TransientMaxFactor 10.0
+#define TransientMaxSteps 1000000
+
+// Relative perturbation of the finite-difference Jacobian, and the iterations and the tolerance of log(power)
+// of the field of the absorbed power
+#define TransientPerturbation 1.0e-6
+#define PulseFieldIterations 30
+#define PulseFieldTolerance 1.0e-9
+
+// Heat capacity of the gas (J/K), and the counters of the integration
+THREAD_LOCAL double transientHeatCapacity;
+THREAD_LOCAL int transientSteps, transientRejected, transientJacobians, transientEvaluations;
+
+// Pulsed power: input value of the driven variable (the high level of its waveform), level of the square
+// waveform in the current segment of the integration, and the last slope of log(power) over log(E)
+THREAD_LOCAL double pulseBase, pulseSlope=2.0;
+THREAD_LOCAL bool pulseHigh=true;
+
+// Output of an integration: output times in increasing order, their number and the next one, results file,
+// verbosity level of the screen output, and the number and the sums of the rows of the results (n, ne, nH,
+// nH2, nH+, nH2+, nH3+, Tg, Te, E and the absorbed power) for their averages
+#define TransientColumns 11
+typedef struct
+{
+    const double *time;
+    int NoTimes, next;
+    FILE *fp;
+    int level;
+    int samples;
+    double sum[TransientColumns];
+} transientSampling;
+
+
+// --------------------------------------------------------------------------------------------------------
+// Set an operating condition at a transient event, in the units of the input file
+// --------------------------------------------------------------------------------------------------------
+void setTransientParameter (const char *parameter, double value)
+{
+    if (strcmp(parameter,"pin") == 0)
+        pin = value*TorrtoPa;
+    else if (strcmp(parameter,"Tgi") == 0)
+        Tgi = value;
+    else if (strcmp(parameter,"Qi") == 0)
+        Qi = value*sccmtom3s;
+    else if (strcmp(parameter,"E") == 0)
+        E = value;
+    else
+    {
+        printf("Error: The parameter %s of the transient event is not one of: pin, Tgi, Qi, E\n",parameter);
+        exit(EXIT_FAILURE);
+    }
+
+    // The new value of the driven variable of a pulsed power is the high level of its waveform
+    if (strcmp(pulseWaveform,"none") != 0 && strcmp(parameter,pulseVariable) == 0)
+        pulseBase = value;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Set the driven variable of a pulsed power (E or Pmw) at the time t: the square waveform is at the high level
+// (the input value) or at the low level (1-pulseDepth times the input value) in the current segment of the
+// integration, and the sine waveform falls from the high level at the start of the period to the low level
+// at its middle
+// --------------------------------------------------------------------------------------------------------
+void setTransientDrive (double t)
+{
+    // Local variables
+    double level;
+
+    if (strcmp(pulseWaveform,"none") == 0)
+        return;
+
+    if (strcmp(pulseWaveform,"Sine") == 0)
+        level = 1.0 - 0.5*pulseDepth*(1.0 - cos(2.0*pi*pulseFrequency*t));
+    else
+        level = pulseHigh ? 1.0 : 1.0 - pulseDepth;
+
+    if (strcmp(pulseVariable,"Pmw") == 0)
+        Pmw = level*pulseBase;
+    else
+        E = level*pulseBase;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Set the plasma state, with the densities of the previous iteration, from the unknowns y of the integration
+// --------------------------------------------------------------------------------------------------------
+void setTransientState (const double *y)
+{
+    setUnknowns(y);
+    Tg = Tg_0 = y[mechanism.NoUnknowns];
+    ne_0 = ne;
+    nH_0 = nH;
+    nH2_0 = nH2;
+    nHplus_0 = nHplus;
+    nH2plus_0 = nH2plus;
+    nH3plus_0 = nH3plus;
+    copyOtherUnknowns(speciesDensity_0);
+    calculateGasTemperatureRates();
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Power absorbed by the electrons (W): the power of the electron collisions and of the ions and electrons lost
+// to the wall, after calculatePowers
+// --------------------------------------------------------------------------------------------------------
+double absorbedPower ()
+{
+    return Pela + Pion + Pdis + Pele + Pvib + Prot + Piw + Pew;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the Boltzmann equation for the field E at which the electrons absorb the power Pmw, with secant
+// iterations on log(E) from the field and the slope of the previous solution
+// --------------------------------------------------------------------------------------------------------
+void solvePowerField ()
+{
+    // Local variables
+    int iter;
+    double logE=log(E), logE_old=0.0, residual, residual_old=0.0;
+
+    for (iter=1 ; iter<=PulseFieldIterations ; iter++)
+    {
+        solveElectronKinetics();
+        calculateElectronTemperatureRates();
+        calculatePowers();
+        residual = log(absorbedPower()/Pmw);
+        if (fabs(residual) < PulseFieldTolerance)
+            return;
+
+        if (iter > 1 && residual != residual_old)
+            pulseSlope = fmin(10.0, fmax(0.1, (residual - residual_old)/(logE - logE_old)));
+        logE_old = logE;
+        residual_old = residual;
+        logE -= residual/pulseSlope;
+        E = exp(logE);
+    }
+
+    logMessage(LOG_WARNING, "Warning: The field of the absorbed power %g W did not converge (E=%g, power=%g W)\n", Pmw, E, absorbedPower());
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Set the plasma state from the unknowns y at the time t, solve the Boltzmann equation for it (and for the
+// field of the absorbed power, if it is driven), and update Te and the rate coefficients of the electron
+// collisions
+// --------------------------------------------------------------------------------------------------------
+void updateTransientElectrons (double t, const double *y)
+{
+    setTransientDrive(t);
+    setTransientState(y);
+    if (strcmp(pulseWaveform,"none") != 0 && strcmp(pulseVariable,"Pmw") == 0)
+        solvePowerField();
+    else
+    {
+        solveElectronKinetics();
+        calculateElectronTemperatureRates();
+        gatherMechanismRates();
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Time derivatives of the unknowns y at the time t: the source terms of the species (m-3/s), and the power balance of the
+// energy equation divided by the heat capacity of the gas (K/s), with the electrons in equilibrium with y.
+// The global state is overwritten with y.
+// --------------------------------------------------------------------------------------------------------
+void transientDerivatives (double t, const double *y, double *dydt)
+{
+    // Local variables
+    int N = mechanism.NoUnknowns;
+
+    transientEvaluations++;
+    updateTransientElectrons(t, y);
+    coupledResidual(y, dydt);
+    dydt[N] /= transientHeatCapacity;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Jacobian of the time derivatives at the time t, stored row by row in J: the Jacobian of the coupled equations
+// with the electron rate coefficients of y, with the energy equation row divided by the heat capacity. With a
+// pulsed power it is calculated by finite differences of the derivatives, with the electrons (and the field)
+// of every perturbed state.
+// --------------------------------------------------------------------------------------------------------
+void transientJacobian (double t, const double *y, double *J_flat)
+{
+    // Local variables
+    int i, j, N = mechanism.NoUnknowns;
+    double (*J)[N+1] = (double (*)[N+1]) J_flat;
+    double f[N+1], f_perturbed[N+1], y_perturbed[N+1], dy;
+
+    transientJacobians++;
+    if (strcmp(pulseWaveform,"none") != 0)
+    {
+        transientDerivatives(t, y, f);
+        for (j=0 ; j<=N ; j++)
+        {
+            memcpy(y_perturbed, y, sizeof(y_perturbed));
+            dy = TransientPerturbation*fabs(y[j]) + ((j < N) ? absoluteTolerance : 0.0);
+            y_perturbed[j] += dy;
+            transientDerivatives(t, y_perturbed, f_perturbed);
+            for (i=0 ; i<=N ; i++)
+                J[i][j] = (f_perturbed[i] - f[i])/dy;
+        }
+        return;
+    }
+
+    updateTransientElectrons(t, y);
+    coupledJacobian(y, J_flat);
+    for (j=0 ; j<=N ; j++)
+        J[N][j] /= transientHeatCapacity;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// RMS norm of the vector x divided by the weights of the error
+// --------------------------------------------------------------------------------------------------------
+double transientNorm (int M, const double *x, const double *scale)
+{
+    // Local variables
+    int l;
+    double sum=0.0;
+
+    for (l=0 ; l<M ; l++)
+        sum += (x[l]/scale[l])*(x[l]/scale[l]);
+
+    return sqrt(sum/M);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Estimate the size of the first step from the derivatives f at the time t and y, and from their change after a small
+// explicit step, so that the error of the first (first-order) step is about 1% of the tolerance. The step is
+// at most the interval of the integration.
+// --------------------------------------------------------------------------------------------------------
+double initialTransientStep (int M, double t, const double y[M], const double f[M], const double scale[M], double interval)
+{
+    // Local variables
+    int l;
+    double y1[M], f1[M], d0, d1, d2, h0, h1;
+
+    d0 = transientNorm(M, y, scale);
+    d1 = transientNorm(M, f, scale);
+    h0 = (d0 < 1.0e-5 || d1 < 1.0e-5) ? 1.0e-6 : 0.01*d0/d1;
+    h0 = fmin(h0, interval);
+
+    memset(y1, 0, sizeof(y1));
+    for (l=0 ; l<M ; l++)
+        y1[l] = y[l] + h0*f[l];
+    transientDerivatives(t + h0, y1, f1);
+    for (l=0 ; l<M ; l++)
+        f1[l] -= f[l];
+    d2 = transientNorm(M, f1, scale)/h0;
+
+    if (!isfinite(d2))
+        h1 = 1.0e-3*h0;
+    else if (d1 <= 1.0e-15 && d2 <= 1.0e-15)
+        h1 = fmax(1.0e-6, 1.0e-3*h0);
+    else
+        h1 = sqrt(0.01/fmax(d1, d2));
+
+    return fmin(fmin(100.0*h0, h1), interval);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Matrix R of the backward differences of order for a change of the step by factor:
+// R[i][j] = prod_{m=1..i} (m-1-factor*j)/m, with R[0][j] = 1
+// --------------------------------------------------------------------------------------------------------
+void transientStepMatrix (int order, double factor, double R[order+1][order+1])
+{
+    // Local variables
+    int i, j;
+
+    for (j=0 ; j<=order ; j++)
+        R[0][j] = 1.0;
+    for (i=1 ; i<=order ; i++)
+    {
+        R[i][0] = 0.0;
+        for (j=1 ; j<=order ; j++)
+            R[i][j] = R[i-1][j]*(i-1-factor*j)/i;
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Rescale the backward differences D[0..order] of the interpolating polynomial for a change of the step by
+// factor: D = (R*U)'*D, where U is R for a factor of 1
+// --------------------------------------------------------------------------------------------------------
+void changeTransientStep (int M, double D[][M], int order, double factor)
+{
+    // Local variables
+    int i, j, l;
+    double R[order+1][order+1], U[order+1][order+1], RU[order+1][order+1], D_new[order+1][M];
+
+    transientStepMatrix(order, factor, R);
+    transientStepMatrix(order, 1.0, U);
+    for (i=0 ; i<=order ; i++)
+        for (j=0 ; j<=order ; j++)
+        {
+            RU[i][j] = 0.0;
+            for (l=0 ; l<=order ; l++)
+                RU[i][j] += R[i][l]*U[l][j];
+        }
+
+    for (i=0 ; i<=order ; i++)
+        for (l=0 ; l<M ; l++)
+        {
+            D_new[i][l] = 0.0;
+            for (j=0 ; j<=order ; j++)
+                D_new[i][l] += RU[j][i]*D[j][l];
+        }
+    memcpy(D, D_new, sizeof(D_new));
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Solve the BDF equations of a step that ends at the time t, y - c*f(t,y) - y_predict + psi = 0 with c = h/alpha, with simplified Newton
+// iterations on the matrix I - c*J. The iterations stop when the estimated error of the solution is below tol,
+// or when their rate of convergence shows that it will not be reached. On return, y is the solution, d is the
+// correction y - y_predict and iterations is the number of the iterations. Returns true if they converged.
+// --------------------------------------------------------------------------------------------------------
+bool solveTransientStep (int M, double t, const double y_predict[M], double c, const double psi[M], double J[M][M], const double scale[M], double tol,
+                         double y[M], double d[M], int *iterations)
+{
+    // Local variables
+    int i, j, iter;
+    double A[M][M], f[M], dy[M], dy_norm, dy_norm_old=0.0, rate=-1.0;
+
+    for (i=0 ; i<M ; i++)
+    {
+        y[i] = y_predict[i];
+        d[i] = 0.0;
+    }
+
+    for (iter=0 ; iter<TransientNewtonIterations ; iter++)
+    {
+        *iterations = iter+1;
+        transientDerivatives(t, y, f);
+        for (i=0 ; i<M ; i++)
+            if (!isfinite(f[i]))
+                return false;
+
+        for (i=0 ; i<M ; i++)
+        {
+            for (j=0 ; j<M ; j++)
+                A[i][j] = (i == j) - c*J[i][j];
+            dy[i] = c*f[i] - psi[i] - d[i];
+        }
+        if (solveLinearSystem(M, A, dy) != 0)
+            return false;
+
+        dy_norm = transientNorm(M, dy, scale);
+        if (iter > 0)
+        {
+            rate = dy_norm/dy_norm_old;
+            if (rate >= 1.0 || pow(rate, TransientNewtonIterations-iter)/(1.0-rate)*dy_norm > tol)
+                return false;
+        }
+
+        for (i=0 ; i<M ; i++)
+        {
+            y[i] += dy[i];
+            d[i] += dy[i];
+        }
+
+        if (dy_norm == 0.0 || (iter > 0 && rate/(1.0-rate)*dy_norm < tol))
+            return true;
+        dy_norm_old = dy_norm;
+    }
+
+    return false;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Evaluate at the time t_out the interpolating polynomial of the step that ended at t, with the step h, the
+// order and the backward differences D of the step
+// --------------------------------------------------------------------------------------------------------
+void interpolateTransient (int M, double D[][M], int order, double t, double h, double t_out, double y[M])
+{
+    // Local variables
+    int j, l;
+    double product=1.0;
+
+    for (l=0 ; l<M ; l++)
+        y[l] = D[0][l];
+    for (j=0 ; j<order ; j++)
+    {
+        product *= (t_out - (t - h*j))/(h*(j+1));
+        for (l=0 ; l<M ; l++)
+            y[l] += D[j+1][l]*product;
+    }
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Open the results file of an integration and write the header of its columns
+// --------------------------------------------------------------------------------------------------------
+FILE *openTransientResults (const char *fileName)
+{
+    FILE * fp;
+    fp = fopen(fileName,"w");
+    if (fp == NULL)
+    {
+        printf("Error: The file %s cannot be written!\n",fileName);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(fp, "# t\tSteps\tOrder\tn\tne\tnH\tnH2\tnH+\tnH2+\tnH3+\tTg\tTe\tE\tPabs\n");
+
+    return fp;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Write the state y at the output time t to the screen and to the results file of out, and add it to the sums
+// of the averages
+// --------------------------------------------------------------------------------------------------------
+void writeTransientPoint (transientSampling *out, double t, const double *y, int order)
+{
+    // Local variables
+    int l;
+    double column[TransientColumns];
+
+    updateTransientElectrons(t, y);
+    calculatePowers();
+
+    column[0] = n;
+    column[1] = ne;
+    column[2] = nH;
+    column[3] = nH2;
+    column[4] = nHplus;
+    column[5] = nH2plus;
+    column[6] = nH3plus;
+    column[7] = Tg;
+    column[8] = Te;
+    column[9] = E;
+    column[10] = absorbedPower();
+
+    fprintf(out->fp, "%.6e\t%d\t%d", t, transientSteps, order);
+    for (l=0 ; l<TransientColumns ; l++)
+    {
+        fprintf(out->fp, (l == 7 || l == 8) ? "\t%.2f" : "\t%.4e", column[l]);
+        out->sum[l] += column[l];
+    }
+    fprintf(out->fp, "\n");
+    fflush(out->fp);
+    out->samples++;
+
+    logMessage(out->level, "Time %.4e s: Steps=%d Order=%d ne=%.4e nH=%.4e nH+=%.4e nH3+=%.4e Tg=%.2f Te=%.2f\n", t, transientSteps, order,
+               ne, nH, nHplus, nH3plus, Tg, Te);
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Integrate the equations from the time *t to t_end, starting from the state y with the first order, and
+// write the output times of out up to t_end. If S is not NULL, the sensitivities S = dy/dy0 (M x M, row by
+// row) are integrated with the state. On return, *t, y and S are the time, the state and the sensitivities
+// of the last step. Returns 0 on success, and 1 if the step became too small or the largest number of steps
+// was reached.
+// --------------------------------------------------------------------------------------------------------
+int integrateTransient (int M, double y[M], double *S, double *t, double t_end, transientSampling *out)
+{
+    // Local variables
+    const double kappa[TransientMaxOrder+1] = {0.0, -0.1850, -1.0/9.0, -0.0823, -0.0415, 0.0};
+    const int W = (S != NULL) ? M*(M+1) : M;
+    int i, j, k, l, order, equalSteps, iterations, newOrder;
+    double gamma[TransientMaxOrder+1], alpha[TransientMaxOrder+1], errorConstant[TransientMaxOrder+1];
+    double D[TransientMaxOrder+3][W], J[M][M], A[M][M], A_step[M][M], f[M], b[M], scale[M], error[M];
+    double y_predict[W], y_new[W], d[W], psi[W], y_out[W];
+    double h, t_new, c, minStep, newtonTolerance, safety, errorNorm, factor, errorNorms[3], factors[3];
+    bool converged, accepted;
+
+    // Coefficients of the BDF formulas with the NDF modification kappa
+    gamma[0] = 0.0;
+    for (l=1 ; l<=TransientMaxOrder ; l++)
+        gamma[l] = gamma[l-1] + 1.0/l;
+    for (l=0 ; l<=TransientMaxOrder ; l++)
+    {
+        alpha[l] = (1.0 - kappa[l])*gamma[l];
+        errorConstant[l] = kappa[l]*gamma[l] + 1.0/(l+1);
+    }
+    newtonTolerance = fmax(10.0*DBL_EPSILON/transientTolerance, fmin(0.03, sqrt(transientTolerance)));
+
+    // First step, with the first order. The sensitivities are stored after the state in the backward
+    // differences, and their derivatives are J*S.
+    transientDerivatives(*t, y, f);
+    memset(scale, 0, sizeof(scale));
+    for (l=0 ; l<M ; l++)
+        scale[l] = ((l < M-1) ? absoluteTolerance : 0.0) + transientTolerance*fabs(y[l]);
+    h = initialTransientStep(M, *t, y, f, scale, t_end - *t);
+    transientJacobian(*t, y, &J[0][0]);
+    memset(D, 0, sizeof(D));
+    for (l=0 ; l<M ; l++)
+    {
+        D[0][l] = y[l];
+        D[1][l] = h*f[l];
+    }
+    if (S != NULL)
+        for (i=0 ; i<M ; i++)
+            for (j=0 ; j<M ; j++)
+            {
+                D[0][M+i*M+j] = S[i*M+j];
+                for (k=0 ; k<M ; k++)
+                    D[1][M+i*M+j] += h*J[i][k]*S[k*M+j];
+            }
+    order = 1;
+    equalSteps = 0;
+
+    while (*t < t_end)
+    {
+        // An error of a solver in the evaluations of the equations stops the integration (see solverError)
+        if (solverFailed)
+            return 1;
+
+        if (transientSteps >= TransientMaxSteps)
+        {
+            logMessage(LOG_WARNING, "Warning: The transient integration reached %d steps at t=%.4e s\n", TransientMaxSteps, *t);
+            return 1;
+        }
+
+        profileStart(PROFILE_TRANSIENT);
+        minStep = 10.0*fabs(nextafter(*t, INFINITY) - *t);
+        if (h < minStep)
+        {
+            changeTransientStep(W, D, order, minStep/h);
+            h = minStep;
+            equalSteps = 0;
+        }
+
+        accepted = false;
+        while (!accepted)
+        {
+            if (h < minStep)
+            {
+                profileStop(PROFILE_TRANSIENT);
+                logMessage(LOG_WARNING, "Warning: The transient integration stopped at t=%.4e s, the step became too small\n", *t);
+                return 1;
+            }
+
+            // The last step ends at t_end
+            t_new = *t + h;
+            if (t_new > t_end)
+            {
+                t_new = t_end;
+                changeTransientStep(W, D, order, (t_end - *t)/h);
+                equalSteps = 0;
+            }
+            h = t_new - *t;
+
+            // Predictor from the interpolating polynomial, and the history term of the BDF formula
+            for (l=0 ; l<W ; l++)
+            {
+                y_predict[l] = 0.0;
+                psi[l] = 0.0;
+                for (i=0 ; i<=order ; i++)
+                    y_predict[l] += D[i][l];
+                for (i=1 ; i<=order ; i++)
+                    psi[l] += D[i][l]*gamma[i];
+                psi[l] /= alpha[order];
+            }
+            for (l=0 ; l<M ; l++)
+                scale[l] = ((l < M-1) ? absoluteTolerance : 0.0) + transientTolerance*fabs(y_predict[l]);
+
+            // Corrector, with the Jacobian of the previous steps and then with the Jacobian of the predictor
+            c = h/alpha[order];
+            converged = solveTransientStep(M, t_new, y_predict, c, psi, J, scale, newtonTolerance, y_new, d, &iterations);
+            if (!converged)
+            {
+                transientJacobian(t_new, y_predict, &J[0][0]);
+                converged = solveTransientStep(M, t_new, y_predict, c, psi, J, scale, newtonTolerance, y_new, d, &iterations);
+            }
+            profileCount(PROFILE_TRANSIENT, iterations);
+
+            if (!converged)
+            {
+                transientRejected++;
+                h *= 0.5;
+                changeTransientStep(W, D, order, 0.5);
+                equalSteps = 0;
+                continue;
+            }
+
+            // Local error of the step
+            safety = 0.9*(2*TransientNewtonIterations + 1)/(2*TransientNewtonIterations + iterations);
+            for (l=0 ; l<M ; l++)
+            {
+                scale[l] = ((l < M-1) ? absoluteTolerance : 0.0) + transientTolerance*fabs(y_new[l]);
+                error[l] = errorConstant[order]*d[l];
+            }
+            errorNorm = transientNorm(M, error, scale);
+
+            if (errorNorm > 1.0)
+            {
+                transientRejected++;
+                factor = fmax(TransientMinFactor, safety*pow(errorNorm, -1.0/(order+1)));
+                h *= factor;
+                changeTransientStep(W, D, order, factor);
+                equalSteps = 0;
+            }
+            else
+                accepted = true;
+        }
+
+        // Sensitivities of the step: (I - c*J)*dS = c*J*S_predict - psi, column by column, with the Jacobian at
+        // the end of the step, which is also used by the next steps
+        if (S != NULL)
+        {
+            transientJacobian(t_new, y_new, &J[0][0]);
+            for (i=0 ; i<M ; i++)
+                for (k=0 ; k<M ; k++)
+                    A_step[i][k] = (i == k) - c*J[i][k];
+            for (j=0 ; j<M ; j++)
+            {
+                for (i=0 ; i<M ; i++)
+                {
+                    b[i] = -psi[M+i*M+j];
+                    for (k=0 ; k<M ; k++)
+                        b[i] += c*J[i][k]*y_predict[M+k*M+j];
+                }
+                memcpy(A, A_step, sizeof(A));
+                if (solveLinearSystem(M, A, b) != 0)
+                {
+                    profileStop(PROFILE_TRANSIENT);
+                    logMessage(LOG_WARNING, "Warning: The sensitivities of the transient integration are singular at t=%.4e s\n", t_new);
+                    return 1;
+                }
+                for (i=0 ; i<M ; i++)
+                {
+                    d[M+i*M+j] = b[i];
+                    y_new[M+i*M+j] = y_predict[M+i*M+j] + b[i];
+                    S[i*M+j] = y_new[M+i*M+j];
+                }
+            }
+        }
+
+        transientSteps++;
+        equalSteps++;
+        *t = t_new;
+        for (l=0 ; l<M ; l++)
+            y[l] = y_new[l];
+
+        // Backward differences of the new step: d is the difference of order+1 of the step
+        for (l=0 ; l<W ; l++)
+        {
+            D[order+2][l] = d[l] - D[order+1][l];
+            D[order+1][l] = d[l];
+            for (i=order ; i>=0 ; i--)
+                D[i][l] += D[i+1][l];
+        }
+
+        // After order+1 steps of the same size, choose the order (k-1, k or k+1) that allows the largest step
+        if (equalSteps >= order+1)
+        {
+            for (l=0 ; l<M ; l++)
+                error[l] = (order > 1) ? errorConstant[order-1]*D[order][l] : 0.0;
+            errorNorms[0] = (order > 1) ? transientNorm(M, error, scale) : INFINITY;
+            errorNorms[1] = errorNorm;
+            for (l=0 ; l<M ; l++)
+                error[l] = (order < TransientMaxOrder) ? errorConstant[order+1]*D[order+2][l] : 0.0;
+            errorNorms[2] = (order < TransientMaxOrder) ? transientNorm(M, error, scale) : INFINITY;
+
+            newOrder = 0;
+            for (i=0 ; i<3 ; i++)
+            {
+                factors[i] = pow(errorNorms[i], -1.0/(order+i));
+                if (factors[i] > factors[newOrder])
+                    newOrder = i;
+            }
+            factor = fmin(TransientMaxFactor, safety*factors[newOrder]);
+            order += newOrder - 1;
+            h *= factor;
+            changeTransientStep(W, D, order, factor);
+            equalSteps = 0;
+        }
+        profileStop(PROFILE_TRANSIENT);
+
+        // Output times of the step, from the polynomial of the step that ended at t
+        for ( ; out->next < out->NoTimes && out->time[out->next] <= *t ; out->next++)
+        {
+            interpolateTransient(W, D, order, *t, h, out->time[out->next], y_out);
+            writeTransientPoint(out, out->time[out->next], y_out, order);
+        }
+    }
+
+    return 0;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Integrate the equations from the time *t to t_end as integrateTransient, in segments between the edges of
+// the square waveform of a pulsed power, where the integration starts again from the first order. The times
+// within 1e-9 periods of an edge belong to the next level.
+// --------------------------------------------------------------------------------------------------------
+int integratePulses (int M, double y[M], double *S, double *t, double t_end, transientSampling *out)
+{
+    // Local variables
+    int failed=0;
+    double period, cycle, t_stop;
+
+    if (strcmp(pulseWaveform,"Square") != 0)
+        return integrateTransient(M, y, S, t, t_end, out);
+
+    period = 1.0/pulseFrequency;
+    while (!failed && *t < t_end)
+    {
+        cycle = floor(*t/period + 1.0e-9);
+        pulseHigh = (*t/period - cycle < pulseDutyCycle - 1.0e-9);
+        t_stop = fmin(t_end, (cycle + (pulseHigh ? pulseDutyCycle : 1.0))*period);
+        failed = integrateTransient(M, y, S, t, t_stop, out);
+    }
+
+    return failed;
+}
+
+
+// --------------------------------------------------------------------------------------------------------
+// Integrate the model from the initial values of the input file to the last output time, with the transient
+// events between them
+// --------------------------------------------------------------------------------------------------------
+void runTransient ()
+{
+    // Local variables
+    int N, event=0, failed=0;
+    double t=0.0, t_stop, t_end = transientTime[NoTransientTimes-1];
+    transientSampling out = {transientTime, NoTransientTimes, 0, NULL, LOG_ITERATION, 0, {0.0}};
+
+    // The unknowns are known after the mechanism is read
+    initializeSimulation();
+    profileStart(PROFILE_SOLUTION);
+    N = mechanism.NoUnknowns;
+
+    double y[N+1];
+    getUnknowns(y, true);
+    y[N] = Tg_0;
+    transientHeatCapacity = rho*V*Cp;
+    transientSteps = transientRejected = transientJacobians = transientEvaluations = 0;
+    pulseBase = (strcmp(pulseVariable,"Pmw") == 0) ? Pmw : E;
+    out.fp = openTransientResults(transientOutput);
+
+    logMessage(LOG_SUMMARY, "Transient simulation from 0 to %g s\n\n", t_end);
+
+    // The rate coefficients of the two-term Boltzmann solver are smooth functions of the state with a fixed grid
+    EEDFfixedGrid = true;
+
+    while (!failed && t < t_end)
+    {
+        // Transient events at the current time
+        for ( ; event < NoTransientEvents && transientEventTime[event] <= t ; event++)
+        {
+            setTransientParameter(transientEventParameter[event], transientEventValue[event]);
+            if (t > 0.0)
+                logMessage(LOG_ITERATION, "Transient event at t=%.4e s: %s=%g\n", t, transientEventParameter[event], transientEventValue[event]);
+        }
+
+        // Output times at the start of the integration
+        for ( ; out.next < NoTransientTimes && transientTime[out.next] <= t ; out.next++)
+            writeTransientPoint(&out, transientTime[out.next], y, 1);
+
+        // Integrate up to the next event
+        t_stop = (event < NoTransientEvents && transientEventTime[event] < t_end) ? transientEventTime[event] : t_end;
+        failed = integratePulses(N+1, y, NULL, &t, t_stop, &out);
+    }
+
+    fclose(out.fp);
+    profileStop(PROFILE_SOLUTION);
+
+    // Final state of the integration
+    updateTransientElectrons(t, y);
+    calculatePowers();
+    count = transientSteps;
+    if (solverFailed)
+        convergenceStatus = SOLUTION_FAILED;
+    else
+        convergenceStatus = failed ? SOLUTION_DIVERGED : SOLUTION_CONVERGED;
+
+    if (logEnabled(LOG_SUMMARY))
+    {
+        printf("\nTransient integration: %d steps (%d rejected), %d evaluations and %d Jacobians of the equations\n", transientSteps, transientRejected,
+               transientEvaluations, transientJacobians);
+        printf("The results of the transient simulation were written to the file: %s\n\n", transientOutput);
+        printScreen_K_Ethr();
+        printScreen_finalResults();
+        printOtherSpecies();
+    }
+
+    finalizeSimulation();
+}
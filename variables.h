@@ -18,6 +18,10 @@ File info
 
 ---------------------------------------------------------------------------------------------  */
 
+// Every global variable is local to the thread that uses it, so that the points of a parameter
+// sweep can be solved in parallel (see sweep.h), each one with its own copy of the solver state
+#define THREAD_LOCAL _Thread_local
+
 // Physical constants
 #define pi 3.14159
 #define kB 1.3806503e-23
@@ -27,6 +31,7 @@ File info
 #define e 1.602176565e-19
 #define me 9.1094e-31
 #define mp 1.6726e-27
+#define eps0 8.8541878e-12
 #define mH mp
 #define mH2 2*mp
 #define mH3 3*mp
@@ -44,45 +49,166 @@ File info
 #define Vm2toTd 1.0e+21
 
 // Spiecies concentration - volume averaged
-double n, ne, nH, nH2, nHplus, nH2plus, nH3plus;
-double ne_0, nH_0, nH2_0, nHplus_0, nH2plus_0, nH3plus_0;
-double ne_old, nH_old, nH2_old, nHplus_old, nH2plus_old, nH3plus_old;
+THREAD_LOCAL double n, ne, nH, nH2, nHplus, nH2plus, nH3plus;
+THREAD_LOCAL double ne_0, nH_0, nH2_0, nHplus_0, nH2plus_0, nH3plus_0;
+THREAD_LOCAL double ne_old, nH_old, nH2_old, nHplus_old, nH2plus_old, nH3plus_old;
+
+// Densities of all the species of the reaction mechanism, in its order (see mechanism.h). The previous inner
+// (_0) and outer (_old) iterations are used for the species that are not variables of the hydrogen model.
+// The total density of the neutral species and the composition of the neutral species of the cross-section
+// file are passed to the Boltzmann solvers.
+THREAD_LOCAL double *speciesDensity, *speciesDensity_0, *speciesDensity_old;
+THREAD_LOCAL double nNeutral, *neutralFraction;
 
 // Errors
-double err_e, err_H, err_H2, err_Hplus, err_H2plus, err_H3plus, err_Tg, err_Te;
+THREAD_LOCAL double err_e, err_H, err_H2, err_Hplus, err_H2plus, err_H3plus, err_other, err_Tg, err_Te;
 
 // Rate constants and threshold energies
 // These are 2D arrays, rows are the number of reactions, columns are the subreactions
 // of each reaction. If a reaction does not have any subreactions then the value is stored 
 // in the zeroth column. The K[0][..] and Ethr[0][..] values are not used.
-double **K, **Ethr;
+THREAD_LOCAL double **K, **Ethr;
 
 // State variables
-double p, pin, patm, Tg, Te, Tgi, Tatm, rhoi, rho;
-double Tg_0, Tg_old, Te_old;
+THREAD_LOCAL double p, pin, patm, Tg, Te, Tgi, Tatm, rhoi, rho;
+THREAD_LOCAL double Tg_0, Tg_old, Te_old;
 
 // Power palance terms
-double PinletHeat, Pmw, Piw, Pew, Pela, Pion, Pdis, Pele, Pvib, Prot, PDH12, PDH13, PDH14;
+THREAD_LOCAL double PinletHeat, Pmw, Piw, Pew, Pela, Pion, Pdis, Pele, Pvib, Prot, Pchem;
 
 // Geometric variables
-double R, L, V, Ai;
+THREAD_LOCAL double R, L, V, Ai;
 
 // Other variables
-double Gamma, uB, ns, M, Q, Qi, Cp, h, epsilon, E, freq, DH12, DH13, DH14, RH2;
-double r1, r2, r3, r4;
+THREAD_LOCAL double uB, ns, M, Q, Qi, Cp, h, epsilon, E, freq, RH2;
+THREAD_LOCAL double r1, r2, r3, r4;
 
 // Auxiliary programming variables
 #define MAXCHAR 150
-char str[MAXCHAR];
-int **map_reactions;
-int i=0, j=0, k=0, count=0, count_SB=0, count_Tg=0, count_Te=0, count_BOLSIG=0;
-int react_num, subreact_num;
-char neutralSpecies[15][MAXCHAR]={0};
-int NoNeutralSpecies;
-bool printScreenK, printScreenEthr;
+THREAD_LOCAL char str[MAXCHAR];
+THREAD_LOCAL int **map_reactions;
+THREAD_LOCAL int i=0, j=0, k=0, count=0, count_SB=0, count_Tg=0, count_Te=0, count_BOLSIG=0;
+THREAD_LOCAL int react_num, subreact_num;
+THREAD_LOCAL char (*neutralSpecies)[MAXCHAR]=NULL;
+THREAD_LOCAL int NoNeutralSpecies;
+THREAD_LOCAL bool printScreenK, printScreenEthr;
 
 // BOLSIG+ file names
-char BOLSIG_input[MAXCHAR];
-char BOLSIG_output[MAXCHAR];
-char BOLSIG_crossSections[MAXCHAR];
+THREAD_LOCAL char BOLSIG_input[MAXCHAR];
+THREAD_LOCAL char BOLSIG_output[MAXCHAR];
+THREAD_LOCAL char BOLSIG_crossSections[MAXCHAR];
+THREAD_LOCAL char BOLSIG_cache[MAXCHAR];
+THREAD_LOCAL char mechanismFile[MAXCHAR]="mechanism.txt";
+
+// Speculative BOLSIG+ runs for the predicted conditions of the next iterations: tolerance of the conditions
+// (0 = no speculative runs) and number of iterations ahead
+#define MAXSPECULATIONDEPTH 8
+THREAD_LOCAL double BOLSIG_speculation=0.0;
+THREAD_LOCAL int BOLSIG_speculationDepth=1;
+
+// Timers of the phases of the solution (see profiler.h): JSON summary and Chrome trace files (none = off)
+THREAD_LOCAL char profileOutput[MAXCHAR]="none", profileTrace[MAXCHAR]="none";
+
+
+// Numerical solvers, and variables of the species balance solvers (Linear densities or Log of the densities)
+THREAD_LOCAL char speciesSolver[MAXCHAR], energySolver[MAXCHAR], boltzmannSolver[MAXCHAR];
+THREAD_LOCAL char densityVariables[MAXCHAR]="Linear";
+
+// Convergence control of the iterations (see convergence.h): relaxation of the SOR solvers (Fixed or Adaptive),
+// relative tolerance of the unknowns and Tg, absolute tolerance of the densities [m-3], relative tolerances of
+// single species, limits of the outer and SOR iterations, and outer iterations without progress (0 = no limit)
+#define MAXSPECIESTOLERANCES 16
+THREAD_LOCAL char relaxationMethod[MAXCHAR]="Adaptive";
+THREAD_LOCAL double convergenceTolerance=1.0e-8, absoluteTolerance=1.0;
+THREAD_LOCAL int NoSpeciesTolerances=0;
+THREAD_LOCAL char speciesToleranceName[MAXSPECIESTOLERANCES][MAXCHAR];
+THREAD_LOCAL double speciesToleranceValue[MAXSPECIESTOLERANCES];
+THREAD_LOCAL int maxIterations=500, maxInnerIterations=100000, stagnationIterations=20;
+
+// Anderson acceleration of the outer iterations
+THREAD_LOCAL int andersonDepth, count_AA=0;
+THREAD_LOCAL double **andersonU, **andersonG, *andersonU_last;
+
+// Reaction index of the cross-section file, which is read once at startup
+typedef struct
+{
+    char type[MAXCHAR];         // ELASTIC, EFFECTIVE, EXCITATION, IONIZATION or ATTACHMENT
+    int species;                // Index of the target in the neutralSpecies array
+    int reaction, subreaction;  // Position of the rate coefficient in the K and Ethr arrays
+    double param;               // Threshold energy (eV) or electron/neutral mass ratio
+    int points;                 // Number of points of the cross-section table
+    double *energy, *crossSec;  // Cross-section table (eV, m2)
+} collisionProcess;
+
+// collisionIndex gives the position of each reaction/subreaction in the collisions array (-1 if it is not in the file)
+THREAD_LOCAL collisionProcess *collisions;
+THREAD_LOCAL int NoCollisions=0, **collisionIndex;
+
+// Results of the BOLSIG+ output file. The transport coefficients are multiplied or divided by the gas density
+// N as in BOLSIG+, and the rate coefficients (m3/s) and threshold energies (eV) are in the order of the output
+// file, from 1 to count_BOLSIG-1.
+typedef struct
+{
+    double meanEnergy, mobility, diffusion, energyMobility, energyDiffusion;
+    double collisionFrequency, momentumFrequency, ionizationFrequency;
+    double power, elasticPower, inelasticPower, growthPower;
+    double coulombLogarithm, maxEnergy, iterations, maxIterations;
+    double *rate, *threshold;
+} bolsigResults;
+
+THREAD_LOCAL bolsigResults bolsig;
+
+// Print the progress and the results of the simulation on the screen (disabled for the points of a sweep,
+// which print only their warnings). The verbosity levels of the messages are (see logMessage): 0 = errors
+// only, 1 = warnings, 2 = summary of the solution, 3 = outer iterations, 4 = details of the solvers.
+#define LOG_ERROR 0
+#define LOG_WARNING 1
+#define LOG_SUMMARY 2
+#define LOG_ITERATION 3
+#define LOG_DEBUG 4
+THREAD_LOCAL bool printScreenOutput=true;
+THREAD_LOCAL int verbosity=LOG_ITERATION;
+
+// Error of a solver during the current solution (see solverError), which stops its outer iterations, and
+// number of the warnings of the thread, also of those that are not printed (see logMessage)
+THREAD_LOCAL bool solverFailed=false;
+THREAD_LOCAL int warningCount=0;
+
+// Convergence history of the outer iterations (see convergenceHistory.h): file (none = off) and format
+THREAD_LOCAL char historyOutput[MAXCHAR]="none", historyFormat[MAXCHAR]="CSV";
+
+// Parameter sweep over the input variables. These variables are shared by all the threads and they are
+// only written by the main thread, while the input file is read. workerId is zero in the main thread and
+// the number of the sweep point plus one in the threads of the sweep.
+#define MAXSWEEPS 10
+#define MAXSWEEPVALUES 100
+int NoSweeps=0, sweepThreads=0, NoSweepValues[MAXSWEEPS];
+char sweepVariable[MAXSWEEPS][MAXCHAR], sweepValues[MAXSWEEPS][MAXSWEEPVALUES][MAXCHAR];
+char sweepOutput[MAXCHAR]="sweepResults.dat";
+THREAD_LOCAL int workerId=0;
+
+// Continuation of the solution along an operating parameter (see continuation.h)
+THREAD_LOCAL bool useContinuation=false;
+THREAD_LOCAL char continuationParameter[MAXCHAR], continuationMethod[MAXCHAR]="Arclength";
+THREAD_LOCAL char continuationOutput[MAXCHAR]="continuationResults.dat";
+THREAD_LOCAL double continuationStart, continuationEnd, continuationStep;
+
+// Transient simulation (see transient.h): output times [s] in increasing order (the last one is the end time),
+// relative tolerance of the time integration, results file, and step changes of the operating conditions
+// (transient events) at given times
+#define MAXTRANSIENTTIMES 1000
+#define MAXTRANSIENTEVENTS 20
+THREAD_LOCAL int NoTransientTimes=0, NoTransientEvents=0;
+THREAD_LOCAL double transientTime[MAXTRANSIENTTIMES], transientTolerance=1.0e-6;
+THREAD_LOCAL char transientOutput[MAXCHAR]="transientResults.dat";
+THREAD_LOCAL double transientEventTime[MAXTRANSIENTEVENTS], transientEventValue[MAXTRANSIENTEVENTS];
+THREAD_LOCAL char transientEventParameter[MAXTRANSIENTEVENTS][MAXCHAR];
 
+// Pulsed power (see pulse.h): waveform (none, Square or Sine) of the driven variable (E, or Pmw the absorbed
+// power [W]), frequency [Hz], fraction of the period at the high level of the square waveform, depth of the
+// modulation (the low level is 1-depth times the input value), limits of the shooting iterations of the
+// periodic steady state, samples of the period and results file
+THREAD_LOCAL char pulseWaveform[MAXCHAR]="none", pulseVariable[MAXCHAR]="E";
+THREAD_LOCAL double pulseFrequency=1.0e3, pulseDutyCycle=0.5, pulseDepth=0.1, pulseTolerance=1.0e-4;
+THREAD_LOCAL int pulseIterations=20, pulseSamples=100;
+THREAD_LOCAL char pulseOutput[MAXCHAR]="pulseResults.dat";